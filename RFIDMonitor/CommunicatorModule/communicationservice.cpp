@@ -95,18 +95,22 @@ void CommunicationService::ipcDisconnected()
 
 void CommunicationService::ipcReadyRead()
 {
-    QByteArray data = m_localSocket->readAll();
-
-    json::NodeJSMessage nodeMessage;
-
-    nodeMessage.read(QJsonDocument::fromJson(data).object());
-    QString messageType(nodeMessage.type());
-
-    if(messageType == "ACK-SYN"){
-        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("CommunicationService -> Connected successfully to IPC Server."));
-    }
-    else{
-        emit messageReceived(data);
+    m_buffer.append(m_localSocket->readAll());
+
+    // The messages that arrive together are split and handled one by one, a message cut anywhere waits for the rest
+    QByteArray data;
+    while(!(data = json::NodeJSMessage::takeDocument(m_buffer)).isEmpty()){
+        json::NodeJSMessage nodeMessage;
+
+        nodeMessage.read(QJsonDocument::fromJson(data).object());
+        QString messageType(nodeMessage.type());
+
+        if(messageType == "ACK-SYN"){
+            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("CommunicationService -> Connected successfully to IPC Server."));
+        }
+        else{
+            emit messageReceived(data);
+        }
     }
 }
 
@@ -60,6 +60,8 @@ public slots:
 private:
     QString m_module;
     QLocalSocket *m_localSocket;
+    // A large message (e.g. TAG-FILTER) may arrive in more than one read
+    QByteArray m_buffer;
 };
 
 #endif // COMMUNICATIONSERVICE_H
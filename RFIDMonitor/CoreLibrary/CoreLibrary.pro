@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core sql serialport
+QT       += core sql serialport concurrent
 
 QT       -= gui
 
@@ -15,6 +15,7 @@ TEMPLATE = lib
 SOURCES += \
     coremodule.cpp \
     object/rfiddata.cpp \
+    object/rfiddatapool.cpp \
     logger.cpp \
     core/interfaces.cpp \
     core/service.cpp \
@@ -25,7 +26,19 @@ SOURCES += \
     json/nodejsmessage.cpp \
     core/connectionpool.cpp \
     core/functions.cpp \
+    core/digest.cpp \
+    core/ingestjournal.cpp \
+    core/executor.cpp \
+    core/threadtuning.cpp \
+    core/serialconnection.cpp \
+    core/tagfilter.cpp \
+    core/tagindex.cpp \
+    core/passagedetector.cpp \
+    core/livestream.cpp \
+    core/clock.cpp \
     core/sql/sqlquery.cpp \
+    core/sql/selectquery.cpp \
+    core/sql/statementcache.cpp \
     core/sql/exception/sqlconnectionexception.cpp \
     core/sql/exception/sqlexception.cpp \
     core/sql/exception/sqlstatementexception.cpp \
@@ -34,9 +47,12 @@ SOURCES += \
 
 QMAKE_CXXFLAGS += -std=c++11 -Wmissing-field-initializers
 
+LIBS += -ludev
+
 HEADERS += \
     coremodule.h \
     object/rfiddata.h \
+    object/rfiddatapool.h \
     logger.h \
     core/interfaces.h \
     core/service.h \
@@ -48,8 +64,20 @@ HEADERS += \
     json/nodejsmessage.h \
     core/connectionpool.h \
     core/functions.h \
+    core/digest.h \
+    core/ingestjournal.h \
+    core/executor.h \
+    core/threadtuning.h \
+    core/serialconnection.h \
+    core/tagfilter.h \
+    core/tagindex.h \
+    core/passagedetector.h \
+    core/livestream.h \
+    core/clock.h \
     core/genericdao.h \
     core/sql/sqlquery.h \
+    core/sql/selectquery.h \
+    core/sql/statementcache.h \
     core/sql/exception/sqlconnectionexception.h \
     core/sql/exception/sqlexception.h \
     core/sql/exception/sqlstatementexception.h \
@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <time.h>
+
+#include "clock.h"
+
+namespace {
+
+/*!
+ * \brief KLegacyLimit separates the timestamps in milliseconds from the ones in microseconds, see Clock::fromStored().
+ */
+const qint64 KLegacyLimit = Q_INT64_C(100000000000000);
+
+}
+
+qint64 Clock::now()
+{
+    // CLOCK_REALTIME_COARSE would be cheaper, but its resolution (one tick of the kernel) is too low for the microseconds of the readings
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+QDateTime Clock::toDateTime(qint64 timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(timestamp / 1000);
+}
+
+qint64 Clock::fromDateTime(const QDateTime &dateTime)
+{
+    return dateTime.toMSecsSinceEpoch() * 1000;
+}
+
+QString Clock::toIsoString(qint64 timestamp)
+{
+    return toDateTime(timestamp).toString(Qt::ISODate);
+}
+
+qint64 Clock::fromIsoString(const QString &text)
+{
+    return fromDateTime(QDateTime::fromString(text, Qt::ISODate));
+}
+
+qint64 Clock::fromStored(qint64 value)
+{
+    return value < KLegacyLimit ? value * 1000 : value;
+}
@@ -0,0 +1,77 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QDateTime>
+#include <QString>
+
+/*!
+ * \brief The Clock class gives the timestamps of the readings: microseconds since the epoch, in UTC.
+ *
+ * now() is a single read of CLOCK_REALTIME, served by the vDSO without a system call or a time zone conversion.
+ *
+ * The timestamps are kept as integers through the whole pipeline (journal, database, packager) and converted to text only at the protocol edge, with toIsoString().
+ */
+class Clock
+{
+public:
+    /*!
+     * \brief now returns the current time, in microseconds since the epoch (UTC).
+     */
+    static qint64 now();
+
+    /*!
+     * \brief toDateTime converts a timestamp to a local QDateTime (with millisecond precision).
+     */
+    static QDateTime toDateTime(qint64 timestamp);
+
+    /*!
+     * \brief fromDateTime converts a QDateTime to a timestamp.
+     */
+    static qint64 fromDateTime(const QDateTime &dateTime);
+
+    /*!
+     * \brief toIsoString converts a timestamp to the local ISO 8601 text used by the protocol, e.g. 2014-03-20T10:15:42.
+     */
+    static QString toIsoString(qint64 timestamp);
+
+    /*!
+     * \brief fromIsoString converts the ISO 8601 text of the protocol to a timestamp.
+     */
+    static qint64 fromIsoString(const QString &text);
+
+    /*!
+     * \brief fromStored reads a timestamp from a binary record of the journal or of a segment, which older versions wrote in milliseconds.
+     * A value below KLegacyLimit (1973 in microseconds, year 5138 in milliseconds) is taken as milliseconds.
+     */
+    static qint64 fromStored(qint64 value);
+};
+
+#endif // CLOCK_H
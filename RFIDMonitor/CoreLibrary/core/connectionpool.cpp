@@ -90,19 +90,28 @@ QSqlDatabase * ConnectionPool::systemConnection()
                                         QString("  UNIQUE (`name`) ,\n") +
                                         QString("  PRIMARY KEY (`name`) );\n"));
             QString createPackages = QString(QString("CREATE  TABLE IF NOT EXISTS `packet` (\n") +
-                                        QString("  `md5hash` VARCHAR(32) NOT NULL ,\n") +
+                                        QString("  `hash` BLOB NOT NULL ,\n") +
                                         QString("  `datetime` datetime NOT NULL,\n") +
                                         QString("  `idbegin` BIGINT(12) NOT NULL ,\n") +
                                         QString("  `item_count` BIGINT(12) NOT NULL ,\n") +
                                         QString("  `jsondata` BLOB NOT NULL ,\n") +
                                         QString("  `status` int(2) NOT NULL,\n") +
-                                        QString("  PRIMARY KEY (`md5hash`) );\n"));
+                                        QString("  PRIMARY KEY (`hash`) );\n"));
             QSqlQuery query(m_systemConnection);
 
+            // In WAL mode a reader sees one snapshot of the database and doesn't block the writers (see PackagerInterface::exportPackets).
+            query.exec("PRAGMA journal_mode=WAL");
+
             // Execute the queries.
             query.exec(createtable);
             query.exec(createSeq);
+            // Databases created by older versions keep the packets keyed by the hex MD5 string.
+            bool legacyPackets = query.exec("SELECT md5hash FROM packet LIMIT 1");
+            if(legacyPackets)
+                query.exec("ALTER TABLE packet RENAME TO packet_md5");
             query.exec(createPackages);
+            if(legacyPackets)
+                migrateLegacyPackets();
         }
     }
 
@@ -111,3 +120,38 @@ QSqlDatabase * ConnectionPool::systemConnection()
 
     return &m_systemConnection;
 }
+
+/*!
+ * \brief ConnectionPool::migrateLegacyPackets copies the packets of the old `packet_md5` table into the new `packet` table,
+ * converting the hex digest to the binary key. The old table is dropped when the copy succeeds.
+ */
+void ConnectionPool::migrateLegacyPackets()
+{
+    QSqlQuery select(m_systemConnection);
+    select.exec("SELECT md5hash, datetime, idbegin, item_count, jsondata, status FROM packet_md5");
+
+    m_systemConnection.transaction();
+    QSqlQuery insert(m_systemConnection);
+    insert.prepare("INSERT INTO packet (hash, datetime, idbegin, item_count, jsondata, status) "
+                   "VALUES (:hash, :datetime, :idbegin, :item_count, :jsondata, :status)");
+    bool ok = true;
+    while(ok && select.next()){
+        insert.bindValue(":hash", QByteArray::fromHex(select.value(0).toString().toLatin1()));
+        insert.bindValue(":datetime", select.value(1));
+        insert.bindValue(":idbegin", select.value(2));
+        insert.bindValue(":item_count", select.value(3));
+        insert.bindValue(":jsondata", select.value(4));
+        insert.bindValue(":status", select.value(5));
+        ok = insert.exec();
+    }
+
+    if(ok){
+        m_systemConnection.commit();
+        select.finish();
+        select.exec("DROP TABLE packet_md5");
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, "Packet table migrated to binary hash keys");
+    }else{
+        m_systemConnection.rollback();
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Packet migration failed: %1").arg(insert.lastError().text()));
+    }
+}
@@ -43,6 +43,7 @@ public:
 private:
     QString m_module;
     ConnectionPool(QObject *parent);
+    void migrateLegacyPackets();
     // database connections
     QSqlDatabase m_systemConnection;
 };
@@ -0,0 +1,232 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCryptographicHash>
+#include <QScopedPointer>
+#include <QtEndian>
+
+#include <cstring>
+
+#include "digest.h"
+
+namespace {
+
+/*!
+ * \brief The Md5Digest class keeps the digest used by the first versions of the protocol.
+ */
+class Md5Digest : public Digest
+{
+public:
+    Md5Digest() :
+        m_hash(QCryptographicHash::Md5)
+    {
+    }
+
+    void addData(const char *data, int length)
+    {
+        m_hash.addData(data, length);
+    }
+
+    QByteArray result()
+    {
+        return m_hash.result();
+    }
+
+    void reset()
+    {
+        m_hash.reset();
+    }
+
+private:
+    QCryptographicHash m_hash;
+};
+
+/*!
+ * \brief The XxHash64Digest class is a streaming implementation of the XXH64 algorithm (seed 0).
+ * The result is returned in the canonical (big endian) representation.
+ */
+class XxHash64Digest : public Digest
+{
+public:
+    XxHash64Digest()
+    {
+        reset();
+    }
+
+    void addData(const char *data, int length)
+    {
+        const uchar *p = reinterpret_cast<const uchar *>(data);
+        const uchar * const end = p + length;
+        m_totalLength += length;
+
+        // Not enough data to fill a stripe, only keep it for later
+        if(m_bufferSize + length < 32){
+            memcpy(m_buffer + m_bufferSize, p, length);
+            m_bufferSize += length;
+            return;
+        }
+
+        if(m_bufferSize){
+            memcpy(m_buffer + m_bufferSize, p, 32 - m_bufferSize);
+            p += 32 - m_bufferSize;
+            consumeStripe(m_buffer);
+            m_bufferSize = 0;
+        }
+
+        while(p + 32 <= end){
+            consumeStripe(p);
+            p += 32;
+        }
+
+        if(p < end){
+            m_bufferSize = end - p;
+            memcpy(m_buffer, p, m_bufferSize);
+        }
+    }
+
+    QByteArray result()
+    {
+        quint64 h;
+        if(m_totalLength >= 32){
+            h = rotl(m_v1, 1) + rotl(m_v2, 7) + rotl(m_v3, 12) + rotl(m_v4, 18);
+            h = mergeRound(h, m_v1);
+            h = mergeRound(h, m_v2);
+            h = mergeRound(h, m_v3);
+            h = mergeRound(h, m_v4);
+        }else{
+            h = KPrime5;
+        }
+        h += m_totalLength;
+
+        const uchar *p = m_buffer;
+        const uchar * const end = m_buffer + m_bufferSize;
+        while(p + 8 <= end){
+            h ^= round(0, qFromLittleEndian<quint64>(p));
+            h = rotl(h, 27) * KPrime1 + KPrime4;
+            p += 8;
+        }
+        if(p + 4 <= end){
+            h ^= quint64(qFromLittleEndian<quint32>(p)) * KPrime1;
+            h = rotl(h, 23) * KPrime2 + KPrime3;
+            p += 4;
+        }
+        while(p < end){
+            h ^= quint64(*p) * KPrime5;
+            h = rotl(h, 11) * KPrime1;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= KPrime2;
+        h ^= h >> 29;
+        h *= KPrime3;
+        h ^= h >> 32;
+
+        QByteArray digest(sizeof(quint64), Qt::Uninitialized);
+        qToBigEndian<quint64>(h, reinterpret_cast<uchar *>(digest.data()));
+        return digest;
+    }
+
+    void reset()
+    {
+        m_v1 = KPrime1 + KPrime2;
+        m_v2 = KPrime2;
+        m_v3 = 0;
+        m_v4 = 0 - KPrime1;
+        m_totalLength = 0;
+        m_bufferSize = 0;
+    }
+
+private:
+    static const quint64 KPrime1 = Q_UINT64_C(11400714785074694791);
+    static const quint64 KPrime2 = Q_UINT64_C(14029467366897019727);
+    static const quint64 KPrime3 = Q_UINT64_C(1609587929392839161);
+    static const quint64 KPrime4 = Q_UINT64_C(9650029242287828579);
+    static const quint64 KPrime5 = Q_UINT64_C(2870177450012600261);
+
+    static inline quint64 rotl(quint64 value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static inline quint64 round(quint64 acc, quint64 input)
+    {
+        acc += input * KPrime2;
+        acc = rotl(acc, 31);
+        return acc * KPrime1;
+    }
+
+    static inline quint64 mergeRound(quint64 acc, quint64 value)
+    {
+        acc ^= round(0, value);
+        return acc * KPrime1 + KPrime4;
+    }
+
+    void consumeStripe(const uchar *p)
+    {
+        m_v1 = round(m_v1, qFromLittleEndian<quint64>(p));
+        m_v2 = round(m_v2, qFromLittleEndian<quint64>(p + 8));
+        m_v3 = round(m_v3, qFromLittleEndian<quint64>(p + 16));
+        m_v4 = round(m_v4, qFromLittleEndian<quint64>(p + 24));
+    }
+
+    quint64 m_v1;
+    quint64 m_v2;
+    quint64 m_v3;
+    quint64 m_v4;
+    quint64 m_totalLength;
+    uchar m_buffer[32];
+    int m_bufferSize;
+};
+
+}
+
+Digest *Digest::create(Digest::Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::KXxHash64:
+        return new XxHash64Digest;
+    case Algorithm::KMd5:
+    default:
+        return new Md5Digest;
+    }
+}
+
+Digest::Algorithm Digest::algorithmFromName(const QString &name)
+{
+    if(name.compare("xxhash64", Qt::CaseInsensitive) == 0)
+        return Algorithm::KXxHash64;
+    return Algorithm::KMd5;
+}
+
+QByteArray Digest::hash(const QByteArray &data, Digest::Algorithm algorithm)
+{
+    QScopedPointer<Digest> digest(create(algorithm));
+    digest->addData(data);
+    return digest->result();
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <QByteArray>
+#include <QString>
+
+/*!
+ * \brief The Digest class is the common interface of the hash algorithms used to identify the packets sent to the server.
+ *
+ * The data is fed incrementally with addData(), so the caller can hash the same bytes it is serializing without building a second copy of them.
+ * MD5 is kept for the servers that still validate the legacy 32 characters digest, xxHash64 is much cheaper on the ARM boards.
+ */
+class Digest
+{
+public:
+    enum class Algorithm {
+        KMd5 = 0,
+        KXxHash64
+    };
+
+    virtual ~Digest() {}
+
+    virtual void addData(const char *data, int length) = 0;
+    void addData(const QByteArray &data)
+    {
+        addData(data.constData(), data.size());
+    }
+
+    /*!
+     * \brief result returns the raw (binary) digest of all data added since the creation or the last reset().
+     */
+    virtual QByteArray result() = 0;
+    virtual void reset() = 0;
+
+    /*!
+     * \brief create returns a new digest object for the algorithm. The caller owns the returned object.
+     */
+    static Digest * create(Algorithm algorithm);
+
+    /*!
+     * \brief algorithmFromName converts the name used in the configuration file ("md5", "xxhash64") to an algorithm. Unknown names fall back to MD5.
+     */
+    static Algorithm algorithmFromName(const QString &name);
+
+    static QByteArray hash(const QByteArray &data, Algorithm algorithm);
+};
+
+#endif // DIGEST_H
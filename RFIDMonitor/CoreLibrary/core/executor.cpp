@@ -0,0 +1,305 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <exception>
+
+#include <logger.h>
+
+#include "executor.h"
+
+/*!
+ * \brief The ExecutorWorker class is one of the threads of an ExecutorQueue.
+ */
+class ExecutorWorker : public QThread
+{
+public:
+    explicit ExecutorWorker(ExecutorQueue *queue) :
+        m_queue(queue)
+    {
+    }
+
+protected:
+    void run()
+    {
+        m_queue->work();
+    }
+
+private:
+    ExecutorQueue *m_queue;
+};
+
+ExecutorQueue::ExecutorQueue(const QString &name, int workers, int capacity, Policy policy) :
+    m_name(name),
+    m_capacity(qMax(1, capacity)),
+    m_policy(policy),
+    m_stopping(false),
+    m_running(0),
+    m_maxDepth(0),
+    m_submitted(0),
+    m_executed(0),
+    m_rejected(0),
+    m_dropped(0)
+{
+    for(int i = 0; i < qMax(1, workers); i++){
+        QThread *worker = new ExecutorWorker(this);
+        worker->setObjectName(QString("%1-%2").arg(m_name).arg(i));
+        m_workers.append(worker);
+        worker->start();
+    }
+}
+
+ExecutorQueue::~ExecutorQueue()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // The workers finish the tasks already in the queue before leaving
+        m_stopping = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+    foreach (QThread *worker, m_workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+QString ExecutorQueue::name() const
+{
+    return m_name;
+}
+
+bool ExecutorQueue::submit(const std::function<void ()> &task)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_stopping){
+        m_rejected++;
+        return false;
+    }
+
+    if(int(m_tasks.size()) >= m_capacity){
+        switch (m_policy) {
+        case KBlock:
+            while(int(m_tasks.size()) >= m_capacity && !m_stopping)
+                m_notFull.wait(&m_mutex);
+            if(m_stopping){
+                m_rejected++;
+                return false;
+            }
+            break;
+        case KReject:
+            m_rejected++;
+            return false;
+        case KDropOldest:
+            m_tasks.pop_front();
+            m_dropped++;
+            break;
+        }
+    }
+
+    m_tasks.push_back(task);
+    m_submitted++;
+    m_maxDepth = qMax(m_maxDepth, int(m_tasks.size()));
+    m_notEmpty.wakeOne();
+    return true;
+}
+
+void ExecutorQueue::waitForDone()
+{
+    QMutexLocker locker(&m_mutex);
+    while(!m_tasks.empty() || m_running > 0)
+        m_done.wait(&m_mutex);
+}
+
+void ExecutorQueue::work()
+{
+    QMutexLocker locker(&m_mutex);
+    forever {
+        while(m_tasks.empty() && !m_stopping)
+            m_notEmpty.wait(&m_mutex);
+        if(m_tasks.empty())
+            break;
+
+        std::function<void()> task = m_tasks.front();
+        m_tasks.pop_front();
+        m_running++;
+        m_notFull.wakeOne();
+
+        locker.unlock();
+        try {
+            task();
+        } catch (std::exception &e) {
+            Logger::instance()->writeRecord(Logger::severity_level::error, "Executor", Q_FUNC_INFO, QString("Task of queue %1 failed: %2").arg(m_name).arg(e.what()));
+        }
+        locker.relock();
+
+        m_running--;
+        m_executed++;
+        if(m_tasks.empty() && m_running == 0)
+            m_done.wakeAll();
+    }
+}
+
+int ExecutorQueue::depth()
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_tasks.size());
+}
+
+int ExecutorQueue::maxDepth()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxDepth;
+}
+
+quint64 ExecutorQueue::submitted()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_submitted;
+}
+
+quint64 ExecutorQueue::executed()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_executed;
+}
+
+quint64 ExecutorQueue::rejected()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rejected;
+}
+
+quint64 ExecutorQueue::dropped()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+QString ExecutorQueue::statistics()
+{
+    QMutexLocker locker(&m_mutex);
+    return QString("%1 (%2 workers, %3 %4): depth %5, max depth %6, submitted %7, executed %8, rejected %9, dropped %10")
+            .arg(m_name).arg(m_workers.size()).arg(m_capacity).arg(policyName(m_policy))
+            .arg(m_tasks.size()).arg(m_maxDepth).arg(m_submitted).arg(m_executed).arg(m_rejected).arg(m_dropped);
+}
+
+ExecutorQueue::Policy ExecutorQueue::policyFromName(const QString &name)
+{
+    if(name == "reject")
+        return KReject;
+    if(name == "dropoldest")
+        return KDropOldest;
+    return KBlock;
+}
+
+QString ExecutorQueue::policyName(Policy policy)
+{
+    switch (policy) {
+    case KReject:
+        return "reject";
+    case KDropOldest:
+        return "dropoldest";
+    default:
+        return "block";
+    }
+}
+
+Executor::Executor(QObject *parent) :
+    QObject(parent),
+    m_module("Executor")
+{
+    QueueConfig ingest = {1, 1024, ExecutorQueue::KBlock};
+    QueueConfig sync = {1, 1, ExecutorQueue::KReject};
+    QueueConfig comm = {1, 1024, ExecutorQueue::KDropOldest};
+    QueueConfig uplink = {1, 1024, ExecutorQueue::KBlock};
+    QueueConfig index = {1, 1, ExecutorQueue::KReject};
+    m_configs.insert("ingest", ingest);
+    m_configs.insert("sync", sync);
+    m_configs.insert("comm", comm);
+    m_configs.insert("uplink", uplink);
+    m_configs.insert("index", index);
+}
+
+Executor *Executor::instance()
+{
+    static Executor *singleton = 0;
+    if(!singleton){
+        singleton = new Executor(qApp);
+    }
+    return singleton;
+}
+
+Executor::~Executor()
+{
+    qDeleteAll(m_queues);
+}
+
+void Executor::configure(const QString &name, const QueueConfig &config)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_queues.contains(name)){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Queue %1 is already running, the new configuration is ignored").arg(name));
+        return;
+    }
+    m_configs.insert(name, config);
+}
+
+ExecutorQueue *Executor::queue(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    ExecutorQueue *queue = m_queues.value(name);
+    if(!queue){
+        if(!m_configs.contains(name)){
+            Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Queue %1 is not configured, using 1 worker, 1024 tasks, block").arg(name));
+            QueueConfig config = {1, 1024, ExecutorQueue::KBlock};
+            m_configs.insert(name, config);
+        }
+        QueueConfig config = m_configs.value(name);
+        queue = new ExecutorQueue(name, config.workers, config.capacity, config.policy);
+        m_queues.insert(name, queue);
+    }
+    return queue;
+}
+
+bool Executor::submit(const QString &name, const std::function<void ()> &task)
+{
+    return queue(name)->submit(task);
+}
+
+void Executor::logStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    foreach (ExecutorQueue *queue, m_queues) {
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, queue->statistics());
+    }
+}
@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include <deque>
+#include <functional>
+
+class QThread;
+
+/*!
+ * \brief The ExecutorQueue class is a bounded queue of tasks run by a fixed number of worker threads.
+ *
+ * When the queue is full, submit() follows the policy of the queue: KBlock waits for a free slot (backpressure on the caller),
+ * KReject refuses the new task and KDropOldest discards the oldest waiting task to make room for the new one.
+ * A queue with a single worker runs the tasks in the same order they were submitted.
+ */
+class ExecutorQueue
+{
+public:
+    enum Policy {
+        KBlock = 0,
+        KReject,
+        KDropOldest
+    };
+
+    ExecutorQueue(const QString &name, int workers, int capacity, Policy policy);
+    ~ExecutorQueue();
+
+    QString name() const;
+
+    /*!
+     * \brief submit puts \a task in the queue. Returns false when the task was rejected by the policy of the queue.
+     * A task must not submit to its own KBlock queue, the worker could wait forever for itself.
+     */
+    bool submit(const std::function<void()> &task);
+
+    /*!
+     * \brief waitForDone blocks until the queue is empty and no task is running.
+     */
+    void waitForDone();
+
+    int depth();
+    int maxDepth();
+    quint64 submitted();
+    quint64 executed();
+    quint64 rejected();
+    quint64 dropped();
+
+    /*!
+     * \brief statistics returns a one line summary of the counters, used in the log.
+     */
+    QString statistics();
+
+    static Policy policyFromName(const QString &name);
+    static QString policyName(Policy policy);
+
+private:
+    friend class ExecutorWorker;
+    void work();
+
+    QString m_name;
+    int m_capacity;
+    Policy m_policy;
+    bool m_stopping;
+    int m_running;
+
+    int m_maxDepth;
+    quint64 m_submitted;
+    quint64 m_executed;
+    quint64 m_rejected;
+    quint64 m_dropped;
+
+    std::deque<std::function<void()> > m_tasks;
+    QList<QThread *> m_workers;
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QWaitCondition m_done;
+};
+
+/*!
+ * \brief The Executor class owns the named queues where the modules run their background work, instead of the global thread pool.
+ *
+ * The queues are created on the first use with the configuration given to configure(), or with the built in defaults:
+ *  - "ingest": 1 worker, 1024 tasks, block. Commits the journal batches in order and slows down the readers when the database can't keep up.
+ *  - "sync": 1 worker, 1 task, reject. A request to synchronize while another one is waiting is redundant and is coalesced.
+ *  - "comm": 1 worker, 1024 tasks, drop oldest. Sends the live messages to the daemon (reader responses, live stream), the oldest ones are the less useful.
+ *  - "uplink": 1 worker, 1024 tasks, block. Sends the messages that must not be lost (DATA packets), a full queue slows down the synchronization.
+ *  - "index": 1 worker, 1 task, reject. Rebuilds the TagIndex after the startup.
+ */
+class Executor : public QObject
+{
+    Q_OBJECT
+public:
+    struct QueueConfig {
+        int workers;
+        int capacity;
+        ExecutorQueue::Policy policy;
+    };
+
+    static Executor * instance();
+    ~Executor();
+
+    /*!
+     * \brief configure sets the parameters of the queue \a name. Must be called before the queue is used, later calls are ignored.
+     */
+    void configure(const QString &name, const QueueConfig &config);
+
+    /*!
+     * \brief queue returns the queue \a name, creating it if needed.
+     */
+    ExecutorQueue * queue(const QString &name);
+
+    /*!
+     * \brief submit is a shortcut to queue(name)->submit(task).
+     */
+    bool submit(const QString &name, const std::function<void()> &task);
+
+    /*!
+     * \brief logStatistics writes the counters of all queues to the log.
+     */
+    void logStatistics();
+
+private:
+    explicit Executor(QObject *parent = 0);
+
+    QString m_module;
+    QMap<QString, QueueConfig> m_configs;
+    QMap<QString, ExecutorQueue *> m_queues;
+    QMutex m_mutex;
+};
+
+#endif // EXECUTOR_H
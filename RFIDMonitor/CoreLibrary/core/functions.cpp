@@ -80,3 +80,35 @@ QDateTime Functions::getSystemDate()
 {
     return QDateTime::currentDateTime();
 }
+
+namespace {
+
+struct Crc32Table
+{
+    Crc32Table()
+    {
+        for(quint32 i = 0; i < 256; i++){
+            quint32 c = i;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            value[i] = c;
+        }
+    }
+    quint32 value[256];
+};
+
+}
+
+/*!
+ * \brief Functions::crc32 computes the CRC-32 (the same polynomial of zlib) of a block of data.
+ * It is used to protect the records of the binary files written by the system.
+ * \return the checksum of the \a length first bytes of \a data.
+ */
+quint32 Functions::crc32(const uchar *data, int length)
+{
+    static const Crc32Table table;
+    quint32 crc = 0xFFFFFFFF;
+    for(int i = 0; i < length; i++)
+        crc = table.value[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFF;
+}
@@ -38,6 +38,7 @@ public:
     static qlonglong getSequence(const QString & className, QSqlDatabase *db);
     //static int buscaID(const QString & tableName,const QString & columnName);
     static QDateTime getSystemDate();
+    static quint32 crc32(const uchar *data, int length);
 };
 
 
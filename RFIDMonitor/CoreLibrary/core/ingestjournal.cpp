@@ -0,0 +1,307 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QTimer>
+#include <QtEndian>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <logger.h>
+#include <rfidmonitor.h>
+#include <object/rfiddata.h>
+#include <object/rfiddatapool.h>
+
+#include "clock.h"
+#include "executor.h"
+#include "functions.h"
+#include "interfaces.h"
+#include "ingestjournal.h"
+#include "tagfilter.h"
+#include "tagindex.h"
+#include "passagedetector.h"
+#include "livestream.h"
+
+namespace {
+
+/*
+ * Layout of one journal record (little endian):
+ * [identificationcode][applicationcode][idantena][idpontocoleta][timestamp][crc32  ]
+ * [ 8 bytes          ][ 8 bytes       ][ 4 bytes][ 4 bytes     ][ 8 bytes ][4 bytes]
+ */
+const int KRecordSize = 36;
+const int KPayloadSize = 32;
+
+/*!
+ * \brief KMaxBatch is the maximum number of readings waiting for the next sync of the journal.
+ */
+const int KMaxBatch = 256;
+
+/*!
+ * \brief KFlushInterval is the maximum time, in milliseconds, a reading waits for the sync of the journal.
+ */
+const int KFlushInterval = 200;
+
+void encode(const Rfiddata *data, uchar *record)
+{
+    qToLittleEndian<qint64>(data->identificationcode().toLongLong(), record);
+    qToLittleEndian<qint64>(data->applicationcode().toLongLong(), record + 8);
+    qToLittleEndian<qint32>(data->idantena().toInt(), record + 16);
+    qToLittleEndian<qint32>(data->idpontocoleta().toInt(), record + 20);
+    qToLittleEndian<qint64>(data->timestamp(), record + 24);
+    qToLittleEndian<quint32>(Functions::crc32(record, KPayloadSize), record + KPayloadSize);
+}
+
+Rfiddata * decode(const uchar *record)
+{
+    if(qFromLittleEndian<quint32>(record + KPayloadSize) != Functions::crc32(record, KPayloadSize))
+        return 0;
+
+    Rfiddata *data = RfiddataPool::instance()->acquire();
+    data->setIdentificationcode(qFromLittleEndian<qint64>(record));
+    data->setApplicationcode(qFromLittleEndian<qint64>(record + 8));
+    data->setIdantena(qFromLittleEndian<qint32>(record + 16));
+    data->setIdpontocoleta(qFromLittleEndian<qint32>(record + 20));
+    data->setTimestamp(Clock::fromStored(qFromLittleEndian<qint64>(record + 24)));
+    data->setSync(Rfiddata::KNotSynced);
+    return data;
+}
+
+}
+
+IngestJournal::IngestJournal(QObject *parent) :
+    QObject(parent),
+    m_module("IngestJournal"),
+    m_path(QCoreApplication::applicationDirPath() + "/journal"),
+    m_sequence(0),
+    m_file(0),
+    m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(KFlushInterval);
+    connect(m_flushTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    QDir().mkpath(m_path);
+    // Continue the numbering of the files left by the previous execution
+    QStringList files = QDir(m_path).entryList(QStringList() << "journal_*.wal", QDir::Files, QDir::Name);
+    if(!files.isEmpty())
+        m_sequence = QFileInfo(files.last()).baseName().mid(8).toUInt() + 1;
+}
+
+IngestJournal *IngestJournal::instance()
+{
+    static IngestJournal *singleton = 0;
+    if(!singleton){
+        singleton = new IngestJournal(qApp);
+    }
+    return singleton;
+}
+
+IngestJournal::~IngestJournal()
+{
+    // The pending readings stay in the journal file and are replayed in the next execution.
+    // The Executor is created before the journal, so it is destroyed first and has already run the flushed batches.
+}
+
+void IngestJournal::append(Rfiddata *data)
+{
+    // The readings of the tags excluded by the TagFilter never reach the journal
+    if(!TagFilter::instance()->accept(data->identificationcode().toLongLong())){
+        RfiddataPool::instance()->release(data);
+        return;
+    }
+    // The subscribers of the live stream see the reading before it is committed
+    LiveStream::instance()->push(data);
+
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_file && !openFile()){
+        // Without the journal the reading is still committed with the batch, only the protection against a power cut is lost
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, "Journal not available");
+    }
+
+    if(m_file){
+        uchar record[KRecordSize];
+        encode(data, record);
+        m_file->write(reinterpret_cast<const char *>(record), KRecordSize);
+    }
+    m_pending.append(data);
+
+    if(m_pending.size() >= KMaxBatch){
+        locker.unlock();
+        flush();
+    }else if(m_pending.size() == 1){
+        // The timer belongs to the thread of the journal
+        QMetaObject::invokeMethod(m_flushTimer, "start");
+    }
+}
+
+void IngestJournal::flush()
+{
+    // Held from taking the batch until it is queued, so the batches are queued in the order they were taken.
+    // The readers only wait for it when they flush, appending a reading needs m_mutex alone.
+    QMutexLocker submitLocker(&m_submitMutex);
+    QMutexLocker locker(&m_mutex);
+
+    if(m_pending.isEmpty())
+        return;
+
+    QString fileName;
+    if(m_file){
+        // One sync for the whole batch
+        m_file->flush();
+        if(::fdatasync(m_file->handle()) != 0)
+            Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't sync %1").arg(m_file->fileName()));
+        fileName = m_file->fileName();
+        m_file->close();
+        delete m_file;
+        m_file = 0;
+    }
+
+    QList<Rfiddata *> batch = m_pending;
+    m_pending.clear();
+    // The readers append to a new journal file while this batch waits for room in the queue
+    locker.unlock();
+
+    // The "ingest" queue has one worker by default, so the batches reach the database in the same order they were read.
+    // When the database can't keep up the queue fills and this call blocks, slowing down the readers instead of growing the memory.
+    Executor::instance()->submit("ingest", [batch, fileName](){
+        PersistenceInterface *persister = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+        SynchronizationInterface *synchronizer = RFIDMonitor::instance()->defaultService<SynchronizationInterface>();
+        Q_ASSERT(persister);
+
+        if(!persister->insertObjectList(batch)){
+            // The journal file keeps the readings, they are committed by the replay of the next execution
+            Logger::instance()->writeRecord(Logger::severity_level::critical, "IngestJournal", Q_FUNC_INFO, QString("Can't commit %1 readings, kept in %2").arg(batch.size()).arg(fileName));
+            RfiddataPool::instance()->release(batch);
+            return;
+        }
+        TagIndex::instance()->add(batch);
+        PassageDetector::instance()->feed(batch);
+        // The readings are in the database, the journal file is not needed anymore
+        if(!fileName.isEmpty())
+            QFile::remove(fileName);
+        // The objects go back to the pool for the next readings
+        RfiddataPool::instance()->release(batch);
+
+        if(synchronizer)
+            Executor::instance()->submit("sync", [synchronizer](){ synchronizer->readyRead(); });
+    });
+}
+
+void IngestJournal::waitForCommits()
+{
+    Executor::instance()->queue("ingest")->waitForDone();
+}
+
+void IngestJournal::replay()
+{
+    PersistenceInterface *persister = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+    if(!persister)
+        return;
+
+    QDir dir(m_path);
+    foreach (QString fileName, dir.entryList(QStringList() << "journal_*.wal", QDir::Files, QDir::Name)) {
+        QFile file(dir.absoluteFilePath(fileName));
+        if(!file.open(QIODevice::ReadOnly))
+            continue;
+        QByteArray content = file.readAll();
+        file.close();
+
+        QList<Rfiddata *> batch;
+        for(int offset = 0; offset + KRecordSize <= content.size(); offset += KRecordSize){
+            // A record that fails the CRC was not synced, it and everything after it are discarded
+            Rfiddata *data = decode(reinterpret_cast<const uchar *>(content.constData()) + offset);
+            if(!data)
+                break;
+            batch.append(data);
+        }
+
+        // A file holds one batch, committed in one transaction just before the power cut or not at all
+        if(!batch.isEmpty() && isPersisted(batch.first()) && isPersisted(batch.last())){
+            Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("The %1 readings of %2 were already persisted").arg(batch.size()).arg(fileName));
+            RfiddataPool::instance()->release(batch);
+            file.remove();
+            continue;
+        }
+
+        if(!batch.isEmpty()){
+            if(!persister->insertObjectList(batch)){
+                Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Can't commit the readings of %1, kept for the next execution").arg(fileName));
+                RfiddataPool::instance()->release(batch);
+                continue;
+            }
+            TagIndex::instance()->add(batch);
+            PassageDetector::instance()->feed(batch);
+        }
+        RfiddataPool::instance()->release(batch);
+        file.remove();
+
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Replayed %1 readings from %2").arg(batch.size()).arg(fileName));
+    }
+}
+
+bool IngestJournal::openFile()
+{
+    m_file = new QFile(QString("%1/journal_%2.wal").arg(m_path).arg(m_sequence++, 10, 10, QChar('0')));
+    if(!m_file->open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't open %1: %2").arg(m_file->fileName()).arg(m_file->errorString()));
+        delete m_file;
+        m_file = 0;
+        return false;
+    }
+
+    // Make the new directory entry durable before the first sync of the file
+    int dirFd = ::open(QFile::encodeName(m_path).constData(), O_RDONLY);
+    if(dirFd >= 0){
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+}
+
+bool IngestJournal::isPersisted(Rfiddata *data)
+{
+    PersistenceInterface *persister = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+    // The exact key of the reading, a journal of an older version is read with the same precision its readings were persisted
+    SelectQuery<Rfiddata> select;
+    select.columns({Rfiddata::Column::KId})
+            .where(Rfiddata::Column::KIdentificationcode, data->identificationcode())
+            .where(Rfiddata::Column::KIdantena, data->idantena())
+            .between(Rfiddata::Column::KTimestamp, data->timestamp(), data->timestamp())
+            .limit(1);
+    QList<Rfiddata *> list = persister->select(select, 0);
+    bool found = !list.isEmpty();
+    qDeleteAll(list);
+    return found;
+}
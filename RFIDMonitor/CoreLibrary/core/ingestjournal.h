@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef INGESTJOURNAL_H
+#define INGESTJOURNAL_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+
+class QFile;
+class QTimer;
+class Rfiddata;
+
+/*!
+ * \brief The IngestJournal class is the first place where the readings land, before the persistence service.
+ *
+ * Each reading is appended to a journal file as a small binary record protected by a CRC32. The journal is synced (fdatasync) once per batch,
+ * when KMaxBatch readings are pending or KFlushInterval milliseconds after the first reading of the batch (group commit).
+ * After the sync, the file is closed and the whole batch is committed to the default persistence service on the "ingest" queue of the Executor,
+ * then the file is removed and the synchronization service is notified through the "sync" queue. A new file is used for the next batch.
+ *
+ * At startup, replay() commits the batches of the journal files left by a power cut, so no synced reading is lost.
+ */
+class IngestJournal : public QObject
+{
+    Q_OBJECT
+public:
+    static IngestJournal * instance();
+    ~IngestJournal();
+
+    /*!
+     * \brief append writes a new reading to the journal. The journal takes the ownership of \a data, which must come from RfiddataPool::acquire(),
+     * and gives it back to the pool after the commit. A reading rejected by the TagFilter is given back at once.
+     */
+    void append(Rfiddata *data);
+
+    /*!
+     * \brief replay commits to the default persistence service the readings of the journal files of the previous execution.
+     * Must be called after the default services are loaded and before the readers start.
+     */
+    void replay();
+
+    /*!
+     * \brief waitForCommits blocks until all the flushed batches are committed to the persistence service.
+     */
+    void waitForCommits();
+
+public slots:
+    /*!
+     * \brief flush syncs the current journal file and sends the pending batch to the persistence service.
+     */
+    void flush();
+
+private:
+    explicit IngestJournal(QObject *parent = 0);
+    bool openFile();
+    /*!
+     * \brief isPersisted tells whether the reading with the exact key of \a data is in the persistence service.
+     */
+    bool isPersisted(Rfiddata *data);
+
+    QString m_module;
+    QString m_path;
+    quint32 m_sequence;
+    QFile *m_file;
+    QList<Rfiddata *> m_pending;
+    QTimer *m_flushTimer;
+    QMutex m_mutex;
+    QMutex m_submitMutex;
+};
+
+#endif // INGESTJOURNAL_H
@@ -27,8 +27,44 @@
 
 
 ReadingInterface::ReadingInterface(QObject *parent) :
-    Service(parent)
+    Service(parent),
+    m_readings(0)
+{
+}
+
+json::ReaderSettings ReadingInterface::settings() const
+{
+    return m_settings;
+}
+
+void ReadingInterface::setSettings(const json::ReaderSettings &settings)
+{
+    m_settings = settings;
+}
+
+QString ReadingInterface::readerName() const
+{
+    return m_settings.name();
+}
+
+QString ReadingInterface::device() const
+{
+    return m_settings.device();
+}
+
+int ReadingInterface::antennaOffset() const
+{
+    return m_settings.antennaOffset();
+}
+
+quint64 ReadingInterface::readings() const
+{
+    return m_readings.load(std::memory_order_relaxed);
+}
+
+void ReadingInterface::countReading()
 {
+    m_readings.fetch_add(1, std::memory_order_relaxed);
 }
 
 ExportInterface::ExportInterface(QObject *parent) :
@@ -26,15 +26,66 @@
 #ifndef INTERFACES_H
 #define INTERFACES_H
 
+#include <QStringList>
+
+#include <atomic>
+
+#include <json/rfidmonitorsettings.h>
+#include <core/sql/selectquery.h>
+
 #include "service.h"
 
+class QIODevice;
 class Rfiddata;
 
+/*!
+ * \brief The ReadingInterface class is the interface of the services that read the tags from a serial device.
+ *
+ * A collector can have several readers running in parallel, one per device, each in its own thread.
+ * The instance of the module serves the first device and createInstance() creates the readers for the other devices of the same kind.
+ */
 class ReadingInterface : public Service
 {
     Q_OBJECT
 public:
     explicit ReadingInterface(QObject *parent = 0);
+    // Tag used by RFIDMonitor::defaultService<ReadingInterface>()
+    static const ServiceType KServiceType = ServiceType::KReader;
+
+    /*!
+     * \brief createInstance returns a new reader of the same kind, not configured and not started.
+     */
+    virtual ReadingInterface * createInstance(QObject *parent = 0) = 0;
+
+    /*!
+     * \brief settings is the entry of this reader in the "readers" list of the configuration: device, antenna offset and serial line.
+     * Set by RFIDMonitor before the reader starts.
+     */
+    json::ReaderSettings settings() const;
+    void setSettings(const json::ReaderSettings &settings);
+
+    QString readerName() const;
+
+    /*!
+     * \brief device is the serial device of this reader, e.g. /dev/ttyUSB0.
+     */
+    QString device() const;
+
+    /*!
+     * \brief antennaOffset is added to the antenna number read from the device, so the antennas of different readers don't collide.
+     */
+    int antennaOffset() const;
+
+    /*!
+     * \brief readings returns the number of readings this reader sent to the journal since the start.
+     */
+    quint64 readings() const;
+
+protected:
+    /*!
+     * \brief countReading must be called by the reader for every reading sent to the journal.
+     */
+    void countReading();
 
 signals:
     /*!
@@ -53,6 +104,10 @@ public slots:
 
     virtual void fullRead(bool) = 0;
     virtual void write(QString) = 0;
+
+private:
+    json::ReaderSettings m_settings;
+    std::atomic<quint64> m_readings;
 };
 
 
@@ -61,9 +116,18 @@ class PersistenceInterface : public Service
     Q_OBJECT
 public:
     explicit PersistenceInterface(QObject *parent=0);
+    // Tag used by RFIDMonitor::defaultService<PersistenceInterface>()
+    static const ServiceType KServiceType = ServiceType::KPersister;
 
     virtual QList<Rfiddata *> getObjectList(const QString &ColumnObject, QVariant value, QObject *parent) = 0;
-    virtual void insertObjectList(const QList<Rfiddata *> &data) = 0;
+    /*!
+     * \brief select returns the readings that match \a query, with only its columns filled.
+     */
+    virtual QList<Rfiddata *> select(const SelectQuery<Rfiddata> &query, QObject *parent) = 0;
+    /*!
+     * \brief insertObjectList persists \a data, returning false when nothing was stored.
+     */
+    virtual bool insertObjectList(const QList<Rfiddata *> &data) = 0;
     virtual void updateObjectList(const QList<Rfiddata *> &data) = 0;
     virtual void deleteObjectList(const QList<Rfiddata *> &data) = 0;
 
@@ -74,6 +138,8 @@ class ExportInterface : public Service
     Q_OBJECT
 public:
     explicit ExportInterface(QObject *parent = 0);
+    // Tag used by RFIDMonitor::defaultService<ExportInterface>()
+    static const ServiceType KServiceType = ServiceType::KExporter;
 
 public slots:
     /*!
@@ -90,19 +156,34 @@ class PackagerInterface : public Service
     Q_OBJECT
 public:
     explicit PackagerInterface(QObject *parent = 0);
+    // Tag used by RFIDMonitor::defaultService<PackagerInterface>()
+    static const ServiceType KServiceType = ServiceType::KPackager;
 
 
     /*!
-     * \brief Returns a map of all packets prepared for exportation, the packets have the next format:
-     * [index   ][JSON         ][MD5 Hash]
-     * [ 4 bytes][variable size][16 bytes]
-     * The key of the map is the MD5 Hash of the packet.
+     * \brief Returns a map of all packets prepared for exportation, each value is the JSON document of one packet.
+     * The key of the map is the hex representation of the packet digest (MD5 or xxHash64, see RFIDMonitor::packetDigest()).
      * \return
      */
     virtual QMap<QString, QByteArray> getAll() = 0;
+    /*!
+     * \brief Removes the packets acknowledged by the server, identified by the hex digests returned by getAll().
+     */
     virtual void update(const QList<QString> &) = 0;
     virtual void generatePackets() = 0;
 
+    /*!
+     * \brief Writes the packets prepared for exportation in \a device, one JSON document per line, from one consistent snapshot of the database.
+     * Can be called from any thread. The packets stay prepared for exportation until markExported() is called.
+     * \param hashes receives the hex digests of the exported packets.
+     * \return the number of packets written, or -1 on error.
+     */
+    virtual int exportPackets(QIODevice *device, QStringList &hashes) = 0;
+    /*!
+     * \brief Marks the packets written by exportPackets() as exported, like the ones returned by getAll().
+     */
+    virtual void markExported(const QStringList &hashes) = 0;
+
 public slots:
 
 
@@ -113,6 +194,8 @@ class SynchronizationInterface : public Service
     Q_OBJECT
 public:
     explicit SynchronizationInterface(QObject *parent = 0);
+    // Tag used by RFIDMonitor::defaultService<SynchronizationInterface>()
+    static const ServiceType KServiceType = ServiceType::KSynchronizer;
 
     virtual void readyRead() = 0;
 signals:
@@ -128,6 +211,8 @@ class CommunicationInterface : public Service
     Q_OBJECT
 public:
     explicit CommunicationInterface(QObject *parent=0);
+    // Tag used by RFIDMonitor::defaultService<CommunicationInterface>()
+    static const ServiceType KServiceType = ServiceType::KCommunicator;
 
 signals:
     void messageReceived(QByteArray);
@@ -0,0 +1,166 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QTimer>
+
+#include <logger.h>
+#include <rfidmonitor.h>
+#include <object/rfiddata.h>
+#include <json/nodejsmessage.h>
+
+#include "interfaces.h"
+#include "executor.h"
+#include "clock.h"
+#include "livestream.h"
+
+namespace {
+/*!
+ * \brief KRingSize is the maximum number of readings waiting for the next message.
+ */
+const int KRingSize = 1024;
+
+/*!
+ * \brief KFlushInterval is the interval, in milliseconds, between two LIVE-READ messages.
+ */
+const int KFlushInterval = 100;
+}
+
+LiveStream::LiveStream(QObject *parent) :
+    QObject(parent),
+    m_module("LiveStream"),
+    m_active(false),
+    m_ring(KRingSize),
+    m_head(0),
+    m_count(0),
+    m_dropped(0),
+    m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setInterval(KFlushInterval);
+    connect(m_flushTimer, SIGNAL(timeout()), SLOT(flush()));
+}
+
+LiveStream *LiveStream::instance()
+{
+    // Created by RFIDMonitor::start() in the main thread, the initialization of a local static is thread safe anyway
+    static LiveStream *singleton = new LiveStream(qApp);
+    return singleton;
+}
+
+void LiveStream::setActive(bool active)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_active == active)
+        return;
+    m_active = active;
+    m_head = 0;
+    m_count = 0;
+    m_dropped = 0;
+    // The timer belongs to the main thread
+    QMetaObject::invokeMethod(m_flushTimer, active ? "start" : "stop");
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, active ? "Live stream started" : "Live stream stopped");
+}
+
+bool LiveStream::isActive() const
+{
+    return m_active;
+}
+
+void LiveStream::push(const Rfiddata *data)
+{
+    if(!m_active)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+
+    if(m_count == KRingSize){
+        // The subscribers want the latest readings, the oldest one gives its place
+        m_head = (m_head + 1) % KRingSize;
+        m_count--;
+        m_dropped++;
+    }
+    Read &read = m_ring[(m_head + m_count) % KRingSize];
+    read.identificationCode = data->identificationcode().toLongLong();
+    read.applicationCode = data->applicationcode().toLongLong();
+    read.antenna = data->idantena().toInt();
+    read.collectorPoint = data->idpontocoleta().toInt();
+    read.timestamp = data->timestamp();
+    m_count++;
+}
+
+void LiveStream::flush()
+{
+    QJsonArray reads;
+    int dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if(!m_active || (m_count == 0 && m_dropped == 0))
+            return;
+        for(int i = 0; i < m_count; i++){
+            const Read &read = m_ring.at((m_head + i) % KRingSize);
+            QJsonObject obj;
+            obj.insert("identificationcode", QJsonValue::fromVariant(read.identificationCode));
+            obj.insert("applicationcode", QJsonValue::fromVariant(read.applicationCode));
+            obj.insert("idantena", read.antenna);
+            obj.insert("idpontocoleta", read.collectorPoint);
+            obj.insert("datetime", Clock::toIsoString(read.timestamp));
+            reads.append(obj);
+        }
+        dropped = m_dropped;
+        m_head = 0;
+        m_count = 0;
+        m_dropped = 0;
+    }
+
+    CommunicationInterface *communitacion = RFIDMonitor::instance()->defaultService<CommunicationInterface>();
+    if(!communitacion)
+        return;
+
+    QJsonObject dataObj;
+    dataObj.insert("reads", reads);
+    dataObj.insert("dropped", dropped);
+
+    json::NodeJSMessage answer;
+    answer.setType("LIVE-READ");
+    answer.setDateTime(QDateTime::currentDateTime());
+    answer.setJsonData(dataObj);
+    QJsonObject jsonAnswer;
+    answer.write(jsonAnswer);
+
+    // One line, the daemon splits the messages that arrive together
+    QByteArray message = QJsonDocument(jsonAnswer).toJson(QJsonDocument::Compact);
+    // A full "comm" queue drops the oldest live message, like the READER-RESPONSE of the readers
+    Executor::instance()->submit("comm", [communitacion, message](){ communitacion->sendMessage(message); });
+}
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef LIVESTREAM_H
+#define LIVESTREAM_H
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+
+#include <atomic>
+
+class QTimer;
+class Rfiddata;
+
+/*!
+ * \brief The LiveStream class sends each accepted reading to the daemon in a LIVE-READ message, while the server or the DeskApp is subscribed to it.
+ *
+ * It is apart from the synchronization: the readings are taken in IngestJournal::append(), before the journal, and the messages are never retried.
+ * push() only copies the reading to a ring of KRingSize entries, a full ring drops the oldest one. Every KFlushInterval the ring is sent
+ * as one LIVE-READ message on the "comm" queue, so the readers never wait for the daemon.
+ * The rate limit and the coalescing of each subscriber are done by the daemon. Without subscribers push() returns after one atomic load.
+ */
+class LiveStream : public QObject
+{
+    Q_OBJECT
+public:
+    static LiveStream * instance();
+
+    /*!
+     * \brief setActive starts or stops the stream, on SUBSCRIBE-LIVE and UNSUBSCRIBE-LIVE from the daemon.
+     */
+    void setActive(bool active);
+
+    bool isActive() const;
+
+    /*!
+     * \brief push copies \a data to the ring. Called by the readers for each accepted reading, the caller keeps the ownership.
+     */
+    void push(const Rfiddata *data);
+
+public slots:
+    /*!
+     * \brief flush sends the readings of the ring in one LIVE-READ message.
+     */
+    void flush();
+
+private:
+    struct Read
+    {
+        qlonglong identificationCode;
+        qlonglong applicationCode;
+        int antenna;
+        int collectorPoint;
+        qint64 timestamp;
+    };
+
+    explicit LiveStream(QObject *parent = 0);
+
+    QString m_module;
+    QMutex m_mutex;
+    std::atomic<bool> m_active;
+    QVector<Read> m_ring;
+    // Index of the oldest reading and number of readings in the ring
+    int m_head;
+    int m_count;
+    // Readings dropped by a full ring since the last message
+    int m_dropped;
+    QTimer *m_flushTimer;
+};
+
+#endif // LIVESTREAM_H
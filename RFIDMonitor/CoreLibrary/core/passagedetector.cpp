@@ -0,0 +1,296 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QTimer>
+
+#include <limits>
+
+#include <logger.h>
+#include <rfidmonitor.h>
+#include <object/rfiddata.h>
+#include <json/rfidmonitorsettings.h>
+
+#include "interfaces.h"
+#include "executor.h"
+#include "clock.h"
+#include "passagedetector.h"
+
+namespace {
+/*!
+ * \brief KSweepInterval is the interval, in milliseconds, between the checks for visits to close.
+ */
+const int KSweepInterval = 1000;
+
+/*!
+ * \brief KRecoverBatch is the number of readings read at once by recover().
+ */
+const int KRecoverBatch = 10000;
+}
+
+PassageDetector::PassageDetector(QObject *parent) :
+    QObject(parent),
+    m_module("PassageDetector"),
+    m_sweepTimer(new QTimer(this)),
+    m_enabled(false),
+    m_rawReads(true),
+    m_window(0)
+{
+    m_sweepTimer->setInterval(KSweepInterval);
+    connect(m_sweepTimer, SIGNAL(timeout()), SLOT(sweep()));
+}
+
+PassageDetector *PassageDetector::instance()
+{
+    static PassageDetector *singleton = 0;
+    if(!singleton){
+        singleton = new PassageDetector(qApp);
+    }
+    return singleton;
+}
+
+void PassageDetector::configure(const json::PassageSettings &settings)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_enabled = settings.enabled() && settings.window() > 0;
+    // Without the passages the readings are the only thing the server gets
+    m_rawReads = !m_enabled || settings.rawReads();
+    m_window = qint64(settings.window()) * 1000;
+    m_positions.clear();
+    QList<int> antennas = settings.antennas();
+    for(int i = 0; i < antennas.size(); i++){
+        m_positions.insert(antennas.at(i), i);
+    }
+
+    if(m_enabled){
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Passage detection: window %1 ms, raw reads %2").arg(settings.window()).arg(m_rawReads ? "on" : "off"));
+        QMetaObject::invokeMethod(m_sweepTimer, "start");
+    }else{
+        QMetaObject::invokeMethod(m_sweepTimer, "stop");
+    }
+}
+
+bool PassageDetector::isEnabled()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+bool PassageDetector::rawReads()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rawReads;
+}
+
+void PassageDetector::feed(const QList<Rfiddata *> &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_enabled)
+        return;
+
+    foreach (Rfiddata *rfiddata, data) {
+        qlonglong code = rfiddata->identificationcode().toLongLong();
+        int antenna = rfiddata->idantena().toInt();
+        qint64 timestamp = rfiddata->timestamp();
+
+        QHash<qlonglong, Visit>::iterator it = m_visits.find(code);
+        // The tag left and came back before the sweep: the previous visit is a passage of its own
+        if(it != m_visits.end() && timestamp - it.value().lastSeen > m_window){
+            close(code, it.value());
+            m_visits.erase(it);
+            it = m_visits.end();
+        }
+
+        if(it == m_visits.end()){
+            Visit visit;
+            visit.firstSeen = timestamp;
+            visit.lastSeen = timestamp;
+            visit.collectorPoint = rfiddata->idpontocoleta().toInt();
+            visit.antennas.append(antenna);
+            visit.reads = 1;
+            if(!m_rawReads)
+                visit.ids.append(rfiddata->id().toLongLong());
+            m_visits.insert(code, visit);
+            continue;
+        }
+
+        Visit &visit = it.value();
+        // The readers are independent, a batch is not strictly ordered by time
+        visit.firstSeen = qMin(visit.firstSeen, timestamp);
+        visit.lastSeen = qMax(visit.lastSeen, timestamp);
+        if(visit.antennas.last() != antenna)
+            visit.antennas.append(antenna);
+        visit.reads++;
+        if(!m_rawReads)
+            visit.ids.append(rfiddata->id().toLongLong());
+    }
+}
+
+void PassageDetector::recover()
+{
+    if(!isEnabled() || rawReads())
+        return;
+
+    PersistenceInterface *persister = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+    if(!persister)
+        return;
+
+    // In batches of consecutive ids, the readings of a long offline period are not loaded at once
+    qlonglong lastId = 0;
+    int recovered = 0;
+    forever {
+        SelectQuery<Rfiddata> pending;
+        pending.where(Rfiddata::Column::KSync, Rfiddata::KNotSynced)
+                .between(Rfiddata::Column::KId, lastId + 1, std::numeric_limits<qlonglong>::max())
+                .orderBy(Rfiddata::Column::KId)
+                .limit(KRecoverBatch);
+        QList<Rfiddata *> data = persister->select(pending, 0);
+        if(data.isEmpty())
+            break;
+        feed(data);
+        recovered += data.size();
+        lastId = data.last()->id().toLongLong();
+        bool full = (data.size() == KRecoverBatch);
+        qDeleteAll(data);
+        if(!full)
+            break;
+    }
+
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Recovered %1 readings not yet in a passage").arg(recovered));
+}
+
+bool PassageDetector::takeClosed(QJsonArray &passages, QList<qlonglong> &ids)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_closed.isEmpty())
+        return false;
+    passages = m_closed;
+    ids = m_closedIds;
+    m_closed = QJsonArray();
+    m_closedIds.clear();
+    return true;
+}
+
+void PassageDetector::putBack(const QJsonArray &passages, const QList<qlonglong> &ids)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // In front of the passages closed meanwhile, to keep their order
+    QJsonArray closed = passages;
+    for(int i = 0; i < m_closed.size(); i++){
+        closed.append(m_closed.at(i));
+    }
+    m_closed = closed;
+    m_closedIds = ids + m_closedIds;
+}
+
+QString PassageDetector::directionName(PassageDetector::Direction direction)
+{
+    switch (direction) {
+    case Direction::KUpstream:
+        return "upstream";
+    case Direction::KDownstream:
+        return "downstream";
+    default:
+        return "none";
+    }
+}
+
+void PassageDetector::sweep()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+
+        qint64 limit = Clock::now() - m_window;
+        QHash<qlonglong, Visit>::iterator it = m_visits.begin();
+        while(it != m_visits.end()){
+            if(it.value().lastSeen < limit){
+                close(it.key(), it.value());
+                it = m_visits.erase(it);
+            }else{
+                ++it;
+            }
+        }
+        if(m_closed.isEmpty())
+            return;
+    }
+
+    // The packager stores the passages in a packet, sent with the DATA packets when the server is connected
+    SynchronizationInterface *synchronizer = RFIDMonitor::instance()->defaultService<SynchronizationInterface>();
+    if(synchronizer)
+        Executor::instance()->submit("sync", [synchronizer](){ synchronizer->readyRead(); });
+}
+
+void PassageDetector::close(qlonglong identificationCode, const PassageDetector::Visit &visit)
+{
+    m_closed.append(passage(identificationCode, visit));
+    m_closedIds.append(visit.ids);
+}
+
+PassageDetector::Direction PassageDetector::direction(const PassageDetector::Visit &visit) const
+{
+    int first = visit.antennas.first();
+    int last = visit.antennas.last();
+    if(!m_positions.isEmpty()){
+        // An antenna out of the configured order says nothing about the direction
+        if(!m_positions.contains(first) || !m_positions.contains(last))
+            return Direction::KNone;
+        first = m_positions.value(first);
+        last = m_positions.value(last);
+    }
+
+    if(last > first)
+        return Direction::KUpstream;
+    if(last < first)
+        return Direction::KDownstream;
+    return Direction::KNone;
+}
+
+QJsonObject PassageDetector::passage(qlonglong identificationCode, const PassageDetector::Visit &visit) const
+{
+    QJsonArray antennas;
+    foreach (int antenna, visit.antennas) {
+        antennas.append(antenna);
+    }
+
+    QJsonObject obj;
+    obj.insert("identificationcode", QJsonValue::fromVariant(identificationCode));
+    obj.insert("idpontocoleta", visit.collectorPoint);
+    obj.insert("direction", directionName(direction(visit)));
+    obj.insert("firstseen", Clock::toIsoString(visit.firstSeen));
+    obj.insert("lastseen", Clock::toIsoString(visit.lastSeen));
+    // Milliseconds between the first and the last reading
+    obj.insert("dwell", double((visit.lastSeen - visit.firstSeen) / 1000));
+    obj.insert("antennas", antennas);
+    obj.insert("reads", visit.reads);
+    return obj;
+}
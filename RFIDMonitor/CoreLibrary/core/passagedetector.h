@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef PASSAGEDETECTOR_H
+#define PASSAGEDETECTOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QJsonArray>
+#include <QJsonObject>
+
+class QTimer;
+class Rfiddata;
+
+namespace json {
+class PassageSettings;
+}
+
+/*!
+ * \brief The PassageDetector class fuses the readings of the antennas into passage events, one per visit of a tag to the ladder.
+ *
+ * A visit starts with the first reading of a tag and is closed when the tag is not read for the configured window.
+ * Each closed visit becomes a passage with the direction (from the order of the antennas it was read on), the first and last time it was seen,
+ * the dwell, the antennas and the number of readings. The closed passages wait in the detector until the packager takes them with takeClosed()
+ * and stores them in a packet, which is sent in a PASSAGE message and acknowledged like the DATA packets.
+ *
+ * Without the raw readings on the uplink, each visit also keeps the ids of its readings. The readings stay not synchronized until the packet
+ * of their passage is stored, then the packager deletes them. After a restart recover() feeds the readings left, so no visit is lost.
+ *
+ * The detector is fed with each batch committed by the IngestJournal, and the visits are closed by sweep(), every KSweepInterval, in the main thread.
+ * It is off unless "passages" is enabled in the settings.
+ */
+class PassageDetector : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Direction { KNone, KUpstream, KDownstream };
+
+    static PassageDetector * instance();
+
+    /*!
+     * \brief configure applies the "passages" object of the settings and starts the sweep when enabled. Must be called before the journal replay.
+     */
+    void configure(const json::PassageSettings &settings);
+
+    bool isEnabled();
+
+    /*!
+     * \brief rawReads is false when the passages replace the readings on the uplink: the packager builds no packet of readings, they are deleted once their passage is stored.
+     */
+    bool rawReads();
+
+    /*!
+     * \brief feed adds readings just committed to the persistence service to the visits of their tags.
+     */
+    void feed(const QList<Rfiddata *> &data);
+
+    /*!
+     * \brief recover feeds the readings still not synchronized in the default persistence service, when the raw readings are off.
+     * Must be called after configure() and before the journal replay.
+     */
+    void recover();
+
+    /*!
+     * \brief takeClosed moves the closed passages to \a passages and the ids of their readings (only without the raw readings) to \a ids.
+     * \return false if there is no closed passage.
+     */
+    bool takeClosed(QJsonArray &passages, QList<qlonglong> &ids);
+
+    /*!
+     * \brief putBack gives back passages taken by takeClosed() that could not be stored, they are taken again the next time.
+     */
+    void putBack(const QJsonArray &passages, const QList<qlonglong> &ids);
+
+    static QString directionName(Direction direction);
+
+public slots:
+    /*!
+     * \brief sweep closes the visits not read for the window and asks the synchronization service to store them.
+     */
+    void sweep();
+
+private:
+    /*!
+     * \brief The Visit struct is the state of one tag while it is at the ladder. The times are timestamps of Clock.
+     */
+    struct Visit
+    {
+        qint64 firstSeen;
+        qint64 lastSeen;
+        int collectorPoint;
+        // The antennas in the order they read the tag, without repetitions in a row
+        QList<int> antennas;
+        int reads;
+        // Ids of the readings, kept only without the raw readings
+        QList<qlonglong> ids;
+    };
+
+    explicit PassageDetector(QObject *parent = 0);
+
+    Direction direction(const Visit &visit) const;
+    QJsonObject passage(qlonglong identificationCode, const Visit &visit) const;
+    void close(qlonglong identificationCode, const Visit &visit);
+
+    QString m_module;
+    QMutex m_mutex;
+    QHash<qlonglong, Visit> m_visits;
+    // Closed by feed() or sweep(), waiting for takeClosed()
+    QJsonArray m_closed;
+    QList<qlonglong> m_closedIds;
+    QTimer *m_sweepTimer;
+    bool m_enabled;
+    bool m_rawReads;
+    qint64 m_window;
+    // Position of each antenna from downstream to upstream. Empty means the ascending order of the antenna numbers.
+    QHash<int, int> m_positions;
+};
+
+#endif // PASSAGEDETECTOR_H
@@ -0,0 +1,358 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <errno.h>
+#include <libudev.h>
+#include <linux/serial.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include <QFileInfo>
+#include <QSerialPortInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <logger.h>
+
+#include "serialconnection.h"
+
+namespace {
+
+/*!
+ * \brief KMinRetryDelay is the delay, in milliseconds, before the first retry to open the device.
+ */
+const int KMinRetryDelay = 250;
+
+/*!
+ * \brief KMaxRetryDelay is the maximum delay, in milliseconds, between two retries to open the device.
+ */
+const int KMaxRetryDelay = 30000;
+
+/*!
+ * \brief KProbeBaudRates are the rates tried, fastest first, when the baud rate is detected.
+ */
+const qint32 KProbeBaudRates[] = {115200, 57600, 38400, 19200, 9600};
+const int KProbeBaudRateCount = sizeof(KProbeBaudRates) / sizeof(KProbeBaudRates[0]);
+
+/*!
+ * \brief KProbeInterval is the time, in milliseconds, each rate is listened to for a valid frame.
+ */
+const int KProbeInterval = 2000;
+
+}
+
+SerialConnection::SerialConnection(const QString &module, QObject *parent) :
+    QObject(parent),
+    m_module(module),
+    m_serial(new QSerialPort(this)),
+    m_retryTimer(new QTimer(this)),
+    m_retryDelay(KMinRetryDelay),
+    m_failedAttempts(0),
+    m_active(false),
+    m_detectedBaudRate(0),
+    m_probing(false),
+    m_probeIndex(0),
+    m_probeTimer(new QTimer(this)),
+    m_lastRecoveryLatency(-1),
+    m_udev(0),
+    m_monitor(0),
+    m_notifier(0)
+{
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, SIGNAL(timeout()), SLOT(tryOpen()));
+    connect(m_serial, SIGNAL(error(QSerialPort::SerialPortError)), SLOT(handleError(QSerialPort::SerialPortError)));
+    connect(m_serial, SIGNAL(readyRead()), SLOT(portReadyRead()));
+
+    m_probeTimer->setSingleShot(true);
+    connect(m_probeTimer, SIGNAL(timeout()), SLOT(probeNextBaudRate()));
+}
+
+SerialConnection::~SerialConnection()
+{
+    close();
+}
+
+QSerialPort *SerialConnection::port() const
+{
+    return m_serial;
+}
+
+void SerialConnection::open(const QString &device)
+{
+    m_device = device;
+    m_active = true;
+    m_retryDelay = KMinRetryDelay;
+    m_failedAttempts = 0;
+    startListening();
+    tryOpen();
+}
+
+void SerialConnection::setLineSettings(const json::ReaderSettings &settings)
+{
+    m_lineSettings = settings;
+    m_detectedBaudRate = 0;
+}
+
+void SerialConnection::setFrameValidator(const std::function<bool (const QByteArray &)> &validator)
+{
+    m_validator = validator;
+}
+
+void SerialConnection::close()
+{
+    m_active = false;
+    m_probing = false;
+    m_probeTimer->stop();
+    m_retryTimer->stop();
+    stopListening();
+    if(m_serial->isOpen())
+        m_serial->close();
+}
+
+void SerialConnection::frameReceived()
+{
+    if(!m_lostTimer.isValid())
+        return;
+
+    m_lastRecoveryLatency = m_lostTimer.elapsed();
+    m_lostTimer.invalidate();
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("First frame from %1 %2 ms after the device was lost").arg(m_device).arg(m_lastRecoveryLatency));
+}
+
+qint64 SerialConnection::lastRecoveryLatency() const
+{
+    return m_lastRecoveryLatency;
+}
+
+void SerialConnection::tryOpen()
+{
+    if(!m_active || m_serial->isOpen())
+        return;
+
+    m_serial->setPort(QSerialPortInfo(m_device));
+    if(m_serial->open(QIODevice::ReadWrite)){
+        if(m_failedAttempts > 0)
+            Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Device %1 opened after %2 failed attempts").arg(m_device).arg(m_failedAttempts));
+        else
+            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Device %1 opened").arg(m_device));
+        m_retryDelay = KMinRetryDelay;
+        m_failedAttempts = 0;
+        // The symlink, if any, is gone when the remove event arrives, so the real node is kept
+        m_deviceNode = QFileInfo(m_device).canonicalFilePath();
+
+        if(m_lineSettings.readBufferSize() > 0)
+            m_serial->setReadBufferSize(m_lineSettings.readBufferSize());
+
+        qint32 baudRate = m_lineSettings.baudRate() > 0 ? m_lineSettings.baudRate() : m_detectedBaudRate;
+        if(baudRate > 0 || !m_validator){
+            applyLineSettings(baudRate > 0 ? baudRate : 9600);
+            emit opened();
+        }else{
+            // The readers only send frames when a tag passes, so the detection may take several rounds
+            Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Detecting the baud rate of %1").arg(m_device));
+            m_probing = true;
+            m_probeIndex = -1;
+            probeNextBaudRate();
+        }
+        return;
+    }
+
+    // One record per failure sequence, not one per retry
+    if(m_failedAttempts == 0)
+        Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Could not open device %1 - Error %2. Retrying up to every %3 s").arg(m_device).arg(m_serial->errorString()).arg(KMaxRetryDelay / 1000));
+    m_failedAttempts++;
+
+    m_retryTimer->start(m_retryDelay);
+    m_retryDelay = qMin(m_retryDelay * 2, KMaxRetryDelay);
+}
+
+void SerialConnection::handleError(QSerialPort::SerialPortError error)
+{
+    switch (error) {
+    case QSerialPort::NoError:
+        break;
+    case QSerialPort::ResourceError:
+    case QSerialPort::DeviceNotFoundError:
+        // The open failures are handled by tryOpen(), this is a device lost while open
+        if(m_serial->isOpen())
+            deviceLost(m_serial->errorString());
+        break;
+    default:
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error: %1").arg(m_serial->errorString()));
+        break;
+    }
+}
+
+void SerialConnection::deviceLost(const QString &reason)
+{
+    Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Device %1 lost: %2").arg(m_device).arg(reason));
+    m_probing = false;
+    m_probeTimer->stop();
+    m_serial->close();
+    if(!m_lostTimer.isValid())
+        m_lostTimer.start();
+    emit lost();
+
+    if(m_active){
+        m_retryDelay = KMinRetryDelay;
+        m_retryTimer->start(m_retryDelay);
+    }
+}
+
+bool SerialConnection::isOurDevice(const char *devnode) const
+{
+    if(!devnode)
+        return false;
+    QString node(devnode);
+    // The configured device may be a udev symlink, e.g. /dev/serial/by-id/...
+    return node == m_device || node == QFileInfo(m_device).canonicalFilePath();
+}
+
+void SerialConnection::startListening()
+{
+    if(m_monitor)
+        return;
+
+    m_udev = udev_new();
+    if(!m_udev){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, "Can't create udev, the device is reopened only by the retries");
+        return;
+    }
+    m_monitor = udev_monitor_new_from_netlink(m_udev, "udev");
+    if(!m_monitor){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, "Can't create the udev monitor, the device is reopened only by the retries");
+        stopListening();
+        return;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype(m_monitor, "tty", NULL);
+    udev_monitor_enable_receiving(m_monitor);
+
+    m_notifier = new QSocketNotifier(udev_monitor_get_fd(m_monitor), QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), SLOT(receiveDevice()));
+}
+
+void SerialConnection::stopListening()
+{
+    if(m_notifier){
+        delete m_notifier;
+        m_notifier = 0;
+    }
+    if(m_monitor){
+        udev_monitor_unref(m_monitor);
+        m_monitor = 0;
+    }
+    if(m_udev){
+        udev_unref(m_udev);
+        m_udev = 0;
+    }
+}
+
+void SerialConnection::receiveDevice()
+{
+    struct udev_device *dev = udev_monitor_receive_device(m_monitor);
+    if(!dev)
+        return;
+
+    const char *action = udev_device_get_action(dev);
+    const char *devnode = udev_device_get_devnode(dev);
+    if(action && strcmp(action, "remove") == 0 && m_serial->isOpen() && devnode && QString(devnode) == m_deviceNode){
+        // The remove event usually comes before the error of the port
+        deviceLost("removed");
+    }else if(action && strcmp(action, "add") == 0 && m_active && !m_serial->isOpen() && isOurDevice(devnode)){
+        // The device is back, don't wait for the next retry
+        m_retryTimer->stop();
+        tryOpen();
+    }
+    udev_device_unref(dev);
+}
+
+void SerialConnection::portReadyRead()
+{
+    if(!m_probing){
+        emit readyRead();
+        return;
+    }
+
+    while(m_serial->canReadLine()){
+        QByteArray line = m_serial->readLine();
+        if(m_validator(line)){
+            m_probing = false;
+            m_probeTimer->stop();
+            m_detectedBaudRate = m_serial->baudRate();
+            Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Baud rate of %1 detected: %2").arg(m_device).arg(m_detectedBaudRate));
+            emit opened();
+            // The frame of the probe is lost, the reader sees the next ones
+            if(m_serial->bytesAvailable() > 0)
+                emit readyRead();
+            return;
+        }
+    }
+    // Garbage of a wrong rate may never contain a line ending
+    if(m_serial->bytesAvailable() > 4096)
+        m_serial->clear(QSerialPort::Input);
+}
+
+void SerialConnection::probeNextBaudRate()
+{
+    if(!m_probing || !m_serial->isOpen())
+        return;
+
+    m_probeIndex = (m_probeIndex + 1) % KProbeBaudRateCount;
+    applyLineSettings(KProbeBaudRates[m_probeIndex]);
+    m_serial->clear(QSerialPort::Input);
+    m_probeTimer->start(KProbeInterval);
+}
+
+void SerialConnection::applyLineSettings(qint32 baudRate)
+{
+    m_serial->setBaudRate(baudRate);
+    m_serial->setDataBits(QSerialPort::DataBits(qBound(5, m_lineSettings.dataBits(), 8)));
+    m_serial->setStopBits(m_lineSettings.stopBits() == 2 ? QSerialPort::TwoStop : QSerialPort::OneStop);
+    if(m_lineSettings.parity() == "even")
+        m_serial->setParity(QSerialPort::EvenParity);
+    else if(m_lineSettings.parity() == "odd")
+        m_serial->setParity(QSerialPort::OddParity);
+    else
+        m_serial->setParity(QSerialPort::NoParity);
+    m_serial->setFlowControl(QSerialPort::NoFlowControl);
+    if(m_lineSettings.lowLatency())
+        setLowLatency();
+}
+
+void SerialConnection::setLowLatency()
+{
+    int fd = m_serial->handle();
+
+    // Drivers like ftdi_sio set their latency timer to 1 ms (16 ms by default) when asked for low latency
+    struct serial_struct serial;
+    if(::ioctl(fd, TIOCGSERIAL, &serial) == 0){
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if(::ioctl(fd, TIOCSSERIAL, &serial) != 0)
+            Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Can't set the low latency mode of %1: %2").arg(m_device).arg(strerror(errno)));
+    }
+}
@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef SERIALCONNECTION_H
+#define SERIALCONNECTION_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSerialPort>
+
+#include <functional>
+
+#include <json/rfidmonitorsettings.h>
+
+class QSocketNotifier;
+class QTimer;
+struct udev;
+struct udev_monitor;
+
+/*!
+ * \brief The SerialConnection class keeps the serial port of a reader open.
+ *
+ * When the device can't be opened, or is lost (USB reset, cable unplugged), the port is closed and reopened with an exponential backoff,
+ * from KMinRetryDelay to KMaxRetryDelay. A udev monitor on the tty subsystem reopens the port as soon as the device node reappears,
+ * without waiting for the next retry. Only the first failure of a sequence is logged.
+ *
+ * The reader calls frameReceived() for every complete frame; the time from the loss of the device to the first frame after it is logged
+ * and kept in lastRecoveryLatency().
+ *
+ * The line (baud rate, data bits, parity, stop bits) comes from the settings of the reader and is applied at every open. With a baud rate of zero
+ * the rate is detected: the common rates are tried in turn until the frame validator of the reader accepts a line. The detected rate is kept for
+ * the next reopens. The optional low latency mode sets ASYNC_LOW_LATENCY on the tty after the line settings, so drivers like ftdi_sio
+ * don't hold a frame in their latency timer. VMIN and VTIME are not used: QSerialPort opens the tty non-blocking, where they have no effect.
+ */
+class SerialConnection : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SerialConnection(const QString &module, QObject *parent = 0);
+    ~SerialConnection();
+
+    /*!
+     * \brief port is the serial port managed by the connection. The reader reads and writes it, but never opens or closes it.
+     */
+    QSerialPort * port() const;
+
+    /*!
+     * \brief open starts opening \a device, retrying until it succeeds or close() is called.
+     */
+    void open(const QString &device);
+
+    /*!
+     * \brief setLineSettings sets the serial line used by the next open().
+     */
+    void setLineSettings(const json::ReaderSettings &settings);
+
+    /*!
+     * \brief setFrameValidator sets the function that recognizes a valid frame (one line, with the line ending) of the reader, used to detect the baud rate.
+     */
+    void setFrameValidator(const std::function<bool(const QByteArray &)> &validator);
+
+    /*!
+     * \brief close closes the port and stops the retries.
+     */
+    void close();
+
+    /*!
+     * \brief frameReceived must be called by the reader for every complete frame read from the port.
+     */
+    void frameReceived();
+
+    /*!
+     * \brief lastRecoveryLatency returns the time, in milliseconds, from the last loss of the device to the first frame after it, or -1 if the device was never lost.
+     */
+    qint64 lastRecoveryLatency() const;
+
+signals:
+    /*!
+     * \brief opened is emitted every time the port is (re)opened, so the reader can set the line parameters.
+     */
+    void opened();
+
+    /*!
+     * \brief lost is emitted when the device is lost and the connection starts reopening it.
+     */
+    void lost();
+
+    /*!
+     * \brief readyRead is emitted when there is data for the reader. The reader must use it instead of the signal of the port,
+     * which is also emitted while the baud rate is being detected.
+     */
+    void readyRead();
+
+private slots:
+    void tryOpen();
+    void portReadyRead();
+    void probeNextBaudRate();
+    void handleError(QSerialPort::SerialPortError error);
+    void receiveDevice();
+
+private:
+    void deviceLost(const QString &reason);
+    void applyLineSettings(qint32 baudRate);
+    void setLowLatency();
+    bool isOurDevice(const char *devnode) const;
+    void startListening();
+    void stopListening();
+
+    QString m_module;
+    QString m_device;
+    QString m_deviceNode;
+    QSerialPort *m_serial;
+    QTimer *m_retryTimer;
+    int m_retryDelay;
+    int m_failedAttempts;
+    bool m_active;
+
+    json::ReaderSettings m_lineSettings;
+    std::function<bool(const QByteArray &)> m_validator;
+    qint32 m_detectedBaudRate;
+    bool m_probing;
+    int m_probeIndex;
+    QTimer *m_probeTimer;
+
+    QElapsedTimer m_lostTimer;
+    qint64 m_lastRecoveryLatency;
+
+    struct udev *m_udev;
+    struct udev_monitor *m_monitor;
+    QSocketNotifier *m_notifier;
+};
+
+#endif // SERIALCONNECTION_H
@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QObject>
+#include <QSqlDatabase>
+
+#include "selectquery.h"
+#include "sqlquery.h"
+#include "statementcache.h"
+
+QueryBuilder::QueryBuilder(const QStringList &columns) :
+    m_columns(columns),
+    m_order(Order::KAscending),
+    m_limit(-1)
+{
+}
+
+QString QueryBuilder::sql(const QString &table) const
+{
+    QString statement(QString("select %1 from %2").arg(m_columns.join(", ")).arg(table));
+
+    QStringList where;
+    foreach (const Condition &condition, m_conditions) {
+        switch (condition.op) {
+        case Operator::KEqual:
+            where.append(QString("%1 = ?").arg(condition.column));
+            break;
+        case Operator::KBetween:
+            where.append(QString("%1 between ? and ?").arg(condition.column));
+            break;
+        case Operator::KIn:{
+            QStringList placeholders;
+            for(int i = 0; i < condition.values.size(); i++)
+                placeholders.append("?");
+            where.append(QString("%1 in (%2)").arg(condition.column).arg(placeholders.join(", ")));
+            break;
+        }
+        }
+    }
+    if(!where.isEmpty())
+        statement.append(QString(" where %1").arg(where.join(" and ")));
+
+    if(!m_orderColumn.isEmpty())
+        statement.append(QString(" order by %1 %2").arg(m_orderColumn).arg(m_order == Order::KAscending ? "asc" : "desc"));
+    if(m_limit >= 0)
+        statement.append(" limit ?");
+    return statement;
+}
+
+void QueryBuilder::bind(SqlQuery &query) const
+{
+    int position = 0;
+    foreach (const Condition &condition, m_conditions) {
+        foreach (const QVariant &value, condition.values) {
+            query.bindValue(position++, value);
+        }
+    }
+    if(m_limit >= 0)
+        query.bindValue(position, m_limit);
+}
+
+void QueryBuilder::exec(SqlQuery &query, QSqlDatabase *db, const QString &table) const throw(SqlException)
+{
+    query = StatementCache::instance()->statement(db, sql(table));
+    bind(query);
+    query.exec();
+}
+
+bool QueryBuilder::matches(const QObject *object) const
+{
+    foreach (const Condition &condition, m_conditions) {
+        QVariant value(object->property(condition.column.toLatin1().constData()));
+        switch (condition.op) {
+        case Operator::KEqual:
+            if(value != condition.values.first())
+                return false;
+            break;
+        case Operator::KBetween:
+            if(value.toLongLong() < condition.values.at(0).toLongLong() || value.toLongLong() > condition.values.at(1).toLongLong())
+                return false;
+            break;
+        case Operator::KIn:
+            if(!condition.values.contains(value))
+                return false;
+            break;
+        }
+    }
+    return true;
+}
+
+bool QueryBuilder::range(const QString &column, QVariant &from, QVariant &to) const
+{
+    foreach (const Condition &condition, m_conditions) {
+        if(condition.op == Operator::KBetween && condition.column == column){
+            from = condition.values.at(0);
+            to = condition.values.at(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList QueryBuilder::columns() const
+{
+    return m_columns;
+}
+
+QString QueryBuilder::orderColumn() const
+{
+    return m_orderColumn;
+}
+
+QueryBuilder::Order QueryBuilder::order() const
+{
+    return m_order;
+}
+
+int QueryBuilder::limit() const
+{
+    return m_limit;
+}
+
+void QueryBuilder::setColumns(const QStringList &columns)
+{
+    m_columns = columns;
+}
+
+void QueryBuilder::addEqual(const QString &column, const QVariant &value)
+{
+    Condition condition;
+    condition.op = Operator::KEqual;
+    condition.column = column;
+    condition.values << value;
+    m_conditions.append(condition);
+}
+
+void QueryBuilder::addBetween(const QString &column, const QVariant &from, const QVariant &to)
+{
+    Condition condition;
+    condition.op = Operator::KBetween;
+    condition.column = column;
+    condition.values << from << to;
+    m_conditions.append(condition);
+}
+
+void QueryBuilder::addIn(const QString &column, const QVariantList &values)
+{
+    Condition condition;
+    condition.op = Operator::KIn;
+    condition.column = column;
+    condition.values = values;
+    m_conditions.append(condition);
+}
+
+void QueryBuilder::setOrder(const QString &column, Order order)
+{
+    m_orderColumn = column;
+    m_order = order;
+}
+
+void QueryBuilder::setLimit(int limit)
+{
+    m_limit = limit;
+}
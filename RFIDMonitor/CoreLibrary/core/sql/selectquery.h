@@ -0,0 +1,198 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef SELECTQUERY_H
+#define SELECTQUERY_H
+
+#include <initializer_list>
+
+#include <QList>
+#include <QStringList>
+#include <QVariant>
+
+#include "exception/sqlexception.h"
+
+class QObject;
+class QSqlDatabase;
+class SqlQuery;
+
+/*!
+ * \brief The QueryBuilder class generates a parameterized select from a projection, conditions joined by "and", an order and a limit.
+ * The values are always bound, never written in the SQL, so the same lookup with other values reuses the statement (see StatementCache).
+ *
+ * The columns are given by the typed interface of SelectQuery, this class only knows their names.
+ */
+class QueryBuilder
+{
+public:
+    enum class Order {KAscending = 0, KDescending};
+
+    /*!
+     * \brief sql returns the statement for \a table, with one '?' for each value.
+     */
+    QString sql(const QString &table) const;
+
+    /*!
+     * \brief bind binds the values of the conditions and the limit, in the order of the placeholders of sql().
+     */
+    void bind(SqlQuery &query) const;
+
+    /*!
+     * \brief exec executes the query on \a table with a cached statement of \a db. The caller reads the rows and then calls query.finish().
+     */
+    void exec(SqlQuery &query, QSqlDatabase *db, const QString &table) const throw(SqlException);
+
+    /*!
+     * \brief matches evaluates the conditions on the properties of \a object with the names of the columns, used by the backends without SQL.
+     * BETWEEN compares the values as integers.
+     */
+    bool matches(const QObject *object) const;
+
+    /*!
+     * \brief range gives the bounds of the BETWEEN condition on \a column, so a partitioned table can skip the partitions out of it.
+     * \return false if there is no such condition.
+     */
+    bool range(const QString &column, QVariant &from, QVariant &to) const;
+
+    QStringList columns() const;
+    QString orderColumn() const;
+    Order order() const;
+    /*!
+     * \brief limit is the maximum number of rows, or -1 without limit.
+     */
+    int limit() const;
+
+protected:
+    explicit QueryBuilder(const QStringList &columns);
+
+    void setColumns(const QStringList &columns);
+    void addEqual(const QString &column, const QVariant &value);
+    void addBetween(const QString &column, const QVariant &from, const QVariant &to);
+    void addIn(const QString &column, const QVariantList &values);
+    void setOrder(const QString &column, Order order);
+    void setLimit(int limit);
+
+private:
+    enum class Operator {KEqual = 0, KBetween, KIn};
+
+    struct Condition
+    {
+        Operator op;
+        QString column;
+        QVariantList values;
+    };
+
+    QStringList m_columns;
+    QList<Condition> m_conditions;
+    QString m_orderColumn;
+    Order m_order;
+    int m_limit;
+};
+
+/*!
+ * \brief The SelectQuery class is the typed interface of QueryBuilder for the objects persisted by a DAO.
+ *
+ * \a Object declares the enum of its columns and their names:
+ *
+ *     enum class Column {KId = 0, ...};
+ *     static const int KColumnCount;
+ *     static const char * columnName(Column column);
+ *
+ * and its QSqlRecord constructor reads the fields by name, so any projection can be given to it.
+ * Example, the 100 oldest readings not synchronized:
+ *
+ *     SelectQuery<Rfiddata>().where(Rfiddata::Column::KSync, Rfiddata::KNotSynced).orderBy(Rfiddata::Column::KId).limit(100)
+ */
+template <class Object>
+class SelectQuery : public QueryBuilder
+{
+public:
+    typedef typename Object::Column Column;
+
+    SelectQuery() :
+        QueryBuilder(allColumns())
+    {
+    }
+
+    /*!
+     * \brief columns restricts the projection to \a columns, all columns are selected by default.
+     */
+    SelectQuery & columns(std::initializer_list<Column> columns)
+    {
+        QStringList names;
+        for(Column column : columns)
+            names.append(Object::columnName(column));
+        setColumns(names);
+        return *this;
+    }
+
+    SelectQuery & where(Column column, const QVariant &value)
+    {
+        addEqual(Object::columnName(column), value);
+        return *this;
+    }
+
+    SelectQuery & between(Column column, const QVariant &from, const QVariant &to)
+    {
+        addBetween(Object::columnName(column), from, to);
+        return *this;
+    }
+
+    SelectQuery & in(Column column, const QVariantList &values)
+    {
+        addIn(Object::columnName(column), values);
+        return *this;
+    }
+
+    SelectQuery & orderBy(Column column, Order order = Order::KAscending)
+    {
+        setOrder(Object::columnName(column), order);
+        return *this;
+    }
+
+    SelectQuery & limit(int limit)
+    {
+        setLimit(limit);
+        return *this;
+    }
+
+    using QueryBuilder::columns;
+    using QueryBuilder::limit;
+
+private:
+    static QStringList allColumns()
+    {
+        QStringList names;
+        for(int i = 0; i < Object::KColumnCount; i++)
+            names.append(Object::columnName(Column(i)));
+        return names;
+    }
+};
+
+#endif // SELECTQUERY_H
@@ -0,0 +1,87 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QThread>
+
+#include "statementcache.h"
+
+namespace {
+/*!
+ * \brief KMaxStatements is the maximum number of statements kept by connection and thread. An IN list of another size is another statement.
+ */
+const int KMaxStatements = 64;
+}
+
+StatementCache::StatementCache() :
+    m_statements(KMaxStatements)
+{
+}
+
+StatementCache *StatementCache::instance()
+{
+    static StatementCache singleton;
+    return &singleton;
+}
+
+QSqlQuery StatementCache::statement(QSqlDatabase *db, const QString &sql)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString k(key(db, sql));
+    QSqlQuery *query = m_statements.object(k);
+    if(!query){
+        query = new QSqlQuery(*db);
+        query->setForwardOnly(true);
+        if(!query->prepare(sql)){
+            // Not cached: exec() reports the error of the statement
+            QSqlQuery failed(*query);
+            delete query;
+            return failed;
+        }
+        m_statements.insert(k, query);
+    }
+    return *query;
+}
+
+void StatementCache::clear(QSqlDatabase *db)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString prefix(QString("%1/").arg(db->connectionName()));
+    foreach (const QString &k, m_statements.keys()) {
+        if(k.startsWith(prefix))
+            m_statements.remove(k);
+    }
+}
+
+QString StatementCache::key(QSqlDatabase *db, const QString &sql) const
+{
+    return QString("%1/%2/%3").arg(db->connectionName()).arg(quintptr(QThread::currentThread())).arg(sql);
+}
@@ -0,0 +1,74 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QSqlQuery>
+#include <QString>
+
+class QSqlDatabase;
+
+/*!
+ * \brief The StatementCache class keeps the prepared statements of the queries built by SelectQuery, so a lookup repeated by the DAOs
+ * is compiled by the database only once.
+ *
+ * The statements are kept per connection and per thread (a QSqlQuery must not be shared between threads). At most KMaxStatements
+ * are kept, the least recently used is finalized first.
+ * A statement returned by statement() must be finish()ed after its rows are read, otherwise it keeps a read lock on the database
+ * and a DROP TABLE of the same connection fails.
+ */
+class StatementCache
+{
+public:
+    static StatementCache * instance();
+
+    /*!
+     * \brief statement returns the statement of \a sql prepared on \a db, preparing it on the first use.
+     * The bound values of the previous use are replaced by the new ones.
+     */
+    QSqlQuery statement(QSqlDatabase *db, const QString &sql);
+
+    /*!
+     * \brief clear finalizes all statements of \a db, used after a change of the schema.
+     */
+    void clear(QSqlDatabase *db);
+
+private:
+    StatementCache();
+
+    QString key(QSqlDatabase *db, const QString &sql) const;
+
+    QMutex m_mutex;
+    QCache<QString, QSqlQuery> m_statements;
+};
+
+#endif // STATEMENTCACHE_H
@@ -0,0 +1,252 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QReadLocker>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QWriteLocker>
+
+#include <algorithm>
+#include <vector>
+
+#include <logger.h>
+
+#include "tagfilter.h"
+
+namespace {
+/*!
+ * \brief KFileName is the file with the current filter: the mode in the first line, then one code per line.
+ */
+const char *KFileName = "tagfilter.txt";
+
+const int KBitsPerCode = 10;
+const int KProbes = 7;
+
+quint64 mix(quint64 value)
+{
+    // splitmix64 finalizer, spreads consecutive codes over the whole filter
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+}
+
+struct TagFilter::Set
+{
+    Mode mode;
+    std::vector<qlonglong> codes;
+    std::vector<quint64> bits;
+    quint64 mask;
+
+    Set(Mode m, const QList<qlonglong> &list) :
+        mode(m),
+        codes(list.begin(), list.end()),
+        mask(0)
+    {
+        std::sort(codes.begin(), codes.end());
+        codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+
+        // A power of two number of bits, so a probe is a mask instead of a division
+        quint64 size = 64;
+        while(size < quint64(codes.size()) * KBitsPerCode)
+            size <<= 1;
+        mask = size - 1;
+        bits.assign(size / 64, 0);
+        for(qlonglong code : codes){
+            quint64 hash = mix(quint64(code));
+            quint64 h1 = hash & 0xffffffffULL;
+            quint64 h2 = (hash >> 32) | 1;
+            for(int i = 0; i < KProbes; i++){
+                quint64 bit = (h1 + i * h2) & mask;
+                bits[bit >> 6] |= (quint64(1) << (bit & 63));
+            }
+        }
+    }
+
+    bool mayContain(qlonglong code) const
+    {
+        quint64 hash = mix(quint64(code));
+        quint64 h1 = hash & 0xffffffffULL;
+        quint64 h2 = (hash >> 32) | 1;
+        for(int i = 0; i < KProbes; i++){
+            quint64 bit = (h1 + i * h2) & mask;
+            if(!(bits[bit >> 6] & (quint64(1) << (bit & 63))))
+                return false;
+        }
+        return true;
+    }
+
+    bool contains(qlonglong code) const
+    {
+        return std::binary_search(codes.begin(), codes.end(), code);
+    }
+};
+
+TagFilter::TagFilter() :
+    m_checked(0),
+    m_dropped(0),
+    m_prefiltered(0),
+    m_falsePositives(0)
+{
+}
+
+TagFilter *TagFilter::instance()
+{
+    static TagFilter singleton;
+    return &singleton;
+}
+
+bool TagFilter::accept(qlonglong identificationCode)
+{
+    QReadLocker locker(&m_lock);
+    if(!m_set)
+        return true;
+
+    m_checked++;
+    bool listed = false;
+    if(!m_set->mayContain(identificationCode)){
+        m_prefiltered++;
+    }else if(m_set->contains(identificationCode)){
+        listed = true;
+    }else{
+        m_falsePositives++;
+    }
+
+    bool accepted = (m_set->mode == Mode::KAllow) ? listed : !listed;
+    if(!accepted)
+        m_dropped++;
+    return accepted;
+}
+
+bool TagFilter::load(TagFilter::Mode mode, const QList<qlonglong> &codes)
+{
+    // Built out of the lock, the readers keep using the current filter meanwhile
+    QSharedPointer<const Set> set;
+    if(mode != Mode::KNone)
+        set = QSharedPointer<const Set>(new Set(mode, codes));
+    {
+        QWriteLocker locker(&m_lock);
+        m_set = set;
+    }
+    m_checked = 0;
+    m_dropped = 0;
+    m_prefiltered = 0;
+    m_falsePositives = 0;
+    Logger::instance()->writeRecord(Logger::severity_level::info, "TagFilter", Q_FUNC_INFO, QString("Tag filter: %1, %2 codes").arg(modeName(mode)).arg(set ? set->codes.size() : 0));
+
+    QSaveFile file(fileName());
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, "TagFilter", Q_FUNC_INFO, QString("Can't save %1: %2").arg(file.fileName()).arg(file.errorString()));
+        return false;
+    }
+    QTextStream out(&file);
+    out << modeName(mode) << "\n";
+    if(set){
+        for(qlonglong code : set->codes)
+            out << code << "\n";
+    }
+    out.flush();
+    return file.commit();
+}
+
+void TagFilter::restore()
+{
+    QFile file(fileName());
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    QTextStream in(&file);
+    Mode mode = modeFromName(in.readLine().trimmed());
+    QList<qlonglong> codes;
+    while(!in.atEnd()){
+        bool ok;
+        qlonglong code = in.readLine().trimmed().toLongLong(&ok);
+        if(ok)
+            codes.append(code);
+    }
+
+    QSharedPointer<const Set> set;
+    if(mode != Mode::KNone)
+        set = QSharedPointer<const Set>(new Set(mode, codes));
+    QWriteLocker locker(&m_lock);
+    m_set = set;
+    Logger::instance()->writeRecord(Logger::severity_level::info, "TagFilter", Q_FUNC_INFO, QString("Tag filter restored: %1, %2 codes").arg(modeName(mode)).arg(set ? set->codes.size() : 0));
+}
+
+TagFilter::Mode TagFilter::mode()
+{
+    QReadLocker locker(&m_lock);
+    return m_set ? m_set->mode : Mode::KNone;
+}
+
+int TagFilter::size()
+{
+    QReadLocker locker(&m_lock);
+    return m_set ? int(m_set->codes.size()) : 0;
+}
+
+QString TagFilter::statistics()
+{
+    quint64 checked = m_checked;
+    quint64 prefiltered = m_prefiltered;
+    quint64 positives = checked - prefiltered;
+    quint64 falsePositives = m_falsePositives;
+    return QString("%1 (%2 codes): %3 checked, %4 dropped, %5% answered by the prefilter, %6% false positives")
+            .arg(modeName(mode())).arg(size()).arg(checked).arg(quint64(m_dropped))
+            .arg(checked ? 100.0 * prefiltered / checked : 0.0, 0, 'f', 1)
+            .arg(positives ? 100.0 * falsePositives / positives : 0.0, 0, 'f', 2);
+}
+
+TagFilter::Mode TagFilter::modeFromName(const QString &name)
+{
+    if(name == "allow")
+        return Mode::KAllow;
+    if(name == "deny")
+        return Mode::KDeny;
+    return Mode::KNone;
+}
+
+QString TagFilter::modeName(TagFilter::Mode mode)
+{
+    switch (mode) {
+    case Mode::KAllow:
+        return "allow";
+    case Mode::KDeny:
+        return "deny";
+    default:
+        return "none";
+    }
+}
+
+QString TagFilter::fileName() const
+{
+    return QCoreApplication::applicationDirPath() + "/" + KFileName;
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef TAGFILTER_H
+#define TAGFILTER_H
+
+#include <QList>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QString>
+
+#include <atomic>
+
+/*!
+ * \brief The TagFilter class decides which tags are persisted: all of them, only the tags of a list (allow) or all but the tags of a list (deny).
+ *
+ * The list comes from the server or the DeskApp in a TAG-FILTER message and is kept in KFileName, so it survives a restart.
+ * A code is first checked against a Bloom filter (about 10 bits per code, 7 probes), which rules out most codes that are not in the list
+ * without touching the list itself. A positive answer is confirmed by a binary search in the sorted list, so a false positive never
+ * changes the decision.
+ *
+ * A new list is built aside and swapped in under a write lock, the readers never see a half built filter.
+ */
+class TagFilter
+{
+public:
+    enum class Mode {KNone = 0, KAllow, KDeny};
+
+    static TagFilter * instance();
+
+    /*!
+     * \brief accept returns false when the reading of \a identificationCode must be dropped. Called by the readers for each reading.
+     */
+    bool accept(qlonglong identificationCode);
+
+    /*!
+     * \brief load builds the filter of \a codes, swaps it with the current one and saves it. KNone removes the filter.
+     * \return false if the filter could not be saved, it is used anyway until the next restart.
+     */
+    bool load(Mode mode, const QList<qlonglong> &codes);
+
+    /*!
+     * \brief restore loads the filter saved by the last load(). Must be called before the readers start.
+     */
+    void restore();
+
+    Mode mode();
+    int size();
+
+    /*!
+     * \brief statistics returns a one line summary of the counters (checked, dropped, answered by the prefilter, false positives), used in the log.
+     */
+    QString statistics();
+
+    static Mode modeFromName(const QString &name);
+    static QString modeName(Mode mode);
+
+private:
+    struct Set;
+
+    TagFilter();
+    QString fileName() const;
+
+    QReadWriteLock m_lock;
+    QSharedPointer<const Set> m_set;
+
+    std::atomic<quint64> m_checked;
+    std::atomic<quint64> m_dropped;
+    std::atomic<quint64> m_prefiltered;
+    std::atomic<quint64> m_falsePositives;
+};
+
+#endif // TAGFILTER_H
@@ -0,0 +1,177 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+#include <limits>
+
+#include <logger.h>
+#include <rfidmonitor.h>
+#include <object/rfiddata.h>
+
+#include "interfaces.h"
+#include "tagindex.h"
+
+namespace {
+/*!
+ * \brief KMaxTags is the maximum number of codes in the index, a few MB.
+ */
+const int KMaxTags = 65536;
+
+/*!
+ * \brief KRebuildBatch is the number of readings read at once by rebuild().
+ */
+const int KRebuildBatch = 10000;
+}
+
+TagIndex::TagIndex() :
+    m_tags(KMaxTags),
+    m_ready(false),
+    m_evicted(0),
+    m_scannedId(-1),
+    m_firstAddedId(-1)
+{
+}
+
+TagIndex *TagIndex::instance()
+{
+    static TagIndex singleton;
+    return &singleton;
+}
+
+void TagIndex::add(const QList<Rfiddata *> &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    foreach (Rfiddata *rfiddata, data) {
+        qlonglong id = rfiddata->id().toLongLong();
+        // Already read by rebuild()
+        if(id <= m_scannedId)
+            continue;
+        if(m_firstAddedId < 0 || id < m_firstAddedId)
+            m_firstAddedId = id;
+        record(rfiddata->identificationcode().toLongLong(), rfiddata->idantena().toInt(), rfiddata->timestamp());
+    }
+}
+
+void TagIndex::rebuild()
+{
+    PersistenceInterface *persister = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+    if(!persister)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    quint64 total = 0;
+    forever {
+        qlonglong from, to;
+        {
+            QMutexLocker locker(&m_mutex);
+            from = m_scannedId + 1;
+            to = m_firstAddedId < 0 ? std::numeric_limits<qlonglong>::max() : m_firstAddedId - 1;
+        }
+        if(from > to)
+            break;
+
+        SelectQuery<Rfiddata> select;
+        select.columns({Rfiddata::Column::KId, Rfiddata::Column::KIdantena, Rfiddata::Column::KIdentificationcode, Rfiddata::Column::KTimestamp})
+                .between(Rfiddata::Column::KId, from, to)
+                .orderBy(Rfiddata::Column::KId)
+                .limit(KRebuildBatch);
+        QList<Rfiddata *> batch = persister->select(select, 0);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            foreach (Rfiddata *rfiddata, batch) {
+                qlonglong id = rfiddata->id().toLongLong();
+                // Indexed by add() while the batch was read
+                if(m_firstAddedId >= 0 && id >= m_firstAddedId)
+                    break;
+                record(rfiddata->identificationcode().toLongLong(), rfiddata->idantena().toInt(), rfiddata->timestamp());
+                m_scannedId = id;
+            }
+        }
+        total += batch.size();
+        bool last = batch.size() < KRebuildBatch;
+        qDeleteAll(batch);
+        if(last)
+            break;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_ready = true;
+    Logger::instance()->writeRecord(Logger::severity_level::info, "TagIndex", Q_FUNC_INFO, QString("%1 readings indexed in %2 ms, %3 tags").arg(total).arg(timer.elapsed()).arg(m_tags.size()));
+}
+
+bool TagIndex::lookup(qlonglong identificationCode, TagIndex::Tag &tag)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Tag *found = m_tags.object(identificationCode);
+    if(!found)
+        return false;
+    tag = *found;
+    return true;
+}
+
+bool TagIndex::isReady()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ready;
+}
+
+quint64 TagIndex::evicted()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_evicted;
+}
+
+void TagIndex::record(qlonglong identificationCode, int antenna, qint64 timestamp)
+{
+    Tag *tag = m_tags.object(identificationCode);
+    if(!tag){
+        if(m_tags.size() >= m_tags.maxCost())
+            m_evicted++;
+        tag = new Tag;
+        m_tags.insert(identificationCode, tag);
+    }
+
+    QHash<int, AntennaStats>::iterator it = tag->antennas.find(antenna);
+    if(it == tag->antennas.end()){
+        AntennaStats stats = {timestamp, timestamp, 1};
+        tag->antennas.insert(antenna, stats);
+        return;
+    }
+    AntennaStats &stats = it.value();
+    if(timestamp < stats.firstSeen)
+        stats.firstSeen = timestamp;
+    if(timestamp > stats.lastSeen)
+        stats.lastSeen = timestamp;
+    stats.count++;
+}
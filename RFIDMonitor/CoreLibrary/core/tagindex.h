@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+class Rfiddata;
+
+/*!
+ * \brief The TagIndex class answers "when was this tag seen" from memory, without a scan of the readings in the persistence service.
+ *
+ * For each identification code it keeps, per antenna, the number of readings and the first and last time the tag was seen.
+ * The index is updated with each batch committed by the IngestJournal, and rebuilt from the persistence service by rebuild(),
+ * which runs once on the "index" queue of the Executor after the startup. Until it finishes isReady() is false and the answers
+ * cover only the readings already indexed.
+ *
+ * The memory is bounded: at most KMaxTags codes are kept, the least recently seen (or queried) is evicted first.
+ */
+class TagIndex
+{
+public:
+    struct AntennaStats
+    {
+        qint64 firstSeen;
+        qint64 lastSeen;
+        quint64 count;
+    };
+
+    /*!
+     * \brief The Tag struct is the history of one code, by antenna. The times are timestamps of Clock.
+     */
+    struct Tag
+    {
+        QHash<int, AntennaStats> antennas;
+    };
+
+    static TagIndex * instance();
+
+    /*!
+     * \brief add indexes readings just committed to the persistence service (their ids are already set).
+     */
+    void add(const QList<Rfiddata *> &data);
+
+    /*!
+     * \brief rebuild indexes the readings already in the default persistence service, in batches of consecutive ids.
+     * The readings given to add() in the meantime are not counted twice.
+     */
+    void rebuild();
+
+    /*!
+     * \brief lookup copies the history of \a identificationCode to \a tag.
+     * \return false if the code is not in the index.
+     */
+    bool lookup(qlonglong identificationCode, Tag &tag);
+
+    bool isReady();
+
+    /*!
+     * \brief evicted is the number of codes dropped to keep the index under KMaxTags. When not zero, a code not found may have been seen before.
+     */
+    quint64 evicted();
+
+private:
+    TagIndex();
+
+    void record(qlonglong identificationCode, int antenna, qint64 timestamp);
+
+    QMutex m_mutex;
+    QCache<qlonglong, Tag> m_tags;
+    bool m_ready;
+    quint64 m_evicted;
+    // Highest id indexed by rebuild() and lowest id indexed by add(), so a reading is never counted twice
+    qlonglong m_scannedId;
+    qlonglong m_firstAddedId;
+};
+
+#endif // TAGINDEX_H
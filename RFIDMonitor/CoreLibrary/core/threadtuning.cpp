@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QThread>
+#include <QStringList>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <logger.h>
+
+#include "threadtuning.h"
+
+void ThreadTuning::install(QThread *thread, const json::ThreadSettings &settings)
+{
+    if(settings.stackSize() > 0)
+        thread->setStackSize(uint(settings.stackSize()));
+
+    // Without a context object the functor is called directly by the new thread, before its event loop starts
+    QObject::connect(thread, &QThread::started, [settings](){ ThreadTuning::applyToCurrentThread(settings); });
+}
+
+void ThreadTuning::applyToCurrentThread(const json::ThreadSettings &settings)
+{
+    QString module("ThreadTuning");
+    QStringList applied;
+
+    if(!settings.cpus().isEmpty()){
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        foreach (int cpu, settings.cpus()) {
+            if(cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpuSet);
+        }
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if(result != 0){
+            Logger::instance()->writeRecord(Logger::severity_level::warning, module, Q_FUNC_INFO, QString("Can't set the CPU set of thread %1: %2").arg(settings.name()).arg(strerror(result)));
+        }else{
+            QStringList cpus;
+            foreach (int cpu, settings.cpus()) {
+                cpus.append(QString::number(cpu));
+            }
+            applied.append(QString("cpus %1").arg(cpus.join(",")));
+        }
+    }
+
+    if(settings.priority() > 0){
+        sched_param param;
+        param.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO), settings.priority(), sched_get_priority_max(SCHED_FIFO));
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if(result != 0)
+            Logger::instance()->writeRecord(Logger::severity_level::warning, module, Q_FUNC_INFO, QString("Can't set the real time priority of thread %1: %2").arg(settings.name()).arg(strerror(result)));
+        else
+            applied.append(QString("SCHED_FIFO %1").arg(param.sched_priority));
+    }else if(settings.nice() != 0){
+        // On Linux the nice value belongs to the thread, not to the whole process
+        pid_t tid = pid_t(::syscall(SYS_gettid));
+        if(::setpriority(PRIO_PROCESS, tid, settings.nice()) != 0)
+            Logger::instance()->writeRecord(Logger::severity_level::warning, module, Q_FUNC_INFO, QString("Can't set the nice value of thread %1: %2").arg(settings.name()).arg(strerror(errno)));
+        else
+            applied.append(QString("nice %1").arg(settings.nice()));
+    }
+
+    if(settings.stackSize() > 0)
+        applied.append(QString("stack %1 bytes").arg(settings.stackSize()));
+
+    if(!applied.isEmpty())
+        Logger::instance()->writeRecord(Logger::severity_level::info, module, Q_FUNC_INFO, QString("Thread %1: %2").arg(settings.name()).arg(applied.join(", ")));
+}
+
+json::ThreadSettings ThreadTuning::defaults(const QString &name)
+{
+    json::ThreadSettings settings;
+    settings.setName(name);
+
+    // With a single core there is nothing to isolate, only the priorities are used
+    int cores = QThread::idealThreadCount();
+    QList<int> readerCpus;
+    QList<int> otherCpus;
+    if(cores > 1){
+        readerCpus.append(cores - 1);
+        for(int cpu = 0; cpu < cores - 1; cpu++)
+            otherCpus.append(cpu);
+    }
+
+    if(name == "reader"){
+        settings.setCpus(readerCpus);
+        settings.setNice(-10);
+    }else if(name == "persistence"){
+        settings.setCpus(otherCpus);
+    }else if(name == "synchronization"){
+        settings.setCpus(otherCpus);
+        settings.setNice(5);
+    }else if(name == "exporter"){
+        // The busy copy loops and the udev polling are the least urgent work of the collector
+        settings.setCpus(otherCpus);
+        settings.setNice(10);
+    }
+    return settings;
+}
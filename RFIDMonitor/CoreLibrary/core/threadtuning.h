@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef THREADTUNING_H
+#define THREADTUNING_H
+
+#include <json/rfidmonitorsettings.h>
+
+class QThread;
+
+/*!
+ * \brief The ThreadTuning class applies the scheduling configuration (CPU set, nice, real time priority and stack size) to the pipeline threads.
+ *
+ * The reader thread is the only one with a latency requirement: by default it gets the last core for itself and a higher priority,
+ * while the persistence, synchronization and exporter threads share the other cores with lower priorities.
+ * The defaults are used for the threads not listed in the "threads" array of rfidmonitor.json.
+ *
+ * Raising the priority (negative nice or SCHED_FIFO) needs CAP_SYS_NICE; when it is not allowed a warning is written and the thread keeps running with the default scheduling.
+ */
+class ThreadTuning
+{
+public:
+    /*!
+     * \brief install sets the stack size of \a thread and applies the rest of \a settings from inside the thread, as soon as it starts.
+     * Must be called before QThread::start().
+     */
+    static void install(QThread *thread, const json::ThreadSettings &settings);
+
+    /*!
+     * \brief applyToCurrentThread applies the CPU set, the nice value and the real time priority of \a settings to the calling thread.
+     */
+    static void applyToCurrentThread(const json::ThreadSettings &settings);
+
+    /*!
+     * \brief defaults returns the configuration used for the thread \a name when rfidmonitor.json has none.
+     */
+    static json::ThreadSettings defaults(const QString &name);
+};
+
+#endif // THREADTUNING_H
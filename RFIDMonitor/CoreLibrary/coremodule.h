@@ -35,6 +35,9 @@ class Service;
 
 /*!
  * \brief The CoreModule class is the interface that every module of the system has to implement to make it available to the QPlubinLoader.
+ *
+ * The JSON file given to Q_PLUGIN_METADATA describes the module like in rfidmonitor.json ("modulename", "version" and "services").
+ * The system reads it without loading the library, and loads only the modules that have a default service.
  */
 class CoreModule : public QObject
 {
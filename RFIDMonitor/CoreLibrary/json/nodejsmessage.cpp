@@ -52,5 +52,40 @@ void NodeJSMessage::setDateTime(const QDateTime &dateTime)
 {
     m_dateTime = dateTime;
 }
+
+QByteArray NodeJSMessage::takeDocument(QByteArray &buffer)
+{
+    int begin = 0;
+    while(begin < buffer.size() && buffer.at(begin) != '{' && buffer.at(begin) != '[')
+        begin++;
+    if(begin > 0)
+        buffer.remove(0, begin);
+
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    for(int i = 0; i < buffer.size(); i++){
+        char c = buffer.at(i);
+        if(inString){
+            if(escaped)
+                escaped = false;
+            else if(c == '\\')
+                escaped = true;
+            else if(c == '"')
+                inString = false;
+        }else if(c == '"'){
+            inString = true;
+        }else if(c == '{' || c == '['){
+            depth++;
+        }else if(c == '}' || c == ']'){
+            if(--depth == 0){
+                QByteArray document(buffer.left(i + 1));
+                buffer.remove(0, i + 1);
+                return document;
+            }
+        }
+    }
+    return QByteArray();
+}
 }
 
@@ -32,6 +32,16 @@ public:
     QDateTime dateTime() const;
     void setDateTime(const QDateTime &dateTime);
 
+    /*!
+     * \brief takeDocument removes the first complete JSON document from \a buffer and returns it.
+     *
+     * The messages are JSON objects one after the other on the socket. The end of a document is found by matching the braces
+     * and brackets outside the strings, so a message cut anywhere (inside a string, a number or a literal) waits for more data,
+     * and messages that arrive together are split. The bytes before the first '{' or '[' are discarded.
+     * \return an empty array if the buffer holds no complete document yet.
+     */
+    static QByteArray takeDocument(QByteArray &buffer);
+
 private:
     QString m_type;
     QDateTime m_dateTime;
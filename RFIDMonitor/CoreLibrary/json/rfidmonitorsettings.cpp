@@ -95,6 +95,96 @@ void RFIDMonitorSettings::setDevice(const QString &device)
     m_device = device;
 }
 
+QString RFIDMonitorSettings::packetDigest() const
+{
+    return m_packetDigest;
+}
+
+void RFIDMonitorSettings::setPacketDigest(const QString &packetDigest)
+{
+    m_packetDigest = packetDigest;
+}
+
+int RFIDMonitorSettings::retentionDays() const
+{
+    return m_retentionDays;
+}
+
+void RFIDMonitorSettings::setRetentionDays(int retentionDays)
+{
+    m_retentionDays = retentionDays;
+}
+
+QString RFIDMonitorSettings::retentionArchive() const
+{
+    return m_retentionArchive;
+}
+
+void RFIDMonitorSettings::setRetentionArchive(const QString &retentionArchive)
+{
+    m_retentionArchive = retentionArchive;
+}
+
+QString RFIDMonitorSettings::gpioBackend() const
+{
+    return m_gpioBackend;
+}
+
+void RFIDMonitorSettings::setGpioBackend(const QString &gpioBackend)
+{
+    m_gpioBackend = gpioBackend;
+}
+
+QString RFIDMonitorSettings::exportMode() const
+{
+    return m_exportMode;
+}
+
+void RFIDMonitorSettings::setExportMode(const QString &exportMode)
+{
+    m_exportMode = exportMode;
+}
+
+QList<QueueSettings> RFIDMonitorSettings::executorQueues() const
+{
+    return m_executorQueues;
+}
+
+void RFIDMonitorSettings::setExecutorQueues(const QList<QueueSettings> &executorQueues)
+{
+    m_executorQueues = executorQueues;
+}
+
+QList<ThreadSettings> RFIDMonitorSettings::threads() const
+{
+    return m_threads;
+}
+
+void RFIDMonitorSettings::setThreads(const QList<ThreadSettings> &threads)
+{
+    m_threads = threads;
+}
+
+QList<ReaderSettings> RFIDMonitorSettings::readers() const
+{
+    return m_readers;
+}
+
+void RFIDMonitorSettings::setReaders(const QList<ReaderSettings> &readers)
+{
+    m_readers = readers;
+}
+
+PassageSettings RFIDMonitorSettings::passages() const
+{
+    return m_passages;
+}
+
+void RFIDMonitorSettings::setPassages(const PassageSettings &passages)
+{
+    m_passages = passages;
+}
+
 
 void RFIDMonitorSettings::read(const QJsonObject &json)
 {
@@ -112,6 +202,18 @@ void RFIDMonitorSettings::read(const QJsonObject &json)
 #else
     m_serverPort = json["port"].toInt();
 #endif // QT_VERSION < 0x050200
+    // Collectors configured before the digest was selectable keep MD5, which every server understands.
+    m_packetDigest = json["packetdigest"].toString("md5");
+    // Zero keeps the readings until they are synchronized and deleted.
+#if QT_VERSION < 0x050200
+    m_retentionDays = json["retentiondays"].toVariant().toInt();
+#else
+    m_retentionDays = json["retentiondays"].toInt(0);
+#endif // QT_VERSION < 0x050200
+    // Empty drops the old partitions without keeping a copy.
+    m_retentionArchive = json["retentionarchive"].toString();
+    m_exportMode = json["exportmode"].toString("file");
+    m_gpioBackend = json["gpiobackend"].toString("auto");
 
     /*
      * A temporary modules list variable is used because when the system is running and an update on the config file is needed the module list becames duplicate.
@@ -133,6 +235,39 @@ void RFIDMonitorSettings::read(const QJsonObject &json)
 
     QJsonObject network = json["network"].toObject();
     m_networkConfiguration.read(network);
+
+    // Only the queues that differ from the defaults of the executor need to be listed
+    QList<QueueSettings> tempQueues;
+    QJsonArray queues = json["executor"].toArray();
+    for(int i=0; i < queues.size(); i++) {
+        QueueSettings queue;
+        queue.read(queues[i].toObject());
+        tempQueues.append(queue);
+    }
+    m_executorQueues = tempQueues;
+
+    // Only the threads that differ from the defaults of ThreadTuning need to be listed
+    QList<ThreadSettings> tempThreads;
+    QJsonArray threads = json["threads"].toArray();
+    for(int i=0; i < threads.size(); i++) {
+        ThreadSettings thread;
+        thread.read(threads[i].toObject());
+        tempThreads.append(thread);
+    }
+    m_threads = tempThreads;
+
+    // Without a list of readers the collector has one reader: the default reader service on "device"
+    QList<ReaderSettings> tempReaders;
+    QJsonArray readers = json["readers"].toArray();
+    for(int i=0; i < readers.size(); i++) {
+        ReaderSettings reader;
+        reader.read(readers[i].toObject());
+        tempReaders.append(reader);
+    }
+    m_readers = tempReaders;
+
+    // Without the "passages" object the detection stays off and every reading is synchronized
+    m_passages.read(json["passages"].toObject());
 }
 
 void RFIDMonitorSettings::write(QJsonObject &json) const
@@ -143,6 +278,11 @@ void RFIDMonitorSettings::write(QJsonObject &json) const
     json["device"] = m_device;
     json["serveraddress"] = m_serverAddress;
     json["port"] = m_serverPort;
+    json["packetdigest"] = m_packetDigest;
+    json["retentiondays"] = m_retentionDays;
+    json["retentionarchive"] = m_retentionArchive;
+    json["exportmode"] = m_exportMode;
+    json["gpiobackend"] = m_gpioBackend;
 
     QJsonArray modules;
     foreach (Module mod, m_modules) {
@@ -159,6 +299,34 @@ void RFIDMonitorSettings::write(QJsonObject &json) const
     QJsonObject network;
     m_networkConfiguration.write(network);
     json["network"] = network;
+
+    QJsonArray queues;
+    foreach (QueueSettings queue, m_executorQueues) {
+        QJsonObject obj;
+        queue.write(obj);
+        queues.append(obj);
+    }
+    json["executor"] = queues;
+
+    QJsonArray threads;
+    foreach (ThreadSettings thread, m_threads) {
+        QJsonObject obj;
+        thread.write(obj);
+        threads.append(obj);
+    }
+    json["threads"] = threads;
+
+    QJsonArray readers;
+    foreach (ReaderSettings reader, m_readers) {
+        QJsonObject obj;
+        reader.write(obj);
+        readers.append(obj);
+    }
+    json["readers"] = readers;
+
+    QJsonObject passages;
+    m_passages.write(passages);
+    json["passages"] = passages;
 }
 
 int Service::serviceType() const
@@ -384,7 +552,393 @@ void Network::write(QJsonObject &json) const
     json["password"] = m_password;
 }
 
+QString QueueSettings::name() const
+{
+    return m_name;
+}
+
+void QueueSettings::setName(const QString &name)
+{
+    m_name = name;
+}
+
+int QueueSettings::workers() const
+{
+    return m_workers;
+}
+
+void QueueSettings::setWorkers(int workers)
+{
+    m_workers = workers;
+}
+
+int QueueSettings::capacity() const
+{
+    return m_capacity;
+}
+
+void QueueSettings::setCapacity(int capacity)
+{
+    m_capacity = capacity;
+}
+
+QString QueueSettings::policy() const
+{
+    return m_policy;
+}
+
+void QueueSettings::setPolicy(const QString &policy)
+{
+    m_policy = policy;
+}
+
+void QueueSettings::read(const QJsonObject &json)
+{
+    m_name = json["name"].toString();
+#if QT_VERSION < 0x050200
+    m_workers = json["workers"].toVariant().toInt();
+    m_capacity = json["capacity"].toVariant().toInt();
+#else
+    m_workers = json["workers"].toInt(1);
+    m_capacity = json["capacity"].toInt(1024);
+#endif // QT_VERSION < 0x050200
+    m_policy = json["policy"].toString("block");
+}
+
+void QueueSettings::write(QJsonObject &json) const
+{
+    json["name"] = m_name;
+    json["workers"] = m_workers;
+    json["capacity"] = m_capacity;
+    json["policy"] = m_policy;
+}
+
+
+
+ThreadSettings::ThreadSettings() :
+    m_nice(0),
+    m_priority(0),
+    m_stackSize(0)
+{
+}
+
+QString ThreadSettings::name() const
+{
+    return m_name;
+}
+
+void ThreadSettings::setName(const QString &name)
+{
+    m_name = name;
+}
+
+QList<int> ThreadSettings::cpus() const
+{
+    return m_cpus;
+}
+
+void ThreadSettings::setCpus(const QList<int> &cpus)
+{
+    m_cpus = cpus;
+}
+
+int ThreadSettings::nice() const
+{
+    return m_nice;
+}
+
+void ThreadSettings::setNice(int nice)
+{
+    m_nice = nice;
+}
+
+int ThreadSettings::priority() const
+{
+    return m_priority;
+}
+
+void ThreadSettings::setPriority(int priority)
+{
+    m_priority = priority;
+}
+
+int ThreadSettings::stackSize() const
+{
+    return m_stackSize;
+}
+
+void ThreadSettings::setStackSize(int stackSize)
+{
+    m_stackSize = stackSize;
+}
+
+void ThreadSettings::read(const QJsonObject &json)
+{
+    m_name = json["name"].toString();
+    QList<int> cpus;
+    QJsonArray array = json["cpus"].toArray();
+    for(int i=0; i < array.size(); i++) {
+#if QT_VERSION < 0x050200
+        cpus.append(array[i].toVariant().toInt());
+#else
+        cpus.append(array[i].toInt());
+#endif // QT_VERSION < 0x050200
+    }
+    m_cpus = cpus;
+    // Zero keeps the default of the system: nice 0, SCHED_OTHER and the stack size of QThread
+#if QT_VERSION < 0x050200
+    m_nice = json["nice"].toVariant().toInt();
+    m_priority = json["priority"].toVariant().toInt();
+    m_stackSize = json["stacksize"].toVariant().toInt();
+#else
+    m_nice = json["nice"].toInt(0);
+    m_priority = json["priority"].toInt(0);
+    m_stackSize = json["stacksize"].toInt(0);
+#endif // QT_VERSION < 0x050200
+}
+
+void ThreadSettings::write(QJsonObject &json) const
+{
+    json["name"] = m_name;
+    QJsonArray cpus;
+    foreach (int cpu, m_cpus) {
+        cpus.append(cpu);
+    }
+    json["cpus"] = cpus;
+    json["nice"] = m_nice;
+    json["priority"] = m_priority;
+    json["stacksize"] = m_stackSize;
+}
+
+ReaderSettings::ReaderSettings() :
+    m_antennaOffset(0),
+    m_baudRate(9600),
+    m_dataBits(8),
+    m_parity("none"),
+    m_stopBits(1),
+    m_lowLatency(false),
+    m_readBufferSize(0)
+{
+}
+
+QString ReaderSettings::name() const
+{
+    return m_name;
+}
+
+void ReaderSettings::setName(const QString &name)
+{
+    m_name = name;
+}
 
+QString ReaderSettings::service() const
+{
+    return m_service;
+}
+
+void ReaderSettings::setService(const QString &service)
+{
+    m_service = service;
+}
+
+QString ReaderSettings::device() const
+{
+    return m_device;
+}
+
+void ReaderSettings::setDevice(const QString &device)
+{
+    m_device = device;
+}
+
+int ReaderSettings::antennaOffset() const
+{
+    return m_antennaOffset;
+}
+
+void ReaderSettings::setAntennaOffset(int antennaOffset)
+{
+    m_antennaOffset = antennaOffset;
+}
+
+int ReaderSettings::baudRate() const
+{
+    return m_baudRate;
+}
+
+void ReaderSettings::setBaudRate(int baudRate)
+{
+    m_baudRate = baudRate;
+}
+
+int ReaderSettings::dataBits() const
+{
+    return m_dataBits;
+}
+
+void ReaderSettings::setDataBits(int dataBits)
+{
+    m_dataBits = dataBits;
+}
+
+QString ReaderSettings::parity() const
+{
+    return m_parity;
+}
+
+void ReaderSettings::setParity(const QString &parity)
+{
+    m_parity = parity;
+}
+
+int ReaderSettings::stopBits() const
+{
+    return m_stopBits;
+}
+
+void ReaderSettings::setStopBits(int stopBits)
+{
+    m_stopBits = stopBits;
+}
+
+bool ReaderSettings::lowLatency() const
+{
+    return m_lowLatency;
+}
+
+void ReaderSettings::setLowLatency(bool lowLatency)
+{
+    m_lowLatency = lowLatency;
+}
+
+int ReaderSettings::readBufferSize() const
+{
+    return m_readBufferSize;
+}
+
+void ReaderSettings::setReadBufferSize(int readBufferSize)
+{
+    m_readBufferSize = readBufferSize;
+}
+
+void ReaderSettings::read(const QJsonObject &json)
+{
+    m_name = json["name"].toString();
+    m_service = json["service"].toString();
+    m_device = json["device"].toString();
+    // The defaults are the line of the readers before it was configurable: 9600 8N1
+#if QT_VERSION < 0x050200
+    m_antennaOffset = json["antennaoffset"].toVariant().toInt();
+    m_baudRate = json.contains("baudrate") ? json["baudrate"].toVariant().toInt() : 9600;
+    m_dataBits = json.contains("databits") ? json["databits"].toVariant().toInt() : 8;
+    m_stopBits = json.contains("stopbits") ? json["stopbits"].toVariant().toInt() : 1;
+    m_readBufferSize = json["readbuffersize"].toVariant().toInt();
+#else
+    m_antennaOffset = json["antennaoffset"].toInt(0);
+    m_baudRate = json["baudrate"].toInt(9600);
+    m_dataBits = json["databits"].toInt(8);
+    m_stopBits = json["stopbits"].toInt(1);
+    m_readBufferSize = json["readbuffersize"].toInt(0);
+#endif // QT_VERSION < 0x050200
+    m_parity = json["parity"].toString("none");
+    m_lowLatency = json["lowlatency"].toBool(false);
+}
+
+void ReaderSettings::write(QJsonObject &json) const
+{
+    json["name"] = m_name;
+    json["service"] = m_service;
+    json["device"] = m_device;
+    json["antennaoffset"] = m_antennaOffset;
+    json["baudrate"] = m_baudRate;
+    json["databits"] = m_dataBits;
+    json["parity"] = m_parity;
+    json["stopbits"] = m_stopBits;
+    json["lowlatency"] = m_lowLatency;
+    json["readbuffersize"] = m_readBufferSize;
+}
+
+
+PassageSettings::PassageSettings() :
+    m_enabled(false),
+    m_window(10000),
+    m_rawReads(true)
+{
+}
+
+bool PassageSettings::enabled() const
+{
+    return m_enabled;
+}
+
+void PassageSettings::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+int PassageSettings::window() const
+{
+    return m_window;
+}
+
+void PassageSettings::setWindow(int window)
+{
+    m_window = window;
+}
+
+QList<int> PassageSettings::antennas() const
+{
+    return m_antennas;
+}
+
+void PassageSettings::setAntennas(const QList<int> &antennas)
+{
+    m_antennas = antennas;
+}
+
+bool PassageSettings::rawReads() const
+{
+    return m_rawReads;
+}
+
+void PassageSettings::setRawReads(bool rawReads)
+{
+    m_rawReads = rawReads;
+}
+
+void PassageSettings::read(const QJsonObject &json)
+{
+    m_enabled = json["enabled"].toBool(false);
+#if QT_VERSION < 0x050200
+    m_window = json.contains("window") ? json["window"].toVariant().toInt() : 10000;
+#else
+    m_window = json["window"].toInt(10000);
+#endif // QT_VERSION < 0x050200
+    // The antennas from downstream to upstream. Empty means the ascending order of the antenna numbers.
+    QList<int> antennas;
+    QJsonArray array = json["antennas"].toArray();
+    for(int i=0; i < array.size(); i++) {
+#if QT_VERSION < 0x050200
+        antennas.append(array[i].toVariant().toInt());
+#else
+        antennas.append(array[i].toInt());
+#endif // QT_VERSION < 0x050200
+    }
+    m_antennas = antennas;
+    m_rawReads = json["rawreads"].toBool(true);
+}
+
+void PassageSettings::write(QJsonObject &json) const
+{
+    json["enabled"] = m_enabled;
+    json["window"] = m_window;
+    QJsonArray antennas;
+    foreach (int antenna, m_antennas) {
+        antennas.append(antenna);
+    }
+    json["antennas"] = antennas;
+    json["rawreads"] = m_rawReads;
+}
 
 }
 
@@ -104,6 +104,160 @@ public:
     void write(QJsonObject &json) const;
 };
 
+class ReaderSettings : public JsonRWInterface
+{
+public:
+    ReaderSettings();
+
+    QString name() const;
+    void setName(const QString &name);
+
+    QString service() const;
+    void setService(const QString &service);
+
+    QString device() const;
+    void setDevice(const QString &device);
+
+    int antennaOffset() const;
+    void setAntennaOffset(int antennaOffset);
+
+    /*!
+     * \brief baudRate of the serial line. Zero detects it by probing the common rates for valid frames.
+     */
+    int baudRate() const;
+    void setBaudRate(int baudRate);
+
+    int dataBits() const;
+    void setDataBits(int dataBits);
+
+    /*!
+     * \brief parity of the serial line: "none", "even" or "odd".
+     */
+    QString parity() const;
+    void setParity(const QString &parity);
+
+    int stopBits() const;
+    void setStopBits(int stopBits);
+
+    /*!
+     * \brief lowLatency asks the driver to deliver every byte at once (ASYNC_LOW_LATENCY, which also sets the FTDI latency timer to 1 ms).
+     */
+    bool lowLatency() const;
+    void setLowLatency(bool lowLatency);
+
+    /*!
+     * \brief readBufferSize limits the buffer of the port, in bytes. Zero is unlimited.
+     */
+    int readBufferSize() const;
+    void setReadBufferSize(int readBufferSize);
+
+private:
+    QString m_name;
+    QString m_service;
+    QString m_device;
+    int m_antennaOffset;
+    int m_baudRate;
+    int m_dataBits;
+    QString m_parity;
+    int m_stopBits;
+    bool m_lowLatency;
+    int m_readBufferSize;
+
+    // JsonRWInterface interface
+public:
+    void read(const QJsonObject &json);
+    void write(QJsonObject &json) const;
+};
+
+class QueueSettings : public JsonRWInterface
+{
+public:
+    QString name() const;
+    void setName(const QString &name);
+
+    int workers() const;
+    void setWorkers(int workers);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    QString policy() const;
+    void setPolicy(const QString &policy);
+
+private:
+    QString m_name;
+    int m_workers;
+    int m_capacity;
+    QString m_policy;
+
+    // JsonRWInterface interface
+public:
+    void read(const QJsonObject &json);
+    void write(QJsonObject &json) const;
+};
+
+class ThreadSettings : public JsonRWInterface
+{
+public:
+    ThreadSettings();
+
+    QString name() const;
+    void setName(const QString &name);
+
+    QList<int> cpus() const;
+    void setCpus(const QList<int> &cpus);
+
+    int nice() const;
+    void setNice(int nice);
+
+    int priority() const;
+    void setPriority(int priority);
+
+    int stackSize() const;
+    void setStackSize(int stackSize);
+
+private:
+    QString m_name;
+    QList<int> m_cpus;
+    int m_nice;
+    int m_priority;
+    int m_stackSize;
+
+    // JsonRWInterface interface
+public:
+    void read(const QJsonObject &json);
+    void write(QJsonObject &json) const;
+};
+
+class PassageSettings : public JsonRWInterface
+{
+public:
+    PassageSettings();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    int window() const;
+    void setWindow(int window);
+
+    QList<int> antennas() const;
+    void setAntennas(const QList<int> &antennas);
+
+    bool rawReads() const;
+    void setRawReads(bool rawReads);
+
+private:
+    bool m_enabled;
+    int m_window;
+    QList<int> m_antennas;
+    bool m_rawReads;
+
+    // JsonRWInterface interface
+public:
+    void read(const QJsonObject &json);
+    void write(QJsonObject &json) const;
+};
+
 class RFIDMonitorSettings : public JsonRWInterface
 {
 public:
@@ -136,6 +290,33 @@ public:
     int serverPort() const;
     void setServerPort(const int &serverPort);
 
+    QString packetDigest() const;
+    void setPacketDigest(const QString &packetDigest);
+
+    int retentionDays() const;
+    void setRetentionDays(int retentionDays);
+
+    QString retentionArchive() const;
+    void setRetentionArchive(const QString &retentionArchive);
+
+    QString exportMode() const;
+    void setExportMode(const QString &exportMode);
+
+    QString gpioBackend() const;
+    void setGpioBackend(const QString &gpioBackend);
+
+    QList<QueueSettings> executorQueues() const;
+    void setExecutorQueues(const QList<QueueSettings> &executorQueues);
+
+    QList<ThreadSettings> threads() const;
+    void setThreads(const QList<ThreadSettings> &threads);
+
+    QList<ReaderSettings> readers() const;
+    void setReaders(const QList<ReaderSettings> &readers);
+
+    PassageSettings passages() const;
+    void setPassages(const PassageSettings &passages);
+
 private:
     int m_id;
     int m_serverPort;
@@ -143,11 +324,20 @@ private:
     QString m_macAddress;
     QString m_device;
     QString m_serverAddress;
+    QString m_packetDigest;
+    int m_retentionDays;
+    QString m_retentionArchive;
+    QString m_exportMode;
+    QString m_gpioBackend;
     int m_port;
 
     QList<Module> m_modules;
     DefaultServices m_defaultServices;
     Network m_networkConfiguration;
+    QList<QueueSettings> m_executorQueues;
+    QList<ThreadSettings> m_threads;
+    QList<ReaderSettings> m_readers;
+    PassageSettings m_passages;
 
     // JsonRWInterface interface
 public:
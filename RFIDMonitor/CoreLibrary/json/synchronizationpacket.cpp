@@ -1,6 +1,6 @@
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QDateTime>
+#include <core/clock.h>
 
 #include "synchronizationpacket.h"
 
@@ -97,14 +97,14 @@ void Data::setIdantena(int idantena)
 {
     m_idantena = idantena;
 }
-QDateTime Data::dateTime() const
+qint64 Data::timestamp() const
 {
-    return m_dateTime;
+    return m_timestamp;
 }
 
-void Data::setDateTime(const QDateTime &dateTime)
+void Data::setTimestamp(qint64 timestamp)
 {
-    m_dateTime = dateTime;
+    m_timestamp = timestamp;
 }
 
 void Data::read(const QJsonObject &json)
@@ -122,8 +122,7 @@ void Data::read(const QJsonObject &json)
     m_applicationCode = json["applicationcode"].toInt();
     m_identificationCode = json["identificationcode"].toInt();
 #endif // QT_VERSION < 0x050200
-    QString dateTime = json["datetime"].toString();
-    m_dateTime = QDateTime::fromString(json["datetime"].toString(), Qt::ISODate);
+    m_timestamp = Clock::fromIsoString(json["datetime"].toString());
 }
 
 void Data::write(QJsonObject &json) const
@@ -138,8 +137,7 @@ void Data::write(QJsonObject &json) const
     json["applicationcode"] = m_applicationCode;
     json["identificationcode"] = m_identificationCode;
 #endif // QT_VERSION < 0x050200
-    QString dateTime = m_dateTime.toString(Qt::ISODate);
-    json["datetime"] = dateTime;
+    json["datetime"] = Clock::toIsoString(m_timestamp);
 }
 
 qlonglong Data::applicationCode() const
@@ -23,8 +23,11 @@ public:
     qlonglong applicationCode() const;
     void setApplicationCode(qlonglong applicationCode);
 
-    QDateTime dateTime() const;
-    void setDateTime(const QDateTime &dateTime);
+    /*!
+     * \brief timestamp is the time of the reading in microseconds since the epoch (see Clock). The packet carries it as ISO 8601 text.
+     */
+    qint64 timestamp() const;
+    void setTimestamp(qint64 timestamp);
 
 private:
     int m_id;
@@ -32,7 +35,7 @@ private:
     int m_idantena;
     qlonglong m_identificationCode;
     qlonglong m_applicationCode;
-    QDateTime m_dateTime;
+    qint64 m_timestamp;
 
     // JsonRWInterface interface
 public:
@@ -11,20 +11,35 @@
 Rfiddata::Rfiddata(QObject *parent) :
     QObject(parent)
 {
-
+    clear();
 }
 
 Rfiddata::Rfiddata(const QSqlRecord &record, QObject *parent) :
     QObject(parent)
 {
-    // id, idantena, idpontocoleta, applicationcode, identificationcode, datetime, synced
-	setId(record.value(0));
-	setIdantena(record.value(1));
-    setIdpontocoleta(record.value(2));
-    setApplicationcode(record.value(3));
-    setIdentificationcode(record.value(4));
-    setDatetime(record.value(5));
-    setSync(record.value(6));
+    clear();
+    // The fields are read by name, the record may have only the columns projected by a SelectQuery
+    int index;
+    if((index = record.indexOf("id")) >= 0)
+        setId(record.value(index));
+    if((index = record.indexOf("idantena")) >= 0)
+        setIdantena(record.value(index));
+    if((index = record.indexOf("idpontocoleta")) >= 0)
+        setIdpontocoleta(record.value(index));
+    if((index = record.indexOf("applicationcode")) >= 0)
+        setApplicationcode(record.value(index));
+    if((index = record.indexOf("identificationcode")) >= 0)
+        setIdentificationcode(record.value(index));
+    if((index = record.indexOf("timestamp")) >= 0)
+        setTimestamp(record.value(index).toLongLong());
+    if((index = record.indexOf("sync")) >= 0)
+        setSync(record.value(index));
+}
+
+const char *Rfiddata::columnName(Rfiddata::Column column)
+{
+    static const char *names[] = {"id", "idantena", "idpontocoleta", "applicationcode", "identificationcode", "timestamp", "sync"};
+    return names[int(column)];
 }
 
 QVariant Rfiddata::id() const
@@ -78,14 +93,14 @@ void Rfiddata::setIdentificationcode(QVariant value)
 	m_identificationcode = value.toLongLong();
 }
 
-QVariant Rfiddata::datetime() const
+qint64 Rfiddata::timestamp() const
 {
-	return m_datetime;
+    return m_timestamp;
 }
 
-void Rfiddata::setDatetime(QVariant value)
+void Rfiddata::setTimestamp(qint64 timestamp)
 {
-    m_datetime = value.toDateTime();
+    m_timestamp = timestamp;
 }
 
 QVariant Rfiddata::sync() const
@@ -97,3 +112,14 @@ void Rfiddata::setSync(QVariant value)
 {
     m_sync = (SyncState) value.toInt();
 }
+
+void Rfiddata::clear()
+{
+    m_id = 0;
+    m_idantena = 0;
+    m_idpontocoleta = 0;
+    m_applicationcode = 0;
+    m_identificationcode = 0;
+    m_timestamp = 0;
+    m_sync = KNotSynced;
+}
@@ -18,6 +18,9 @@ class QSqlRecord;
 class  Rfiddata : public QObject
 {
 	Q_OBJECT
+    Q_PROPERTY(QVariant id
+        READ id
+        WRITE setId)
 	Q_PROPERTY(QVariant idantena
 		READ idantena
 		WRITE setIdantena)
@@ -30,9 +33,9 @@ class  Rfiddata : public QObject
 	Q_PROPERTY(QVariant identificationcode
 		READ identificationcode
 		WRITE setIdentificationcode)
-	Q_PROPERTY(QVariant datetime
-		READ datetime
-		WRITE setDatetime)
+    Q_PROPERTY(qint64 timestamp
+        READ timestamp
+        WRITE setTimestamp)
     Q_PROPERTY(QVariant sync
         READ sync
         WRITE setSync)
@@ -41,6 +44,13 @@ public:
 
     enum SyncState {KNotSynced = 0, KSynced, KPending};
 
+    /*!
+     * \brief The Column enum lists the columns of the table, used by SelectQuery<Rfiddata>. The names are also the names of the properties.
+     */
+    enum class Column {KId = 0, KIdantena, KIdpontocoleta, KApplicationcode, KIdentificationcode, KTimestamp, KSync};
+    static const int KColumnCount = 7;
+    static const char * columnName(Column column);
+
 	explicit Rfiddata(QObject *parent = 0);
 	explicit Rfiddata(const QSqlRecord &, QObject *parent = 0);
 
@@ -54,18 +64,26 @@ public:
 	void setApplicationcode(QVariant);
 	QVariant identificationcode() const;
 	void setIdentificationcode(QVariant);
-	QVariant datetime() const;
-	void setDatetime(QVariant);
+    /*!
+     * \brief timestamp is the time of the reading, in microseconds since the epoch (UTC), see Clock.
+     */
+    qint64 timestamp() const;
+    void setTimestamp(qint64 timestamp);
     QVariant sync() const;
     void setSync(QVariant);
 
+    /*!
+     * \brief clear resets all the fields, used when the object is recycled by RfiddataPool.
+     */
+    void clear();
+
 private:
     qlonglong m_id;
 	qlonglong m_idantena;
     qlonglong m_idpontocoleta;
     qlonglong m_applicationcode;
 	qlonglong m_identificationcode;
-    QDateTime m_datetime;
+    qint64 m_timestamp;
     SyncState m_sync;
 
 };
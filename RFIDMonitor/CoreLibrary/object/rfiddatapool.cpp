@@ -0,0 +1,116 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QMutexLocker>
+
+#include <logger.h>
+
+#include "rfiddata.h"
+#include "rfiddatapool.h"
+
+RfiddataPool::RfiddataPool()
+{
+}
+
+RfiddataPool *RfiddataPool::instance()
+{
+    static RfiddataPool singleton;
+    return &singleton;
+}
+
+RfiddataPool::~RfiddataPool()
+{
+    foreach (Rfiddata *slab, m_slabs) {
+        delete [] slab;
+    }
+}
+
+Rfiddata *RfiddataPool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(m_free.isEmpty()){
+        Rfiddata *slab = new Rfiddata[KSlabSize];
+        m_slabs.append(slab);
+        m_free.reserve(m_slabs.size() * KSlabSize);
+        for(int i = KSlabSize - 1; i >= 0; i--)
+            m_free.append(slab + i);
+        Logger::instance()->writeRecord(Logger::severity_level::debug, "RfiddataPool", Q_FUNC_INFO, QString("Pool grown to %1 readings").arg(m_slabs.size() * KSlabSize));
+    }
+
+    Rfiddata *data = m_free.last();
+    m_free.removeLast();
+#ifndef QT_NO_DEBUG
+    m_acquired.insert(data);
+#endif
+    data->clear();
+    return data;
+}
+
+void RfiddataPool::release(Rfiddata *data)
+{
+    if(!data)
+        return;
+    QMutexLocker locker(&m_mutex);
+    releaseLocked(data);
+}
+
+void RfiddataPool::release(const QList<Rfiddata *> &list)
+{
+    QMutexLocker locker(&m_mutex);
+    foreach (Rfiddata *data, list) {
+        if(data)
+            releaseLocked(data);
+    }
+}
+
+void RfiddataPool::releaseLocked(Rfiddata *data)
+{
+#ifndef QT_NO_DEBUG
+    bool acquired = m_acquired.remove(data);
+    Q_ASSERT_X(acquired, Q_FUNC_INFO, "object released twice or not taken from the pool");
+#endif
+    // A free list larger than the pool means an object was released twice, it would be handed to two readings
+    if(m_free.size() >= m_slabs.size() * KSlabSize){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, "RfiddataPool", Q_FUNC_INFO, "Object released twice, ignored");
+        return;
+    }
+    m_free.append(data);
+}
+
+int RfiddataPool::capacity()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slabs.size() * KSlabSize;
+}
+
+int RfiddataPool::inUse()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slabs.size() * KSlabSize - m_free.size();
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef RFIDDATAPOOL_H
+#define RFIDDATAPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+class Rfiddata;
+
+/*!
+ * \brief The RfiddataPool class owns the Rfiddata objects of the readings, from the serial port until they are committed.
+ *
+ * The objects are allocated in slabs of KSlabSize and recycled through a free list, so reading a tag doesn't allocate memory once the
+ * pool has grown to the peak number of readings in flight (the pending batch of the journal plus the batches waiting in the "ingest" queue).
+ * The memory of the collector is bounded by that peak and doesn't grow with the number of tags read.
+ *
+ * An object taken with acquire() has no parent and must be given back with release() exactly once, by whoever is the last to use it.
+ * A second release of the same object is caught by an assert in the debug builds; the release builds only catch the releases
+ * that would make the free list larger than the pool.
+ */
+class RfiddataPool
+{
+public:
+    static RfiddataPool * instance();
+    ~RfiddataPool();
+
+    /*!
+     * \brief acquire returns a cleared object, growing the pool by one slab if there is no free object.
+     */
+    Rfiddata * acquire();
+
+    void release(Rfiddata *data);
+    void release(const QList<Rfiddata *> &list);
+
+    /*!
+     * \brief capacity returns the number of objects allocated by the pool, in use or free.
+     */
+    int capacity();
+
+    /*!
+     * \brief inUse returns the number of objects acquired and not released yet.
+     */
+    int inUse();
+
+private:
+    RfiddataPool();
+    Q_DISABLE_COPY(RfiddataPool)
+
+    static const int KSlabSize = 256;
+
+    void releaseLocked(Rfiddata *data);
+
+    QList<Rfiddata *> m_slabs;
+    QVector<Rfiddata *> m_free;
+#ifndef QT_NO_DEBUG
+    QSet<Rfiddata *> m_acquired;
+#endif
+    QMutex m_mutex;
+};
+
+#endif // RFIDDATAPOOL_H
@@ -26,6 +26,8 @@
 ****************************************************************************/
 
 #include <QCoreApplication>
+#include <algorithm>
+#include <limits>
 #include <QPluginLoader>
 #include <QDir>
 #include <QDebug>
@@ -36,18 +38,35 @@
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QJsonArray>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPair>
+#include <QtConcurrent/QtConcurrentMap>
 
 #include <coremodule.h>
 #include <logger.h>
 
 #include "core/service.h"
 #include "core/interfaces.h"
+#include "core/ingestjournal.h"
+#include "core/executor.h"
+#include "core/threadtuning.h"
+#include "core/tagindex.h"
+#include "core/tagfilter.h"
+#include "core/passagedetector.h"
+#include "core/livestream.h"
+#include "core/clock.h"
 #include "applicationsettings.h"
 #include "rfidmonitor.h"
 #include "json/rfidmonitorsettings.h"
 #include "json/nodejsmessage.h"
 
 
+/*!
+ * \brief KThroughputInterval is the interval, in milliseconds, between two reports of the throughput of the readers.
+ */
+const int KThroughputInterval = 60000;
+
 struct RFIDMonitorPrivate
 {
     RFIDMonitorPrivate() :
@@ -78,6 +97,12 @@ struct RFIDMonitorPrivate
 
     QMap<ServiceType, QString> defaultServiceNames;
 
+    // One reader per configured device, each in its own thread
+    QList<ReadingInterface *> readers;
+    QList<QThread *> readerThreads;
+    QList<quint64> lastReadings;
+    QElapsedTimer throughputTimer;
+
     QThread *persistenceThread;
     QThread *syncronizationThread;
     QThread *exporterThread;
@@ -96,6 +121,10 @@ struct RFIDMonitorPrivate
     // RFIDMonitor Settings
     json::RFIDMonitorSettings systemSettings;
 
+    // Time of each phase of the startup
+    QElapsedTimer startupTimer;
+    QList<QPair<QString, qint64> > startupPhases;
+
     bool readSettings()
     {
         QFile loadFile(QCoreApplication::applicationDirPath() + "/rfidmonitor.json");
@@ -132,7 +161,32 @@ struct RFIDMonitorPrivate
         return true;
     }
 
-    void installModule(CoreModule *mod)
+    /*!
+     * \brief installModule registers the module in the settings if it's new or newer than the registered one.
+     * \return true if the settings were changed and need to be written.
+     */
+    bool installModule(const json::Module &sysMod)
+    {
+        if(sysMod.moduleName().isEmpty())
+            return false;
+
+        QList<json::Module> registered = systemSettings.modules();
+        int index = registered.indexOf(json::Module(sysMod.moduleName()));
+        if(index >= 0 && registered.at(index).version() >= sysMod.version())
+            return false;
+
+        QList<json::Module> modules;
+        modules.append(sysMod);
+        foreach (json::Module module, registered) {
+            if(!(module == sysMod)){
+                modules.append(module);
+            }
+        }
+        systemSettings.setModules(modules);
+        return true;
+    }
+
+    json::Module moduleDescription(CoreModule *mod)
     {
         json::Module sysMod;
         sysMod.setModuleName(mod->name());
@@ -145,15 +199,36 @@ struct RFIDMonitorPrivate
             services.append(serv);
         }
         sysMod.setServices(services);
-        QList<json::Module> modules;
-        modules.append(sysMod);
-        foreach (json::Module module, systemSettings.modules()) {
-            if(!(sysMod == module)){
-                modules.append(module);
+        return sysMod;
+    }
+
+    /*!
+     * \brief tuneThread names \a thread and installs the scheduling configuration of rfidmonitor.json for it.
+     * Without an entry for \a name, the entry or the defaults of \a fallback are used.
+     */
+    void tuneThread(QThread *thread, const QString &name, const QString &fallback = QString())
+    {
+        QString defaultName = fallback.isEmpty() ? name : fallback;
+        json::ThreadSettings settings = ThreadTuning::defaults(defaultName);
+        foreach (json::ThreadSettings configured, systemSettings.threads()) {
+            if(configured.name() == name){
+                settings = configured;
+                break;
             }
+            if(configured.name() == defaultName)
+                settings = configured;
         }
-        systemSettings.setModules(modules);
-        writeSettings();
+        settings.setName(name);
+        thread->setObjectName(name);
+        ThreadTuning::install(thread, settings);
+    }
+
+    /*!
+     * \brief mark adds the time since the last mark to the startup report.
+     */
+    void mark(const QString &phase)
+    {
+        startupPhases.append(qMakePair(phase, startupTimer.restart()));
     }
 
     void loadModules()
@@ -165,15 +240,67 @@ struct RFIDMonitorPrivate
             return;
         }
 
+        /* The metadata of a plugin (the JSON file of Q_PLUGIN_METADATA) is read without loading the library.
+         * It describes the module and its services, so only the modules with a default service need to be loaded.
+         */
+        QStringList defaultNames;
+        defaultNames << systemSettings.defaultServices().reader() << systemSettings.defaultServices().persister()
+                     << systemSettings.defaultServices().exporter() << systemSettings.defaultServices().packager()
+                     << systemSettings.defaultServices().synchronizer() << systemSettings.defaultServices().communicator();
+        // The modules of the readers listed in the configuration are needed too
+        foreach (const json::ReaderSettings &reader, systemSettings.readers()) {
+            if(!reader.service().isEmpty() && !defaultNames.contains(reader.service()))
+                defaultNames.append(reader.service());
+        }
+
+        QList<QPluginLoader *> loaders;
+        QStringList foundNames;
+        bool settingsChanged = false;
         foreach (QString fileName, pluginsDir.entryList(QDir::Files)){
-            QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
+            QPluginLoader *loader = new QPluginLoader(pluginsDir.absoluteFilePath(fileName));
+            json::Module sysMod;
+            sysMod.read(loader->metaData().value("MetaData").toObject());
+
+            bool needed = sysMod.moduleName().isEmpty();
+            foreach (const json::Service &serv, sysMod.services()) {
+                foundNames.append(serv.serviceName());
+                needed = needed || defaultNames.contains(serv.serviceName());
+            }
+            settingsChanged = installModule(sysMod) || settingsChanged;
 
-            Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Load module %1").arg(fileName));
+            if(needed){
+                loaders.append(loader);
+            }else{
+                Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Module %1 not loaded, it has no default service").arg(fileName));
+                delete loader;
+            }
+        }
+        // Without the metadata of all default services (e.g. a new configuration) every module is loaded
+        foreach (const QString &name, defaultNames) {
+            if(!foundNames.contains(name)){
+                Logger::instance()->writeRecord(Logger::severity_level::warning, moduleName, Q_FUNC_INFO, QString("No module describes the service %1, loading all modules").arg(name));
+                qDeleteAll(loaders);
+                loaders.clear();
+                foreach (QString fileName, pluginsDir.entryList(QDir::Files)){
+                    loaders.append(new QPluginLoader(pluginsDir.absoluteFilePath(fileName)));
+                }
+                break;
+            }
+        }
+        mark("read module metadata");
 
-            QObject *plugin = loader.instance();
+        // Loading the libraries (reading, relocation and static initialization) is independent for each module
+        QtConcurrent::blockingMap(loaders, [](QPluginLoader *loader) { loader->load(); });
+        mark("load module libraries");
+
+        // The modules create QObjects, so they are instantiated and initialized in the main thread
+        foreach (QPluginLoader *loader, loaders) {
+            QString fileName(QFileInfo(loader->fileName()).fileName());
+            Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Load module %1").arg(fileName));
 
-            if(!loader.isLoaded()){
-                Logger::instance()->writeRecord(Logger::severity_level::critical, moduleName, Q_FUNC_INFO, QString("Error to load module %1: %2").arg(fileName).arg(loader.errorString()));
+            QObject *plugin = loader->instance();
+            if(!loader->isLoaded()){
+                Logger::instance()->writeRecord(Logger::severity_level::critical, moduleName, Q_FUNC_INFO, QString("Error to load module %1: %2").arg(fileName).arg(loader->errorString()));
             }
 
             if (plugin){
@@ -182,23 +309,25 @@ struct RFIDMonitorPrivate
                     moduleList.append(coreMod);
                 }
             }
+            delete loader;
         }
         Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, "All Modules Loaded");
 
         foreach (CoreModule *mod, moduleList) {
             mod->init();
-            if(systemSettings.modules().contains(json::Module(mod->name()))){
-                json::Module sysMod = systemSettings.modules().at(systemSettings.modules().indexOf(json::Module(mod->name())));
-                if(sysMod.version() < mod->version()){
-                    installModule(mod);
-                }
-            }else{
-                installModule(mod);
-            }
+            // Modules without metadata are registered from the instance
+            settingsChanged = installModule(moduleDescription(mod)) || settingsChanged;
             foreach (Service *serv, mod->services()) {
                 addService(serv);
             }
         }
+        mark("init modules");
+
+        // The settings are written once, and only if a module was installed or updated
+        if(settingsChanged){
+            writeSettings();
+            mark("write settings");
+        }
     }
 
     void loadDefaultServices()
@@ -217,6 +346,142 @@ struct RFIDMonitorPrivate
         Q_ASSERT(defaultSynchronization);
     }
 
+    /*!
+     * \brief createReaders creates one reader for each entry of the "readers" list of the configuration.
+     * The instance of a module serves its first device, createInstance() creates the others.
+     * Without the list, the default reader is the only one and uses the "device" of the configuration.
+     */
+    void createReaders()
+    {
+        QList<json::ReaderSettings> configured = systemSettings.readers();
+        if(configured.isEmpty()){
+            json::ReaderSettings single;
+            single.setName("reader");
+            single.setService(systemSettings.defaultServices().reader());
+            single.setDevice(device);
+            configured.append(single);
+        }
+
+        QList<ReadingInterface *> used;
+        foreach (json::ReaderSettings settings, configured) {
+            QString serviceName = settings.service().isEmpty() ? systemSettings.defaultServices().reader() : settings.service();
+            ReadingInterface *prototype = readingServiceList.value(serviceName);
+            if(!prototype){
+                Logger::instance()->writeRecord(Logger::severity_level::error, moduleName, Q_FUNC_INFO, QString("Reader %1: service %2 not found").arg(settings.name()).arg(serviceName));
+                continue;
+            }
+
+            ReadingInterface *reader = prototype;
+            if(used.contains(prototype)){
+                reader = prototype->createInstance();
+            }else{
+                used.append(prototype);
+            }
+            if(settings.name().isEmpty())
+                settings.setName(QString("reader%1").arg(readers.size()));
+            if(settings.device().isEmpty())
+                settings.setDevice(device);
+            reader->setSettings(settings);
+            readers.append(reader);
+            lastReadings.append(0);
+
+            Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Reader %1: %2 on %3 (%4 baud%5), antenna offset %6")
+                                            .arg(settings.name()).arg(serviceName).arg(settings.device())
+                                            .arg(settings.baudRate() ? QString::number(settings.baudRate()) : QString("auto"))
+                                            .arg(settings.lowLatency() ? ", low latency" : "").arg(settings.antennaOffset()));
+        }
+    }
+
+    /*!
+     * \brief reportThroughput writes to the log the readings of each reader since the last report.
+     */
+    void reportThroughput()
+    {
+        qint64 elapsed = throughputTimer.restart();
+        if(elapsed <= 0)
+            return;
+        for(int i = 0; i < readers.size(); ++i){
+            quint64 total = readers.at(i)->readings();
+            quint64 delta = total - lastReadings.at(i);
+            lastReadings[i] = total;
+            Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Reader %1: %2 readings, %3 per minute")
+                                            .arg(readers.at(i)->readerName()).arg(total).arg(delta * 60000.0 / elapsed, 0, 'f', 1));
+        }
+        if(TagFilter::instance()->mode() != TagFilter::Mode::KNone)
+            Logger::instance()->writeRecord(Logger::severity_level::info, moduleName, Q_FUNC_INFO, QString("Tag filter %1").arg(TagFilter::instance()->statistics()));
+    }
+
+    /*!
+     * \brief targetReaders returns the readers a message is for: the one named in its "reader" field, or all of them.
+     */
+    QList<ReadingInterface *> targetReaders(const QJsonObject &data)
+    {
+        QString name = data.value("reader").toString();
+        if(!name.isEmpty()){
+            foreach (ReadingInterface *reader, readers) {
+                if(reader->readerName() == name)
+                    return QList<ReadingInterface *>() << reader;
+            }
+        }
+        return readers;
+    }
+
+    /*!
+     * \brief tagQuery answers a TAG-QUERY from the TagIndex. The codes are given in "identificationcode" or in the array "identificationcodes".
+     * The "sender" of the query is sent back, so the daemon can route the answer to the server or to the DeskApp.
+     */
+    QJsonObject tagQuery(const QJsonObject &data)
+    {
+        QList<qlonglong> codes;
+        if(data.contains("identificationcode"))
+            codes.append(data.value("identificationcode").toVariant().toLongLong());
+        QJsonArray codeArray = data.value("identificationcodes").toArray();
+        for(int i = 0; i < codeArray.size(); i++){
+            codes.append(codeArray.at(i).toVariant().toLongLong());
+        }
+
+        TagIndex *index = TagIndex::instance();
+        QJsonArray tags;
+        foreach (qlonglong code, codes) {
+            QJsonObject tagObj;
+            tagObj.insert("identificationcode", QJsonValue::fromVariant(code));
+
+            TagIndex::Tag tag;
+            bool found = index->lookup(code, tag);
+            tagObj.insert("found", found);
+            if(found){
+                QJsonArray antennas;
+                qint64 firstSeen = std::numeric_limits<qint64>::max();
+                qint64 lastSeen = 0;
+                quint64 count = 0;
+                QHash<int, TagIndex::AntennaStats>::const_iterator it;
+                for(it = tag.antennas.constBegin(); it != tag.antennas.constEnd(); ++it){
+                    QJsonObject antenna;
+                    antenna.insert("idantena", it.key());
+                    antenna.insert("count", double(it.value().count));
+                    antenna.insert("firstseen", Clock::toIsoString(it.value().firstSeen));
+                    antenna.insert("lastseen", Clock::toIsoString(it.value().lastSeen));
+                    antennas.append(antenna);
+                    firstSeen = qMin(firstSeen, it.value().firstSeen);
+                    lastSeen = qMax(lastSeen, it.value().lastSeen);
+                    count += it.value().count;
+                }
+                tagObj.insert("count", double(count));
+                tagObj.insert("firstseen", Clock::toIsoString(firstSeen));
+                tagObj.insert("lastseen", Clock::toIsoString(lastSeen));
+                tagObj.insert("antennas", antennas);
+            }
+            tags.append(tagObj);
+        }
+
+        QJsonObject result;
+        result.insert("sender", data.value("sender"));
+        // Until the rebuild finishes, or after codes were evicted, a code not found may have been seen before
+        result.insert("complete", index->isReady() && index->evicted() == 0);
+        result.insert("tags", tags);
+        return result;
+    }
+
     void addService(Service *serv)
     {
         switch (serv->type()) {
@@ -329,6 +594,7 @@ RFIDMonitor::RFIDMonitor(QObject *parent) :
     d_ptr->persistenceThread = new QThread(this);
     d_ptr->syncronizationThread = new QThread(this);
     d_ptr->exporterThread = new QThread(this);
+    std::fill(m_defaultServices, m_defaultServices + 7, static_cast<Service *>(0));
 }
 
 
@@ -344,12 +610,48 @@ bool RFIDMonitor::isconnected(){
 void RFIDMonitor::start(const QCoreApplication &app)
 {
     d_ptr->connected = false;
+    d_ptr->startupTimer.start();
     d_ptr->readSettings();
+    d_ptr->mark("read settings");
+    // The queues are created on their first use, so they must be configured before any service runs
+    foreach (json::QueueSettings queue, d_ptr->systemSettings.executorQueues()) {
+        Executor::QueueConfig config = {queue.workers(), queue.capacity(), ExecutorQueue::policyFromName(queue.policy())};
+        Executor::instance()->configure(queue.name(), config);
+    }
+    // The workers inherit the scheduling of the thread that creates them, create them here and not from the tuned reader thread
+    Executor::instance()->queue("ingest");
+    Executor::instance()->queue("sync");
+    Executor::instance()->queue("comm");
+    Executor::instance()->queue("uplink");
+    Executor::instance()->queue("index");
     d_ptr->loadModules();
     d_ptr->loadDefaultServices();
+    // The typed pointers were checked by loadDefaultServices, defaultService<Interface>() only reads them back
+    m_defaultServices[int(ServiceType::KReader)] = d_ptr->defaultReading;
+    m_defaultServices[int(ServiceType::KPersister)] = d_ptr->defaultPersistence;
+    m_defaultServices[int(ServiceType::KExporter)] = d_ptr->defaultExport;
+    m_defaultServices[int(ServiceType::KSynchronizer)] = d_ptr->defaultSynchronization;
+    m_defaultServices[int(ServiceType::KCommunicator)] = d_ptr->defaultCommunication;
+    m_defaultServices[int(ServiceType::KPackager)] = d_ptr->defaultPackager;
+    d_ptr->mark("load default services");
+
+    // The readers push to the live stream from their threads, its flush timer must belong to the main thread
+    LiveStream::instance();
+    d_ptr->createReaders();
+    d_ptr->mark("create readers");
+
+    // The readers check each reading against the filter of the last TAG-FILTER
+    TagFilter::instance()->restore();
+    // The committed readings, also the replayed ones, are fused into passages
+    PassageDetector::instance()->configure(d_ptr->systemSettings.passages());
+    // Without the raw readings, the readings not yet in a stored passage open their visits again
+    PassageDetector::instance()->recover();
+
+    // Readings of the previous execution that were journaled but not committed to the persistence service
+    IngestJournal::instance()->replay();
+    d_ptr->mark("replay journal");
 
     // Loads all Services available
-    ReadingInterface *readingService = d_ptr->defaultReading;
     PersistenceInterface *persistenceService = d_ptr->defaultPersistence;
     CommunicationInterface *communicationService = d_ptr->defaultCommunication;
     ExportInterface *exportService = d_ptr->defaultExport;
@@ -357,9 +659,19 @@ void RFIDMonitor::start(const QCoreApplication &app)
     PackagerInterface *packagerService = d_ptr->defaultPackager;
     SynchronizationInterface *synchronizationService = d_ptr->defaultSynchronization;
 
-    readingService->setParent(this);
-
     // Move Services to their respective threads
+    // Each reader has its own thread, so a serial port is served even when the main thread or another reader is busy
+    foreach (ReadingInterface *readingService, d_ptr->readers) {
+        QThread *readerThread = new QThread(this);
+        readingService->setParent(0);
+        readingService->moveToThread(readerThread);
+        connect(readerThread, SIGNAL(started()), readingService, SLOT(start()));
+        connect(readerThread, SIGNAL(destroyed()), readingService, SLOT(deleteLater()));
+        // A reader without its own entry in "threads" uses the entry (or the defaults) of "reader"
+        d_ptr->tuneThread(readerThread, QString("reader-%1").arg(readingService->readerName()), "reader");
+        d_ptr->readerThreads.append(readerThread);
+    }
+
     persistenceService->setParent(0);
     persistenceService->moveToThread(d_ptr->persistenceThread);
     connect(d_ptr->persistenceThread, SIGNAL(destroyed()), persistenceService, SLOT(deleteLater()));
@@ -380,11 +692,37 @@ void RFIDMonitor::start(const QCoreApplication &app)
     // Messages from the outside must be evaluated in RFIDMonitor
     connect(communicationService, SIGNAL(messageReceived(QByteArray)), SLOT(newMessage(QByteArray)));
 
+    // CPU set, priority and stack size of each thread, applied when the thread starts
+    d_ptr->tuneThread(d_ptr->persistenceThread, "persistence");
+    d_ptr->tuneThread(d_ptr->syncronizationThread, "synchronization");
+    d_ptr->tuneThread(d_ptr->exporterThread, "exporter");
+
     // Start threads
     d_ptr->persistenceThread->start();
     d_ptr->syncronizationThread->start();
     d_ptr->exporterThread->start();
-    readingService->start();
+    foreach (QThread *readerThread, d_ptr->readerThreads) {
+        readerThread->start();
+    }
+    d_ptr->mark("start services");
+
+    // The index of the tags is read from the persistence service in background, TAG-QUERY answers from what is indexed meanwhile
+    Executor::instance()->submit("index", [](){ TagIndex::instance()->rebuild(); });
+
+    // Throughput of each reader, in the log
+    d_ptr->throughputTimer.start();
+    QTimer *throughputReport = new QTimer(this);
+    connect(throughputReport, &QTimer::timeout, [this](){ d_ptr->reportThroughput(); });
+    throughputReport->start(KThroughputInterval);
+
+    // Startup report
+    qint64 total = 0;
+    QStringList report;
+    for(int i = 0; i < d_ptr->startupPhases.size(); ++i){
+        report.append(QString("%1: %2 ms").arg(d_ptr->startupPhases.at(i).first).arg(d_ptr->startupPhases.at(i).second));
+        total += d_ptr->startupPhases.at(i).second;
+    }
+    Logger::instance()->writeRecord(Logger::severity_level::info, d_ptr->moduleName, Q_FUNC_INFO, QString("Startup in %1 ms (%2)").arg(total).arg(report.join(", ")));
 }
 
 const QList<CoreModule *> &RFIDMonitor::moduleList() const
@@ -399,29 +737,7 @@ QList<Service *> RFIDMonitor::services(ServiceType type)
 
 Service *RFIDMonitor::defaultService(ServiceType type)
 {
-    switch (type) {
-    case ServiceType::KReader:
-        return d_ptr->defaultReading;
-        break;
-    case ServiceType::KPersister:
-        return d_ptr->defaultPersistence;
-        break;
-    case ServiceType::KCommunicator:
-        return d_ptr->defaultCommunication;
-        break;
-    case ServiceType::KExporter:
-        return d_ptr->defaultExport;
-        break;
-    case ServiceType::KPackager:
-        return d_ptr->defaultPackager;
-        break;
-    case ServiceType::KSynchronizer:
-        return d_ptr->defaultSynchronization;
-        break;
-    default:
-        break;
-    }
-    return 0;
+    return m_defaultServices[int(type)];
 }
 
 QVariant RFIDMonitor::getProperty(const QString &propName)
@@ -446,6 +762,31 @@ QString RFIDMonitor::device()
     return d_ptr->device;
 }
 
+QString RFIDMonitor::packetDigest()
+{
+    return d_ptr->systemSettings.packetDigest();
+}
+
+int RFIDMonitor::retentionDays()
+{
+    return d_ptr->systemSettings.retentionDays();
+}
+
+QString RFIDMonitor::retentionArchive()
+{
+    return d_ptr->systemSettings.retentionArchive();
+}
+
+QString RFIDMonitor::exportMode()
+{
+    return d_ptr->systemSettings.exportMode();
+}
+
+QString RFIDMonitor::gpioBackend()
+{
+    return d_ptr->systemSettings.gpioBackend();
+}
+
 void RFIDMonitor::stop()
 {
     d_ptr->stop = true;
@@ -472,12 +813,21 @@ void RFIDMonitor::newMessage(QByteArray message)
         Logger::instance()->writeRecord(Logger::severity_level::debug, "Main", Q_FUNC_INFO, "Server connected");
         d_ptr->connected = true;
         // The daemon is now connected with server, send the not-synced data
-        d_ptr->defaultSynchronization->readyRead();
+        SynchronizationInterface *synchronizer = d_ptr->defaultSynchronization;
+        Executor::instance()->submit("sync", [synchronizer](){ synchronizer->readyRead(); });
     }else if(nodeJSMessage.type() == "STOP"){
 
         // Stop all services and quit system. Used to restart application, but first must to close properly
         d_ptr->defaultExport->stopUSBExport();
-        d_ptr->defaultReading->stop();
+        // The readers live in their own threads, wait for them to close the serial ports before flushing the journal
+        foreach (ReadingInterface *reader, d_ptr->readers) {
+            QMetaObject::invokeMethod(reader, "stop", Qt::BlockingQueuedConnection);
+        }
+        d_ptr->reportThroughput();
+        // Commit the readings still waiting in the journal
+        IngestJournal::instance()->flush();
+        IngestJournal::instance()->waitForCommits();
+        Executor::instance()->logStatistics();
 
         Logger::instance()->writeRecord(Logger::severity_level::debug, "Main", Q_FUNC_INFO, "Stoping services");
 
@@ -497,12 +847,62 @@ void RFIDMonitor::newMessage(QByteArray message)
 
     }else if(nodeJSMessage.type() == "FULL-READ"){
 
-        d_ptr->defaultReading->fullRead(nodeJSMessage.jsonData().value("full").toBool());
+        foreach (ReadingInterface *reader, d_ptr->targetReaders(nodeJSMessage.jsonData())) {
+            QMetaObject::invokeMethod(reader, "fullRead", Q_ARG(bool, nodeJSMessage.jsonData().value("full").toBool()));
+        }
 
     }else if(nodeJSMessage.type() == "READER-COMMAND"){
 
         QString command = nodeJSMessage.jsonData().value("command").toString();
-        d_ptr->defaultReading->write(command);
+        foreach (ReadingInterface *reader, d_ptr->targetReaders(nodeJSMessage.jsonData())) {
+            QMetaObject::invokeMethod(reader, "write", Q_ARG(QString, command));
+        }
+
+    }else if(nodeJSMessage.type() == "TAG-QUERY"){
+
+        // Answered from the TagIndex, without touching the persistence service
+        QJsonObject result(d_ptr->tagQuery(nodeJSMessage.jsonData()));
+
+        QJsonDocument json;
+        QJsonObject dObj;
+        dObj.insert("type", QString("TAG-RESULT"));
+        dObj.insert("data", QJsonValue(result));
+        dObj.insert("datetime", QString(QDateTime::currentDateTime().toString(Qt::ISODate)));
+        json.setObject(dObj);
+
+        d_ptr->defaultCommunication->sendMessage(json.toJson());
+
+    }else if(nodeJSMessage.type() == "TAG-FILTER"){
+
+        // "mode" is allow, deny or none, the codes come in "identificationcodes"
+        QJsonObject data(nodeJSMessage.jsonData());
+        QList<qlonglong> codes;
+        QJsonArray codeArray = data.value("identificationcodes").toArray();
+        for(int i = 0; i < codeArray.size(); i++){
+            codes.append(codeArray.at(i).toVariant().toLongLong());
+        }
+        TagFilter::Mode mode = TagFilter::modeFromName(data.value("mode").toString());
+        bool saved = TagFilter::instance()->load(mode, codes);
+
+        QJsonObject ackObj;
+        ackObj.insert("sender", data.value("sender"));
+        ackObj.insert("success", saved);
+        ackObj.insert("mode", TagFilter::modeName(mode));
+        ackObj.insert("count", TagFilter::instance()->size());
+
+        QJsonDocument json;
+        QJsonObject dObj;
+        dObj.insert("type", QString("ACK-TAG-FILTER"));
+        dObj.insert("data", QJsonValue(ackObj));
+        dObj.insert("datetime", QString(QDateTime::currentDateTime().toString(Qt::ISODate)));
+        json.setObject(dObj);
+
+        d_ptr->defaultCommunication->sendMessage(json.toJson());
+
+    }else if(nodeJSMessage.type() == "SUBSCRIBE-LIVE" || nodeJSMessage.type() == "UNSUBSCRIBE-LIVE"){
+
+        // The daemon keeps the subscribers, it only tells whether there is at least one
+        LiveStream::instance()->setActive(nodeJSMessage.type() == "SUBSCRIBE-LIVE");
 
     }else if(nodeJSMessage.type() == "ACK-DATA"){
         QJsonArray hashArray = nodeJSMessage.jsonData()["md5diggest"].toArray();
@@ -79,6 +79,18 @@ public:
     QList<Service *> services(ServiceType type);
     Service * defaultService(ServiceType type);
 
+    /*!
+     * \brief defaultService returns the default service of the interface type, e.g. defaultService<PersistenceInterface>().
+     *
+     * The pointers are resolved and checked once in start(), so this is only an array access, without any lookup or cast at run time.
+     * Returns 0 before start().
+     */
+    template<class Interface>
+    Interface * defaultService() const
+    {
+        return static_cast<Interface *>(m_defaultServices[int(Interface::KServiceType)]);
+    }
+
     QVariant getProperty(const QString &propName);
 
     /*!
@@ -91,6 +103,31 @@ public:
 
     QString device();
 
+    /*!
+     * \brief packetDigest gets the name of the digest algorithm used to identify the synchronization packets ("md5" or "xxhash64").
+     */
+    QString packetDigest();
+
+    /*!
+     * \brief retentionDays gets how many days of readings are kept in the local database. Zero disables the retention.
+     */
+    int retentionDays();
+
+    /*!
+     * \brief retentionArchive gets the directory where the partitions older than the retention are exported before they are dropped. Empty disables the export.
+     */
+    QString retentionArchive();
+
+    /*!
+     * \brief exportMode gets how the packets are exported to an USB device: "file" stages them in a temporary file, "snapshot" writes them straight from the database.
+     */
+    QString exportMode();
+
+    /*!
+     * \brief gpioBackend gets the name of the backend that drives the leds ("auto", "mmap", "sysfs" or "fake").
+     */
+    QString gpioBackend();
+
 public slots:
     void stop();
     void newMessage(QByteArray message);
@@ -98,6 +135,9 @@ public slots:
 private:
     explicit RFIDMonitor(QObject *parent = 0);
     RFIDMonitorPrivate *d_ptr;
+
+    // Default service of each ServiceType, indexed by the value of the type. Kept out of d_ptr to be read by the inline defaultService().
+    Service *m_defaultServices[7];
 };
 
 #endif // RFIDMONITOR_H
@@ -0,0 +1,163 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QtTest>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+
+#include <object/rfiddata.h>
+#include <object/rfiddatapool.h>
+
+/*
+ * The readers acquire the objects and hand them to the committers, that release them from other threads,
+ * the same way the serial threads and the "ingest" worker share the pool.
+ * The duration in seconds can be set with the RFIDDATAPOOL_SOAK_SECONDS environment variable (5 seconds by default).
+ */
+class RfiddataPoolSoakTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void acquireAndReleaseAcrossThreads();
+
+private:
+    static const int KReaders = 4;
+    static const int KCommitters = 2;
+    static const int KMaxBatch = 256;
+
+    void reader(int number, qint64 deadline);
+    void committer();
+
+    QElapsedTimer m_clock;
+    QMutex m_mutex;
+    QList<QList<Rfiddata *> > m_batches;
+    std::atomic<int> m_errors;
+    std::atomic<bool> m_readersDone;
+};
+
+void RfiddataPoolSoakTest::acquireAndReleaseAcrossThreads()
+{
+    RfiddataPool *pool = RfiddataPool::instance();
+    int seconds = qEnvironmentVariableIsSet("RFIDDATAPOOL_SOAK_SECONDS") ? qgetenv("RFIDDATAPOOL_SOAK_SECONDS").toInt() : 5;
+    m_errors = 0;
+    m_readersDone = false;
+    m_clock.start();
+    qint64 deadline = seconds * 1000;
+
+    QThreadPool threads;
+    threads.setMaxThreadCount(KReaders + KCommitters);
+    QList<QFuture<void> > readers;
+    QList<QFuture<void> > committers;
+    for(int i = 0; i < KReaders; i++)
+        readers.append(QtConcurrent::run(&threads, this, &RfiddataPoolSoakTest::reader, i + 1, deadline));
+    for(int i = 0; i < KCommitters; i++)
+        committers.append(QtConcurrent::run(&threads, this, &RfiddataPoolSoakTest::committer));
+
+    foreach (QFuture<void> future, readers)
+        future.waitForFinished();
+    m_readersDone = true;
+    foreach (QFuture<void> future, committers)
+        future.waitForFinished();
+
+    QCOMPARE(m_errors.load(), 0);
+    QCOMPARE(pool->inUse(), 0);
+    // The pool grows to the peak in flight and not with the number of readings
+    QVERIFY(pool->capacity() <= (KReaders * 4 + KCommitters + 1) * KMaxBatch);
+}
+
+void RfiddataPoolSoakTest::reader(int number, qint64 deadline)
+{
+    RfiddataPool *pool = RfiddataPool::instance();
+    qint64 sequence = 0;
+    while(m_clock.elapsed() < deadline){
+        // Back pressure, like the blocking "ingest" queue
+        {
+            QMutexLocker locker(&m_mutex);
+            if(m_batches.size() >= KReaders * 2){
+                locker.unlock();
+                QThread::yieldCurrentThread();
+                continue;
+            }
+        }
+
+        int size = 1 + qrand() % KMaxBatch;
+        QList<Rfiddata *> batch;
+        for(int i = 0; i < size; i++){
+            Rfiddata *data = pool->acquire();
+            // A recycled object must come back cleared
+            if(data->timestamp() != 0 || data->identificationcode().toLongLong() != 0)
+                m_errors++;
+            data->setIdentificationcode(number);
+            data->setTimestamp(++sequence);
+            batch.append(data);
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_batches.append(batch);
+    }
+}
+
+void RfiddataPoolSoakTest::committer()
+{
+    RfiddataPool *pool = RfiddataPool::instance();
+    forever {
+        QList<Rfiddata *> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            if(!m_batches.isEmpty())
+                batch = m_batches.takeFirst();
+            else if(m_readersDone)
+                return;
+        }
+        if(batch.isEmpty()){
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        // An object handed to two readings at the same time would be overwritten by the other reader
+        qlonglong number = batch.first()->identificationcode().toLongLong();
+        qint64 previous = 0;
+        foreach (Rfiddata *data, batch) {
+            if(data->identificationcode().toLongLong() != number || data->timestamp() <= previous)
+                m_errors++;
+            previous = data->timestamp();
+        }
+        pool->release(batch);
+    }
+}
+
+QTEST_GUILESS_MAIN(RfiddataPoolSoakTest)
+
+#include "rfiddatapoolsoaktest.moc"
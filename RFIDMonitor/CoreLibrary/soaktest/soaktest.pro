@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Soak test of RfiddataPool, run with "make check"
+#
+#-------------------------------------------------
+
+QT       += core testlib concurrent
+
+QT       -= gui
+
+TARGET = RfiddataPoolSoakTest
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ..
+
+LIBS += -L$$OUT_PWD/..
+LIBS += -lCoreLibrary
+
+SOURCES += rfiddatapoolsoaktest.cpp
+
+QMAKE_CXXFLAGS += -std=c++11
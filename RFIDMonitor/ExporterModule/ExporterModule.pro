@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core sql
+QT       += core sql concurrent
 
 TARGET = Exporter
 TEMPLATE = lib
@@ -16,13 +16,19 @@ HEADERS += exportmodule.h \
     export/exportlocaldata.h \
     devicethread.h \
     export/blinkled.h \
+    export/mountwatcher.h \
+    export/exportcopier.h \
     export/gpiointerface.h \
+    export/gpiobackend.h \
     exportservice.h
 SOURCES += exportmodule.cpp \
     export/exportlocaldata.cpp \
     devicethread.cpp \
     export/blinkled.cpp \
+    export/mountwatcher.cpp \
+    export/exportcopier.cpp \
     export/gpiointerface.c \
+    export/gpiobackend.cpp \
     exportservice.cpp
 
 OTHER_FILES += ExportModule.json
@@ -28,26 +28,32 @@
 #ifndef DEVICETHREAD_H
 #define DEVICETHREAD_H
 
-#include <QThread>
+#include <QObject>
 
 #include "export/exportlocaldata.h"
 
+struct udev;
+struct udev_monitor;
+class QSocketNotifier;
 class ExportLocalData;
 
+/*!
+ * \brief The DeviceThread class listens to the udev events of the disks in the event loop of the thread it lives in.
+ */
 class DeviceThread : public QObject
 {
     Q_OBJECT
 
 public:
     explicit DeviceThread(QObject *parent = 0);
+    ~DeviceThread();
     static DeviceThread * instance();
 
 signals:
     /*!
-     * \brief exportToDevice is a signal to export data into the external device just connected. Passes the path by parameter or an empty string otherwise
-     * \param device
+     * \brief deviceAdded is a signal emitted when an external device is connected. It may not be mounted yet.
      */
-    void exportToDevice(QString device);
+    void deviceAdded();
 
     /*!
      * \brief redLedOff emit a signal to turn off the green led
@@ -56,9 +62,25 @@ signals:
 
 public slots:
     /*!
-     * \brief startListening is the function that starts this thread and starts the loop to listening new devices connection
+     * \brief startListening creates the udev monitor and starts to watch its file descriptor.
      */
     void startListening();
+
+    /*!
+     * \brief stopListening releases the udev monitor. No signal is emitted after it.
+     */
+    void stopListening();
+
+private slots:
+    /*!
+     * \brief receiveDevice is called when the udev monitor has an event to be read.
+     */
+    void receiveDevice();
+
+private:
+    struct udev *m_udev;
+    struct udev_monitor *m_monitor;
+    QSocketNotifier *m_notifier;
 };
 
 #endif // DEVICETHREAD_H
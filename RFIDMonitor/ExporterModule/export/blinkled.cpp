@@ -26,41 +26,63 @@
 ****************************************************************************/
 
 #include <QDebug>
+#include <QTimer>
 #include <logger.h>
+#include <rfidmonitor.h>
 
 #include "blinkled.h"
+#include "gpiobackend.h"
 #include "gpiointerface.h"
 
 const int BlinkLed::KRedLed = 11; // define GPIO pin 11 for red led
 const int BlinkLed::KGreenLed = 24; // define GPIO pin 24 for green led
 
 BlinkLed::BlinkLed(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    m_finishTimer(new QTimer(this)),
+    m_deviceReady(false)
+{
+    m_gpio = GpioBackend::create(RFIDMonitor::instance()->gpioBackend());
+    init();
+}
+
+BlinkLed::BlinkLed(GpioBackend *gpio, QObject *parent) :
+    QObject(parent),
+    m_finishTimer(new QTimer(this)),
+    m_gpio(gpio),
+    m_deviceReady(false)
+{
+    init();
+}
+
+void BlinkLed::init()
 {
     m_module = "ExportModule";
 
     setLogger(&writeLog);
 
-    GPIOExport(KRedLed);
-    GPIOExport(KGreenLed);
-    GPIODirection(KRedLed, KOutput);
-    GPIODirection(KGreenLed, KOutput);
-    GPIOWrite(KRedLed, 0);
-    GPIOWrite(KGreenLed, 0);
+    if(!m_gpio->setup(KRedLed) || !m_gpio->setup(KGreenLed))
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't set up the led pins with the %1 GPIO backend").arg(m_gpio->name()));
+    m_gpio->write(KRedLed, 0);
+    m_gpio->write(KGreenLed, 0);
 
     m_redLedState = 0;
     m_greenLedState = 0;
+
+    m_finishTimer->setSingleShot(true);
+    connect(m_finishTimer, SIGNAL(timeout()), SLOT(finishTimeout()));
 }
 
 BlinkLed::~BlinkLed()
 {
     // turn off leds
-    GPIOWrite(KRedLed, 0);
-    GPIOWrite(KGreenLed, 0);
+    m_gpio->write(KRedLed, 0);
+    m_gpio->write(KGreenLed, 0);
 
     // release access to leds
-    GPIOUnexport(KRedLed);
-    GPIOUnexport(KGreenLed);
+    m_gpio->release(KRedLed);
+    m_gpio->release(KGreenLed);
+    delete m_gpio;
 }
 
 void BlinkLed::writeLog(char *message)
@@ -70,26 +92,54 @@ void BlinkLed::writeLog(char *message)
 
 void BlinkLed::blinkRedLed(int value)
 {
-    GPIOWrite(KRedLed, value);
+    m_gpio->write(KRedLed, value);
 }
 
 void BlinkLed::blinkGreenLed(int value)
 {
-    GPIOWrite(KGreenLed, value);
+    m_gpio->write(KGreenLed, value);
 }
 
 void BlinkLed::blinkRedLedSlot()
 {
     // blink red led. change the current status and write value
     m_redLedState = !m_redLedState;
-    GPIOWrite(KRedLed, m_redLedState);
+    m_gpio->write(KRedLed, m_redLedState);
 }
 
 void BlinkLed::blinkGreenLedSlot()
 {
     // blink green led. change the current status and write value
     m_greenLedState = !m_greenLedState;
-    GPIOWrite(KGreenLed, m_greenLedState);
+    m_gpio->write(KGreenLed, m_greenLedState);
 }
 
 
+
+void BlinkLed::startWorking()
+{
+    m_finishTimer->stop();
+    m_gpio->write(KRedLed, 1);
+}
+
+void BlinkLed::finishWorking(int msec, bool deviceReady)
+{
+    // A device written before keeps its green led, even if a temporary export finishes later
+    m_deviceReady = m_deviceReady || deviceReady;
+    m_finishTimer->start(msec);
+}
+
+void BlinkLed::deviceRemoved()
+{
+    m_deviceReady = false;
+    m_gpio->write(KGreenLed, 0);
+}
+
+void BlinkLed::finishTimeout()
+{
+    m_gpio->write(KRedLed, 0);
+    if(m_deviceReady){
+        m_gpio->write(KGreenLed, 1);
+        m_deviceReady = false;
+    }
+}
@@ -30,10 +30,17 @@
 
 #include <QObject>
 
+class QTimer;
+class GpioBackend;
+
 /*!
  * \brief The BlinkLed class access gpio interface functions to manipulate leds
  *
  * Create and configure access to the GPIO pins on raspberryPi. Offer functions to turn on/off and blink leds.
+ * The pins are driven by the GpioBackend selected with the "gpiobackend" setting.
+ *
+ * The export signaling is a small state machine driven by a timer: startWorking() turns the red led on, finishWorking() turns it off
+ * after a delay and then, if a device was written, turns the green led on. The caller never waits for the leds.
  */
 class BlinkLed : public QObject
 {
@@ -55,6 +62,11 @@ public:
      */
     explicit BlinkLed(QObject *parent=0);
 
+    /*!
+     * \brief BlinkLed drives the leds with \a gpio instead of the backend of the settings, taking its ownership.
+     */
+    explicit BlinkLed(GpioBackend *gpio, QObject *parent=0);
+
 
     static void writeLog(char *message);
 
@@ -75,6 +87,22 @@ public:
      */
     void blinkGreenLed(int value);
 
+    /*!
+     * \brief startWorking turns the red led on and cancels a pending finishWorking().
+     */
+    void startWorking();
+
+    /*!
+     * \brief finishWorking turns the red led off after \a msec milliseconds.
+     * \param deviceReady if true the green led is turned on together, to show that the device can be removed.
+     */
+    void finishWorking(int msec, bool deviceReady);
+
+    /*!
+     * \brief deviceRemoved turns the green led off, also if it was still going to be turned on.
+     */
+    void deviceRemoved();
+
 public slots:
 
     /*!
@@ -86,8 +114,16 @@ public slots:
      */
     void blinkGreenLedSlot();
 
+private slots:
+    void finishTimeout();
+
 private:
+    void init();
+
     QString m_module;
+    QTimer *m_finishTimer;
+    GpioBackend *m_gpio;
+    bool m_deviceReady; // turn the green led on when the red led is turned off
     int m_redLedState; // status of red led
     int m_greenLedState; // status of green led
 };
@@ -0,0 +1,325 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <functional>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <core/digest.h>
+#include <core/interfaces.h>
+#include <logger.h>
+
+#include "exportcopier.h"
+
+namespace {
+
+// Multiple of the block size of the devices, so the resumed copy always continues on a block boundary
+const qint64 KChunkSize = 1024 * 1024;
+
+const char *KPartSuffix = ".part";
+
+/*!
+ * \brief checksumFile computes the checksum of the first \a length bytes of \a file.
+ */
+bool checksumFile(QFile &file, qint64 length, Digest *digest)
+{
+    QByteArray buffer(KChunkSize, 0);
+    file.seek(0);
+    while(length > 0){
+        qint64 read = file.read(buffer.data(), qMin(length, KChunkSize));
+        if(read <= 0)
+            return false;
+        digest->addData(buffer.constData(), read);
+        length -= read;
+    }
+    return true;
+}
+
+/*!
+ * \brief newExportPath returns the name of a new export file in the device.
+ */
+QString newExportPath(const QDir &deviceDir)
+{
+    return deviceDir.absoluteFilePath("export_" + QDateTime::currentDateTime().toString().replace(" ", "_").replace(":","") + ".jsonl");
+}
+
+/*!
+ * \brief The WriterThread class runs the writer of the double buffering in a thread of its own.
+ *
+ * The copy already runs in the global thread pool, a writer taken from the same pool could wait forever for a free thread
+ * while the copy waits for the writer.
+ */
+class WriterThread : public QThread
+{
+public:
+    explicit WriterThread(const std::function<void()> &function) :
+        m_function(function)
+    {
+    }
+
+protected:
+    void run()
+    {
+        m_function();
+    }
+
+private:
+    std::function<void()> m_function;
+};
+
+/*!
+ * \brief syncDirectory makes a rename in the directory durable.
+ */
+void syncDirectory(const QString &path)
+{
+    int dirFd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if(dirFd >= 0){
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+}
+
+ExportCopier::ExportCopier(QObject *parent) :
+    QObject(parent)
+{
+    m_module = "ExportModule";
+}
+
+ExportCopier::~ExportCopier()
+{
+    m_future.waitForFinished();
+}
+
+bool ExportCopier::start(const QString &source, const QString &device)
+{
+    if(isRunning())
+        return false;
+
+    m_future = QtConcurrent::run(this, &ExportCopier::copy, source, device);
+    return true;
+}
+
+bool ExportCopier::startSnapshot(const QString &device, PackagerInterface *packager)
+{
+    if(isRunning())
+        return false;
+
+    m_future = QtConcurrent::run(this, &ExportCopier::copySnapshot, device, packager);
+    return true;
+}
+
+bool ExportCopier::isRunning() const
+{
+    return m_future.isRunning();
+}
+
+void ExportCopier::copy(const QString &source, const QString &device)
+{
+    QDir deviceDir(device);
+
+    // Continue a copy interrupted before, otherwise start a new file
+    QStringList parts(deviceDir.entryList(QStringList(QString("export_*.jsonl%1").arg(KPartSuffix)), QDir::Files, QDir::Time));
+    QString partPath;
+    if(!parts.isEmpty()){
+        partPath = deviceDir.absoluteFilePath(parts.first());
+    }else{
+        partPath = newExportPath(deviceDir) + KPartSuffix;
+    }
+
+    qint64 resumedBytes = 0;
+    if(!copyFile(source, partPath, resumedBytes)){
+        emit finished(false, QString());
+        return;
+    }
+
+    QString destination(partPath.left(partPath.size() - int(strlen(KPartSuffix))));
+    if(!QFile::rename(partPath, destination)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't rename %1").arg(partPath));
+        emit finished(false, QString());
+        return;
+    }
+    // The new name must be in the device too before the file is removed from the local disk
+    syncDirectory(device);
+
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Exported to %1 (%2 bytes resumed)").arg(destination).arg(resumedBytes));
+    emit finished(true, destination);
+}
+
+bool ExportCopier::copyFile(const QString &source, const QString &partPath, qint64 &resumedBytes)
+{
+    QFile in(source);
+    QFile out(partPath);
+    if(!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::ReadWrite)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't open %1 or %2").arg(source).arg(partPath));
+        return false;
+    }
+
+    const qint64 total = in.size();
+    QScopedPointer<Digest> checksum(Digest::create(Digest::Algorithm::KXxHash64));
+
+    // The source only grows, so a .part file is valid if it has the same first bytes. Only complete chunks are kept.
+    qint64 offset = qMin(out.size(), total) / KChunkSize * KChunkSize;
+    if(offset > 0){
+        QScopedPointer<Digest> partChecksum(Digest::create(Digest::Algorithm::KXxHash64));
+        if(!checksumFile(in, offset, checksum.data()) || !checksumFile(out, offset, partChecksum.data()) || checksum->result() != partChecksum->result()){
+            Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("%1 doesn't match the export file, copying it again").arg(partPath));
+            offset = 0;
+            checksum->reset();
+        }
+    }
+    resumedBytes = offset;
+    out.resize(offset);
+    in.seek(offset);
+    out.seek(offset);
+
+    /* Double buffering: the reader fills one buffer while the writer empties the other.
+     * "free" counts the buffers the reader can fill, "used" the buffers the writer can write. A buffer with size 0 ends the copy.
+     */
+    QByteArray buffers[2] = {QByteArray(KChunkSize, 0), QByteArray(KChunkSize, 0)};
+    qint64 sizes[2] = {0, 0};
+    QSemaphore freeBuffers(2);
+    QSemaphore usedBuffers(0);
+    QAtomicInt failed(0);
+
+    WriterThread writer([&]() {
+        qint64 written = offset;
+        for(int index = 0; ; index ^= 1){
+            usedBuffers.acquire();
+            qint64 size = sizes[index];
+            if(size == 0){
+                freeBuffers.release();
+                return;
+            }
+            // After an error the buffers are still consumed, so the reader is never blocked
+            if(!failed.load()){
+                if(out.write(buffers[index].constData(), size) != size){
+                    Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error to write into %1: %2").arg(partPath).arg(out.errorString()));
+                    failed.store(1);
+                }else{
+                    written += size;
+                    emit progress(written, total);
+                }
+            }
+            freeBuffers.release();
+        }
+    });
+    writer.start();
+
+    int index = 0;
+    for(qint64 position = offset; position < total && !failed.load(); index ^= 1){
+        freeBuffers.acquire();
+        qint64 read = in.read(buffers[index].data(), qMin(KChunkSize, total - position));
+        if(read <= 0){
+            Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error to read %1: %2").arg(source).arg(in.errorString()));
+            failed.store(1);
+            freeBuffers.release();
+            break;
+        }
+        checksum->addData(buffers[index].constData(), read);
+        sizes[index] = read;
+        position += read;
+        usedBuffers.release();
+    }
+    freeBuffers.acquire();
+    sizes[index] = 0;
+    usedBuffers.release();
+    writer.wait();
+
+    if(failed.load() || !out.flush() || ::fsync(out.handle()) != 0){
+        // The .part file is kept, so the copy continues when the device is connected again
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Copy to %1 interrupted").arg(partPath));
+        return false;
+    }
+
+    // Read the file back from the device, not from the cache, and compare the checksums
+    ::posix_fadvise(out.handle(), 0, 0, POSIX_FADV_DONTNEED);
+    QScopedPointer<Digest> verify(Digest::create(Digest::Algorithm::KXxHash64));
+    if(out.size() != total || !checksumFile(out, total, verify.data()) || verify->result() != checksum->result()){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Checksum of %1 doesn't match, the file will be copied again").arg(partPath));
+        out.close();
+        out.remove();
+        return false;
+    }
+
+    Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("%1 verified, xxHash64 %2").arg(partPath).arg(QString(checksum->result().toHex())));
+    return true;
+}
+
+void ExportCopier::copySnapshot(const QString &device, PackagerInterface *packager)
+{
+    QString destination(newExportPath(QDir(device)));
+    // A snapshot can't be resumed, the .part name only keeps an incomplete file from looking like a finished export
+    QFile out(destination + KPartSuffix);
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't open %1").arg(out.fileName()));
+        emit snapshotFinished(false, QString(), QStringList());
+        return;
+    }
+
+    QStringList hashes;
+    int count = packager->exportPackets(&out, hashes);
+    if(count < 0 || !out.flush() || ::fsync(out.handle()) != 0){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Snapshot export to %1 failed").arg(out.fileName()));
+        out.close();
+        out.remove();
+        emit snapshotFinished(false, QString(), QStringList());
+        return;
+    }
+    out.close();
+
+    if(count == 0){
+        out.remove();
+        emit snapshotFinished(true, QString(), hashes);
+        return;
+    }
+
+    if(!out.rename(destination)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Can't rename %1").arg(out.fileName()));
+        out.remove();
+        emit snapshotFinished(false, QString(), QStringList());
+        return;
+    }
+    syncDirectory(device);
+
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Exported %1 packets to %2").arg(count).arg(destination));
+    emit snapshotFinished(true, destination, hashes);
+}
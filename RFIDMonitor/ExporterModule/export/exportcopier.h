@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef EXPORTCOPIER_H
+#define EXPORTCOPIER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QString>
+#include <QStringList>
+
+class PackagerInterface;
+
+/*!
+ * \brief The ExportCopier class copies the export file into the external device without blocking the exporter thread.
+ *
+ * The file is copied in chunks of 1 MiB with two buffers: one thread reads the next chunk while another writes the previous one to the device.
+ * The writer has a thread of its own, outside of the global thread pool used by the copy.
+ * A xxHash64 checksum of the source is computed while reading. After fsync the cache of the destination is dropped and the file is read back
+ * from the device and checked against it.
+ *
+ * The destination is written as export_<date>.jsonl.part and renamed only when verified. If the device is removed in the middle,
+ * the next copy finds the .part file, checks that it is a prefix of the source, and continues from the last complete chunk.
+ *
+ * In the snapshot mode there is no source file: the packets are written straight from the database by PackagerInterface::exportPackets().
+ */
+class ExportCopier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExportCopier(QObject *parent = 0);
+    ~ExportCopier();
+
+    /*!
+     * \brief start begins to copy \a source into the directory \a device. The result is reported by finished().
+     * \return false if a copy is already running.
+     */
+    bool start(const QString &source, const QString &device);
+
+    /*!
+     * \brief startSnapshot begins to write the packets of \a packager into the directory \a device. The result is reported by snapshotFinished().
+     * \return false if a copy is already running.
+     */
+    bool startSnapshot(const QString &device, PackagerInterface *packager);
+
+    bool isRunning() const;
+
+signals:
+    /*!
+     * \brief progress is emitted after each chunk written in the device.
+     */
+    void progress(qint64 written, qint64 total);
+
+    /*!
+     * \brief finished is emitted when the copy ends. \a destination is the final file name, valid only if \a ok is true.
+     */
+    void finished(bool ok, QString destination);
+
+    /*!
+     * \brief snapshotFinished is emitted when the snapshot export ends. The file is already synced to the device when \a ok is true.
+     * \param hashes are the digests of the packets in the file.
+     */
+    void snapshotFinished(bool ok, QString destination, QStringList hashes);
+
+private:
+    void copy(const QString &source, const QString &device);
+    bool copyFile(const QString &source, const QString &partPath, qint64 &resumedBytes);
+    void copySnapshot(const QString &device, PackagerInterface *packager);
+
+    QString m_module;
+    QFuture<void> m_future;
+};
+
+#endif // EXPORTCOPIER_H
@@ -35,9 +35,11 @@
 #include <QDir>
 #include <QTimer>
 #include <functional>
+#include <unistd.h>
 
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QJsonObject>
 #include <QProcess>
 #include <QRegularExpression>
 
@@ -51,18 +53,39 @@
 
 #include "exportlocaldata.h"
 #include "blinkled.h"
+#include "mountwatcher.h"
+#include "exportcopier.h"
+
+namespace {
+
+// The red led stays on for some time after the export, so the user can see it
+const int KDeviceLedDelay = 5000;
+const int KTempLedDelay = 1000;
+// Time the system has to mount a device after it is connected
+const int KMountTimeout = 30000;
+
+}
 
 ExportLocalData::ExportLocalData(QObject *parent) :
     QObject(parent),
-    m_blinkLed(0)
+    m_blinkLed(0),
+    m_mountWatcher(0),
+    m_copier(0),
+    m_lastProgress(0)
 {
     m_module = "ExportModule";
     m_blinkLed = new BlinkLed(this);
+    m_mountWatcher = new MountWatcher(this);
+    connect(m_mountWatcher, SIGNAL(mounted(QString)), SLOT(exportAction(QString)));
+    m_copier = new ExportCopier(this);
+    connect(m_copier, SIGNAL(progress(qint64,qint64)), SLOT(exportProgress(qint64,qint64)));
+    connect(m_copier, SIGNAL(finished(bool,QString)), SLOT(exportFinished(bool,QString)));
+    connect(m_copier, SIGNAL(snapshotFinished(bool,QString,QStringList)), SLOT(exportSnapshotFinished(bool,QString,QStringList)));
 
     // Object to manipulate file
 //    m_tempFile.setFileName(QCoreApplication::applicationDirPath() + "/TempExport.fish");
 
-    m_fileName = QCoreApplication::applicationDirPath() + "/TempExport.fish";
+    m_fileName = QCoreApplication::applicationDirPath() + "/TempExport.jsonl";
 }
 
 ExportLocalData::~ExportLocalData()
@@ -71,6 +94,8 @@ ExportLocalData::~ExportLocalData()
 
 void ExportLocalData::startExport()
 {
+    prepareTempFile();
+
     // Timer to export data to temporary file
     m_exportTime = new QTimer(this);
     m_exportTime->setInterval(exportTime);
@@ -82,61 +107,97 @@ void ExportLocalData::startExport()
 // Export temporary file to an external device.
 bool ExportLocalData::exportToDevice(QString device)
 {
-    // turns off leds red and green
-    m_blinkLed->blinkGreenLed(0);
-    m_blinkLed->blinkRedLed(0);
+    // if device path is empty there's no device capable to recive the file
+    if(device.isEmpty()){
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("EXPORT ERROR: Can\'t export to external device"));
+        return false;
+    }
+    if(m_copier->isRunning()){
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("An export is already running"));
+        return false;
+    }
 
-    // turn on red led
-    m_blinkLed->blinkRedLed(1);
+    // turns off the green led and turns on the red led
+    m_blinkLed->deviceRemoved();
+    m_blinkLed->startWorking();
 
-    bool returnValue = true;
+    m_device = device;
 
-    QTimer timer;
-    timer.start(5000);
+    // If the temp file doesn't exist, has nothing to be exported
+    if(!QFile::exists(m_fileName)){
+        if(isSnapshotMode() && packager()){
+            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exporting database snapshot to %1").arg(device));
+            return m_copier->startSnapshot(device, packager());
+        }
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("There's nothing to be exported"));
+        m_blinkLed->finishWorking(KDeviceLedDelay, true);
+        return true;
+    }
 
-    // if device path is empty there's no device capable to recive the file
-    if(!device.isEmpty()){
-        try{
-            // export data to external device
-            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exporting temp file to %1").arg(device));
-
-            // name of file to save on device (absolute path)
-            QString destinationPath(device + "/export_" + QDateTime::currentDateTime().toString().replace(" ", "_").replace(":","") + ".fish");
-
-            // If the temp file doesn't exist, has nothing to be exported
-            if(QFile::exists(m_fileName)){
-                if(QFile::copy(m_fileName, destinationPath)){
-                    if(!QFile::remove(m_fileName)){
-                        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("ERROR to remove temp file from disk"));
-                        throw std::exception();
-                    }
-                } else {
-                    Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("ERROR to copy temp file to device"));
-                    throw std::exception();
-                }
-            } else {
-                Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("There's nothing to be exported"));
-                returnValue = true;
-            }
-        }catch(std::exception &e){
-            Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Erro: %1").arg(e.what()));
-            returnValue = false;
+    // export data to external device. The temp file is not changed until the copy finishes.
+    Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exporting temp file to %1").arg(device));
+    m_lastProgress = 0;
+    return m_copier->start(m_fileName, device);
+}
+
+void ExportLocalData::exportProgress(qint64 written, qint64 total)
+{
+    int percent = total > 0 ? int(written * 100 / total) : 100;
+    if(percent / 10 > m_lastProgress / 10){
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exported %1% (%2 of %3 bytes)").arg(percent).arg(written).arg(total));
+    }
+    m_lastProgress = percent;
+}
+
+void ExportLocalData::exportFinished(bool ok, QString destination)
+{
+    if(ok){
+        // The packets left in the file by the previous execution are in the device now
+        if(!m_exportedPackets.isEmpty() && packager()){
+            packager()->markExported(m_exportedPackets.toList());
+            m_exportedPackets.clear();
         }
-    } else {
-        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("EXPORT ERROR: Can\'t export to external device"));
-        returnValue = false;
+        if(!QFile::remove(m_fileName)){
+            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("ERROR to remove temp file from disk"));
+        }
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exportation finished: %1").arg(destination));
+
+        // A temporary file left by the file mode goes first, then the packets still in the database
+        if(isSnapshotMode() && packager() && m_copier->startSnapshot(m_device, packager()))
+            return;
+    }else{
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("ERROR to copy temp file to device"));
+    }
+
+    // turns off the red led and, if the data was successfully exported, turns on the green led after five(5) seconds
+    m_blinkLed->finishWorking(KDeviceLedDelay, ok);
+}
+
+void ExportLocalData::exportSnapshotFinished(bool ok, QString destination, QStringList hashes)
+{
+    if(ok){
+        if(!hashes.isEmpty())
+            packager()->markExported(hashes);
+        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exportation finished: %1").arg(destination.isEmpty() ? QString("nothing to export") : destination));
+    }else{
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("ERROR to export the database snapshot to device"));
     }
 
-    // wait five(5) seconds before turn off the red led
-    while(timer.remainingTime() > 0)
-        ;
-    // turns off the red led
-    m_blinkLed->blinkRedLed(0);
-    // turns on the green led
-    m_blinkLed->blinkGreenLed(1);
+    m_blinkLed->finishWorking(KDeviceLedDelay, ok);
+}
+
+bool ExportLocalData::isSnapshotMode() const
+{
+    return RFIDMonitor::instance()->exportMode() == "snapshot";
+}
 
-    // return true only if the data was successfully exported
-    return returnValue;
+PackagerInterface * ExportLocalData::packager()
+{
+    static PackagerInterface *packager = 0;
+    if(!packager) {
+        packager = RFIDMonitor::instance()->defaultService<PackagerInterface>();
+    }
+    return packager;
 }
 
 void ExportLocalData::exportAction(QString path)
@@ -145,86 +206,79 @@ void ExportLocalData::exportAction(QString path)
     if(path == "temp"){
         exportToTempFile();
     } else {
-        if(exportToDevice(path)){
-            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exportation finished"));
-        }
+        exportToDevice(path);
     }
 }
 
 // SLOT
 void ExportLocalData::turnOffLed()
 {
-    m_blinkLed->blinkGreenLed(0);
+    m_blinkLed->deviceRemoved();
+}
+
+void ExportLocalData::waitForDevice()
+{
+    m_mountWatcher->watch(KMountTimeout);
 }
 
 // search for data with non-sync status and export these datas into a temp file. If the file doesn't exist create a file
 bool ExportLocalData::exportToTempFile()
 {
     // if a server is connected than has no need to export into a temporary file. Return false.
-    if(!RFIDMonitor::instance()->isconnected()){
-        static PackagerInterface *packager = 0;
-        if(!packager) {
-            packager = qobject_cast<PackagerInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KPackager));
-        }
-
-        if(packager){
+    // While the file is copied into a device, the new packets wait in the database for the next export
+    if(m_copier->isRunning())
+        return false;
 
-            QFile tempFile;
-            tempFile.setFileName(m_fileName);
+    // In the snapshot mode the packets are written into the device straight from the database
+    if(isSnapshotMode())
+        return false;
 
-            // try to open a file to read the records to be exported. Return false if the file cannot be opened for some reason
-            if (!tempFile.open(QIODevice::ReadOnly)){
-                Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("File [%1] does not exist yet.").arg(m_fileName));
-            }
+    if(!RFIDMonitor::instance()->isconnected()){
+        PackagerInterface *packager = this->packager();
+        if(packager){
 
-            QMap<QString, QByteArray> allData = packager->getAll();
-            QMap<QString, QByteArray>::iterator i;
-
-            // if have no packets to be exported, turns off the red led (after 1 seconds) and than return.
-            if(allData.size() <= 0){
-                // Turn off the red LED after 1 second
-                QTimer timer;
-                timer.start(1000);
-                while(timer.remainingTime() > 0)
-                    ;
-                // turn off red led
-                m_blinkLed->blinkRedLed(0);
-                return true;
+            // The packets found in the file by prepareTempFile() may not have been marked when the collector stopped
+            if(!m_exportedPackets.isEmpty()){
+                packager->markExported(m_exportedPackets.toList());
+                m_exportedPackets.clear();
             }
-            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exporting %1 Packets to %2").arg(allData.size()).arg(m_fileName));
 
-            QByteArray saveData = tempFile.readAll();
-            tempFile.close();
-
-            QJsonArray loadDoc(QJsonDocument::fromJson(saveData).array());
-
-            // turn on red led
-            m_blinkLed->blinkRedLed(1);
-
-            // try to open a file to write the records to be exported. Return false if the file cannot be opened for some reason
-            if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+            QFile tempFile(m_fileName);
+            // try to open a file to append the records to be exported. Return false if the file cannot be opened for some reason
+            if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Append)){
                 Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Error to write into file %1").arg(m_fileName));
                 return false;
             }
 
-            if(allData.size() > 0){
-                for(i = allData.begin(); i != allData.end(); ++i){
-                    loadDoc.append(QJsonValue(QJsonDocument::fromJson(i.value()).object()));
-                }
-                tempFile.write(QJsonDocument(loadDoc).toJson());
-                tempFile.flush();
-
-                // close the file
+            // turn on red led
+            m_blinkLed->startWorking();
+
+            // One packet per line, straight from the database. The packets stay prepared for exportation until they are on the disk.
+            const qint64 startOffset = tempFile.size();
+            QStringList written;
+            int count = packager->exportPackets(&tempFile, written);
+            // The packets must survive a power loss, the device is turned off by unplugging it
+            if(count < 0 || !tempFile.flush() || ::fsync(tempFile.handle()) != 0){
+                // A partial line would be joined to the next packet appended, so the whole export is cut off
+                Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error to write into file %1, the packets stay in the database for the next export: %2").arg(m_fileName).arg(tempFile.errorString()));
+                if(!tempFile.resize(startOffset))
+                    Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error to cut file %1 back to %2 bytes").arg(m_fileName).arg(startOffset));
                 tempFile.close();
+                m_blinkLed->finishWorking(0, false);
+                return false;
+            }
+            tempFile.close();
 
-                // Turn off the red LED after 1 second
-                QTimer timer;
-                timer.start(1000);
-                while(timer.remainingTime() > 0)
-                    ;
-                // turn off red led
-                m_blinkLed->blinkRedLed(0);
+            if(count > 0){
+                Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Exported %1 Packets to %2").arg(count).arg(m_fileName));
+                packager->markExported(written);
+            }else if(startOffset == 0){
+                // Nothing to be exported, an empty file would be copied to the device
+                QFile::remove(m_fileName);
             }
+
+            // Turn off the red LED after 1 second
+            m_blinkLed->finishWorking(KTempLedDelay, false);
         }else{
             Logger::instance()->writeRecord(Logger::severity_level::debug, "synchronizer", Q_FUNC_INFO, QString("Packager is not working!"));
             return false;
@@ -234,3 +288,52 @@ bool ExportLocalData::exportToTempFile()
     }
     return true;
 }
+
+void ExportLocalData::prepareTempFile()
+{
+    QFile tempFile(m_fileName);
+
+    // Files exported by older versions keep all the packets in one JSON array. They are rewritten as lines once.
+    QString legacyFileName(QCoreApplication::applicationDirPath() + "/TempExport.fish");
+    if(QFile::exists(legacyFileName)){
+        QFile legacyFile(legacyFileName);
+        if(legacyFile.open(QIODevice::ReadOnly) && tempFile.open(QIODevice::WriteOnly | QIODevice::Append)){
+            QJsonArray packets(QJsonDocument::fromJson(legacyFile.readAll()).array());
+            foreach (const QJsonValue &packet, packets) {
+                tempFile.write(QJsonDocument(packet.toObject()).toJson(QJsonDocument::Compact).append('\n'));
+            }
+            // The old file is removed only when the converted packets are on the disk
+            bool synced = tempFile.flush() && ::fsync(tempFile.handle()) == 0;
+            tempFile.close();
+            legacyFile.close();
+            if(synced){
+                legacyFile.remove();
+                Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("%1 packets converted from %2").arg(packets.size()).arg(legacyFileName));
+            }else{
+                Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error to sync file %1, %2 is kept").arg(m_fileName).arg(legacyFileName));
+            }
+        }
+    }
+
+    if(!tempFile.open(QIODevice::ReadWrite))
+        return;
+
+    // Load the digests of the complete lines. A line without the final new line was not completely written and is cut off.
+    qint64 validSize = 0;
+    while(!tempFile.atEnd()){
+        QByteArray line(tempFile.readLine());
+        if(!line.endsWith('\n'))
+            break;
+        validSize += line.size();
+
+        QJsonObject summary(QJsonDocument::fromJson(line).object().value("datasummary").toObject());
+        QString digest(summary.value("md5diggest").toString());
+        if(!digest.isEmpty())
+            m_exportedPackets.insert(digest);
+    }
+    if(validSize < tempFile.size()){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Cutting %1 bytes of an incomplete packet from %2").arg(tempFile.size() - validSize).arg(m_fileName));
+        tempFile.resize(validSize);
+    }
+    tempFile.close();
+}
@@ -38,6 +38,10 @@
 * change the sync flag of the temporary registers and then update the database with their current values.
 * While the program is writing the exported data in the device, the application turns the red led on,
 * after writing all the data the red led are turned off and the green led on until remove the device.
+*
+* The temporary file is in the JSON Lines format: each line is one synchronization packet in compact JSON.
+* New packets are only appended to the file, so a crash can at most leave an incomplete last line, which is cut on the next start.
+* The importer on the server can read the file one line at a time.
 */
 
 #include <QString>
@@ -47,8 +51,12 @@
 #include <QObject>
 #include <QTimer>
 #include <QThread>
+#include <QSet>
 
 class BlinkLed;
+class MountWatcher;
+class ExportCopier;
+class PackagerInterface;
 class Rfiddata;
 
 class ExportLocalData : public QObject
@@ -73,6 +81,24 @@ public slots:
      */
     void exportAction(QString path = "temp");
 
+    /*!
+     * \brief waitForDevice is called when an external device is connected. The data is exported as soon as the system mounts the device.
+     */
+    void waitForDevice();
+
+private slots:
+    void exportProgress(qint64 written, qint64 total);
+
+    /*!
+     * \brief exportFinished removes the temporary file from local disk once it was copied and verified in the device.
+     */
+    void exportFinished(bool ok, QString destination);
+
+    /*!
+     * \brief exportSnapshotFinished marks the packets written in the device as exported. It is called only after the file was synced.
+     */
+    void exportSnapshotFinished(bool ok, QString destination, QStringList hashes);
+
     /*!
      * \brief startExport is the function that starts this class like thread and starts a QTimer to export temporary file
      */
@@ -85,11 +111,23 @@ private:
     bool exportToTempFile();
 
     /*!
-     * \brief exportToDevice receive device's path to copy file into it.
-     * Once the data is successfully exported, it will delete the temporary file from local disk.
+     * \brief exportToDevice receive device's path and starts to copy the file into it in background.
+     * Once the data is successfully exported, exportFinished() deletes the temporary file from local disk.
      */
     bool exportToDevice(QString device);
 
+    /*!
+     * \brief prepareTempFile cuts an incomplete last line of the temporary file, converts the old JSON array file and loads the packets already exported.
+     */
+    void prepareTempFile();
+
+    /*!
+     * \brief isSnapshotMode is true when the packets are exported straight from the database, without the temporary file.
+     */
+    bool isSnapshotMode() const;
+
+    PackagerInterface * packager();
+
     // Name of the module. Is used to write log records
     QString m_module;
 
@@ -106,11 +144,23 @@ private:
 
     QString m_fileName;
 
+    // Digests of the packets found in the temporary file by prepareTempFile(), marked as exported by the next export.
+    QSet<QString> m_exportedPackets;
+
     /*!
      * \brief m_blickLed is an object to manipulate the green and red leds, which are used to show to the user the status of process
      */
     BlinkLed *m_blinkLed;
 
+    // Waits for the external device to be mounted
+    MountWatcher *m_mountWatcher;
+
+    // Copies the temporary file into the device
+    ExportCopier *m_copier;
+    // Device of the running export
+    QString m_device;
+    int m_lastProgress;
+
     // Time that define the interval to export data to temporary file
     int exportTime = 1000*60;
 };
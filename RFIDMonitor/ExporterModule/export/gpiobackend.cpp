@@ -0,0 +1,231 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QMap>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <logger.h>
+
+#include "gpiobackend.h"
+#include "gpiointerface.h"
+
+namespace {
+
+/*!
+ * \brief The MmapGpioBackend class writes the GPIO registers of the BCM2835 mapped from /dev/gpiomem.
+ */
+class MmapGpioBackend : public GpioBackend
+{
+public:
+    // Offsets of the registers in 32 bits words
+    enum Register {KFunctionSelect = 0, KOutputSet = 7, KOutputClear = 10, KLevel = 13};
+
+    MmapGpioBackend() :
+        m_registers(0)
+    {
+        int fd = ::open("/dev/gpiomem", O_RDWR | O_SYNC);
+        if(fd < 0)
+            return;
+        void *map = ::mmap(0, KBlockSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        // The mapping stays valid after the file is closed
+        ::close(fd);
+        if(map != MAP_FAILED)
+            m_registers = static_cast<volatile quint32 *>(map);
+    }
+
+    ~MmapGpioBackend()
+    {
+        if(m_registers)
+            ::munmap(const_cast<quint32 *>(m_registers), KBlockSize);
+    }
+
+    bool isValid() const
+    {
+        return m_registers != 0;
+    }
+
+    QString name() const
+    {
+        return "mmap";
+    }
+
+    bool setup(int pin)
+    {
+        if(pin < 0 || pin > 31)
+            return false;
+        // 3 bits per pin, 10 pins per register. 001 is output
+        volatile quint32 *select = m_registers + KFunctionSelect + pin / 10;
+        int shift = (pin % 10) * 3;
+        *select = (*select & ~(7u << shift)) | (1u << shift);
+        return true;
+    }
+
+    void write(int pin, int value)
+    {
+        m_registers[value ? KOutputSet : KOutputClear] = 1u << pin;
+    }
+
+    int value(int pin) const
+    {
+        if(pin < 0 || pin > 31)
+            return -1;
+        return (m_registers[KLevel] >> pin) & 1;
+    }
+
+    void release(int pin)
+    {
+        if(pin < 0 || pin > 31)
+            return;
+        // Back to input, as the pin was before setup
+        volatile quint32 *select = m_registers + KFunctionSelect + pin / 10;
+        *select &= ~(7u << ((pin % 10) * 3));
+    }
+
+private:
+    static const size_t KBlockSize = 4096;
+    volatile quint32 *m_registers;
+};
+
+/*!
+ * \brief The SysfsGpioBackend class uses the sysfs interface of gpiointerface, keeping the value files open.
+ */
+class SysfsGpioBackend : public GpioBackend
+{
+public:
+    ~SysfsGpioBackend()
+    {
+        foreach (int pin, m_valueFds.keys()) {
+            release(pin);
+        }
+    }
+
+    QString name() const
+    {
+        return "sysfs";
+    }
+
+    bool setup(int pin)
+    {
+        if(GPIOExport(pin) != 0 || GPIODirection(pin, 1) != 0)
+            return false;
+
+        QByteArray path(QString("/sys/class/gpio/gpio%1/value").arg(pin).toLatin1());
+        int fd = ::open(path.constData(), O_RDWR);
+        if(fd < 0)
+            return false;
+        m_valueFds.insert(pin, fd);
+        return true;
+    }
+
+    void write(int pin, int value)
+    {
+        int fd = m_valueFds.value(pin, -1);
+        if(fd >= 0)
+            ::pwrite(fd, value ? "1" : "0", 1, 0);
+    }
+
+    int value(int pin) const
+    {
+        int fd = m_valueFds.value(pin, -1);
+        char level;
+        if(fd < 0 || ::pread(fd, &level, 1, 0) != 1)
+            return -1;
+        return level == '1' ? 1 : 0;
+    }
+
+    void release(int pin)
+    {
+        // A pin whose setup failed was never exported
+        if(!m_valueFds.contains(pin))
+            return;
+        ::close(m_valueFds.take(pin));
+        GPIOUnexport(pin);
+    }
+
+private:
+    QMap<int, int> m_valueFds;
+};
+
+/*!
+ * \brief The FakeGpioBackend class keeps the values of the pins in memory.
+ */
+class FakeGpioBackend : public GpioBackend
+{
+public:
+    QString name() const
+    {
+        return "fake";
+    }
+
+    bool setup(int pin)
+    {
+        m_values.insert(pin, 0);
+        return true;
+    }
+
+    void write(int pin, int value)
+    {
+        if(m_values.value(pin, 0) != value)
+            Logger::instance()->writeRecord(Logger::severity_level::debug, "ExportModule", Q_FUNC_INFO, QString("GPIO %1 = %2").arg(pin).arg(value));
+        m_values.insert(pin, value);
+    }
+
+    int value(int pin) const
+    {
+        return m_values.value(pin, -1);
+    }
+
+    void release(int pin)
+    {
+        m_values.remove(pin);
+    }
+
+private:
+    QMap<int, int> m_values;
+};
+
+}
+
+GpioBackend *GpioBackend::create(const QString &name)
+{
+    if(name == "fake")
+        return new FakeGpioBackend;
+    if(name == "sysfs")
+        return new SysfsGpioBackend;
+
+    MmapGpioBackend *mmapBackend = new MmapGpioBackend;
+    if(mmapBackend->isValid())
+        return mmapBackend;
+    delete mmapBackend;
+
+    Logger::instance()->writeRecord(Logger::severity_level::warning, "ExportModule", Q_FUNC_INFO, "Can't map /dev/gpiomem, using sysfs");
+    return new SysfsGpioBackend;
+}
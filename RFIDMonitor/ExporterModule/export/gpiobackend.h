@@ -0,0 +1,75 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef GPIOBACKEND_H
+#define GPIOBACKEND_H
+
+#include <QString>
+
+/*!
+ * \brief The GpioBackend class is the common interface of the ways to drive the GPIO output pins used by the leds.
+ *
+ * - "mmap" maps the GPIO registers of the BCM2835 through /dev/gpiomem. A write is a single store into the set or clear register, without any system call.
+ * - "sysfs" uses /sys/class/gpio, but keeps the value file of each pin open, so a write is one pwrite() instead of open, write and close.
+ * - "fake" keeps the values in memory, to run the exporter in a computer without GPIO.
+ *
+ * The pins are the BCM GPIO numbers.
+ */
+class GpioBackend
+{
+public:
+    virtual ~GpioBackend() {}
+
+    virtual QString name() const = 0;
+
+    /*!
+     * \brief setup prepares \a pin to be used as an output.
+     * \return false if the pin can't be used.
+     */
+    virtual bool setup(int pin) = 0;
+
+    virtual void write(int pin, int value) = 0;
+
+    /*!
+     * \brief value returns the level of \a pin, or -1 if the pin was not set up.
+     */
+    virtual int value(int pin) const = 0;
+
+    /*!
+     * \brief release gives the pin back to the system.
+     */
+    virtual void release(int pin) = 0;
+
+    /*!
+     * \brief create returns the backend named \a name ("mmap", "sysfs" or "fake"). "auto" or an unknown name
+     * tries the mmap backend and falls back to sysfs. The caller owns the returned object.
+     */
+    static GpioBackend * create(const QString &name);
+};
+
+#endif // GPIOBACKEND_H
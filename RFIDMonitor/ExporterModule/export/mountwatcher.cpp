@@ -0,0 +1,164 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <logger.h>
+
+#include "mountwatcher.h"
+
+MountWatcher::MountWatcher(QObject *parent) :
+    QObject(parent),
+    m_fd(-1),
+    m_notifier(0),
+    m_timeout(new QTimer(this))
+{
+    m_timeout->setSingleShot(true);
+    connect(m_timeout, SIGNAL(timeout()), SLOT(watchTimeout()));
+}
+
+MountWatcher::~MountWatcher()
+{
+    stop();
+}
+
+void MountWatcher::watch(int timeout)
+{
+    QString path(findMedia());
+    if(!path.isEmpty()){
+        stop();
+        emit mounted(path);
+        return;
+    }
+
+    if(m_fd < 0){
+        m_fd = ::open("/proc/self/mountinfo", O_RDONLY);
+        if(m_fd >= 0){
+            m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+            connect(m_notifier, SIGNAL(activated(int)), SLOT(mountsChanged()));
+        }else{
+            Logger::instance()->writeRecord(Logger::severity_level::error, "ExportModule", Q_FUNC_INFO, "Can't watch /proc/self/mountinfo");
+        }
+    }
+    m_timeout->start(timeout);
+}
+
+QString MountWatcher::findMedia()
+{
+    QString module("ExportModule");
+    QFile mounts("/proc/self/mountinfo");
+    if(!mounts.open(QIODevice::ReadOnly)){
+        Logger::instance()->writeRecord(Logger::severity_level::error, module, Q_FUNC_INFO, QString("Can't read %1").arg(mounts.fileName()));
+        return QString();
+    }
+
+    /* Each line of mountinfo is:
+     * 36 25 8:1 / /media/usb0 rw,relatime shared:1 - vfat /dev/sda1 rw,fmask=0022
+     * The mount point is the 5th field, the options the 6th. After the optional fields and the "-" come the file system and the source.
+     */
+    QString devicePath;
+    QList<QByteArray> lines(mounts.readAll().split('\n'));
+    foreach (const QByteArray &line, lines) {
+        QList<QByteArray> fields(line.split(' '));
+        int separator = fields.indexOf("-");
+        if(separator < 6 || fields.size() < separator + 3)
+            continue;
+
+        QString mountPoint(unescape(fields.at(4)));
+        QString source(unescape(fields.at(separator + 2)));
+        // use only devices mounted in /media directory
+        if(!source.startsWith("/dev/") || !mountPoint.startsWith("/media/"))
+            continue;
+
+        Logger::instance()->writeRecord(Logger::severity_level::info, module, Q_FUNC_INFO, QString("Inspectin device: %1").arg(mountPoint));
+        QFileInfo device(mountPoint);
+        // check if the device found is writable
+        if(fields.at(5).startsWith("rw") && device.isWritable()){
+            Logger::instance()->writeRecord(Logger::severity_level::info, module, Q_FUNC_INFO, QString("Using device: %1. Mount point: %2. File System: %3").arg(source).arg(mountPoint).arg(QString(fields.at(separator + 1))));
+            devicePath = mountPoint;
+        } else {
+            Logger::instance()->writeRecord(Logger::severity_level::info, module, Q_FUNC_INFO, QString("%1 is not writable").arg(mountPoint));
+        }
+    }
+    return devicePath;
+}
+
+QString MountWatcher::unescape(const QByteArray &field)
+{
+    // Spaces, tabs, new lines and back slashes are written as octal escapes, like \040
+    QByteArray result;
+    for(int i = 0; i < field.size(); ++i){
+        if(field.at(i) == '\\' && i + 3 < field.size()){
+            bool ok = false;
+            int value = field.mid(i + 1, 3).toInt(&ok, 8);
+            if(ok){
+                result.append(char(value));
+                i += 3;
+                continue;
+            }
+        }
+        result.append(field.at(i));
+    }
+    return QString::fromLocal8Bit(result);
+}
+
+void MountWatcher::mountsChanged()
+{
+    QString path(findMedia());
+    if(!path.isEmpty()){
+        stop();
+        emit mounted(path);
+    }
+}
+
+void MountWatcher::watchTimeout()
+{
+    // If was not found any device in /media write an info log record
+    Logger::instance()->writeRecord(Logger::severity_level::info, "ExportModule", Q_FUNC_INFO, QString("EXPORT ERROR: No media found to export data"));
+    stop();
+}
+
+void MountWatcher::stop()
+{
+    m_timeout->stop();
+    if(m_notifier){
+        delete m_notifier;
+        m_notifier = 0;
+    }
+    if(m_fd >= 0){
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
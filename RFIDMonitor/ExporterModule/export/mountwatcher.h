@@ -0,0 +1,76 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef MOUNTWATCHER_H
+#define MOUNTWATCHER_H
+
+#include <QObject>
+
+class QSocketNotifier;
+class QTimer;
+
+/*!
+ * \brief The MountWatcher class waits until a writable device is mounted in the /media directory.
+ *
+ * The kernel signals a change in the mount table as an exception condition on /proc/self/mountinfo, so the table is read again only when
+ * something was mounted or unmounted, instead of waiting a fixed time after the device is connected.
+ */
+class MountWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MountWatcher(QObject *parent = 0);
+    ~MountWatcher();
+
+    /*!
+     * \brief watch emits mounted() as soon as a writable device is found in /media. It gives up after \a timeout milliseconds.
+     */
+    void watch(int timeout);
+
+    /*!
+     * \brief findMedia returns the mount point of a writable device in /media, or an empty string if there is none.
+     */
+    static QString findMedia();
+
+signals:
+    void mounted(QString path);
+
+private slots:
+    void mountsChanged();
+    void watchTimeout();
+
+private:
+    void stop();
+    static QString unescape(const QByteArray &field);
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    QTimer *m_timeout;
+};
+
+#endif // MOUNTWATCHER_H
@@ -32,8 +32,7 @@ ExportService::ExportService(QObject *parent) :
     ExportInterface(parent)
 {
 //    m_exportThread = new QThread();
-    m_daemonThread = new QThread();
-    m_exporter = new ExportLocalData();
+    m_exporter = new ExportLocalData(this);
 }
 
 ExportService::~ExportService()
@@ -69,13 +68,13 @@ void ExportService::startUSBExport()
 //    QObject::connect(m_exportThread, SIGNAL(started()), m_exporter, SLOT(startExport()));
 
 
-    DeviceThread::instance()->moveToThread(m_daemonThread);
-    QObject::connect(m_daemonThread, SIGNAL(started()), DeviceThread::instance(), SLOT(startListening()));
-    QObject::connect(DeviceThread::instance(), SIGNAL(exportToDevice(QString)), m_exporter, SLOT(exportAction(QString)));
+    // The device listener runs in the event loop of the exporter thread
+    DeviceThread::instance()->moveToThread(thread());
+    QObject::connect(DeviceThread::instance(), SIGNAL(deviceAdded()), m_exporter, SLOT(waitForDevice()));
     QObject::connect(DeviceThread::instance(), SIGNAL(turnLedOff()), m_exporter, SLOT(turnOffLed()));
 
 //    m_exportThread->start();
-    m_daemonThread->start();
+    DeviceThread::instance()->startListening();
     m_exporter->startExport();
 }
 
@@ -88,6 +87,5 @@ void ExportService::stopUSBExport()
     m_exporter->deleteLater();
 //    m_exportThread->deleteLater();
 
-    m_daemonThread->exit(0);
-    m_daemonThread->deleteLater();
+    DeviceThread::instance()->stopListening();
 }
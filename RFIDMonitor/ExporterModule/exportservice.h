@@ -48,7 +48,6 @@ public:
     ServiceType type();
 
 private:
-    QThread *m_daemonThread;
     QThread *m_exportThread;
     ExportLocalData *m_exporter;
     DeviceThread *m_device;
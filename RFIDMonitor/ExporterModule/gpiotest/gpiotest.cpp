@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QtTest>
+
+#include <blinkled.h>
+#include <gpiobackend.h>
+
+class GpioTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fakeBackend();
+    void ledsOffAtStart();
+    void finishTurnsGreenOn();
+    void startCancelsFinish();
+    void deviceRemovedBeforeFinish();
+};
+
+void GpioTest::fakeBackend()
+{
+    GpioBackend *gpio = GpioBackend::create("fake");
+    QCOMPARE(gpio->name(), QString("fake"));
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), -1);
+
+    QVERIFY(gpio->setup(BlinkLed::KRedLed));
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 0);
+    gpio->write(BlinkLed::KRedLed, 1);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 1);
+    gpio->write(BlinkLed::KRedLed, 0);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 0);
+
+    gpio->release(BlinkLed::KRedLed);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), -1);
+    delete gpio;
+}
+
+void GpioTest::ledsOffAtStart()
+{
+    GpioBackend *gpio = GpioBackend::create("fake");
+    BlinkLed led(gpio);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 0);
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 0);
+
+    led.blinkRedLedSlot();
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 1);
+    led.blinkRedLedSlot();
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 0);
+}
+
+void GpioTest::finishTurnsGreenOn()
+{
+    GpioBackend *gpio = GpioBackend::create("fake");
+    BlinkLed led(gpio);
+
+    led.startWorking();
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 1);
+
+    // The caller doesn't wait, the red led is turned off by the timer
+    led.finishWorking(50, true);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 1);
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 0);
+    QTRY_COMPARE(gpio->value(BlinkLed::KRedLed), 0);
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 1);
+
+    led.deviceRemoved();
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 0);
+}
+
+void GpioTest::startCancelsFinish()
+{
+    GpioBackend *gpio = GpioBackend::create("fake");
+    BlinkLed led(gpio);
+
+    led.startWorking();
+    led.finishWorking(50, false);
+    led.startWorking();
+    QTest::qWait(150);
+    QCOMPARE(gpio->value(BlinkLed::KRedLed), 1);
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 0);
+}
+
+void GpioTest::deviceRemovedBeforeFinish()
+{
+    GpioBackend *gpio = GpioBackend::create("fake");
+    BlinkLed led(gpio);
+
+    led.startWorking();
+    led.finishWorking(50, true);
+    led.deviceRemoved();
+    QTRY_COMPARE(gpio->value(BlinkLed::KRedLed), 0);
+    QCOMPARE(gpio->value(BlinkLed::KGreenLed), 0);
+}
+
+QTEST_GUILESS_MAIN(GpioTest)
+
+#include "gpiotest.moc"
@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# Tests of the led signaling with the fake GPIO backend, run with "make check"
+#
+#-------------------------------------------------
+
+QT       += core testlib
+
+QT       -= gui
+
+TARGET = GpioTest
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../CoreLibrary ../export
+
+LIBS += -L$$OUT_PWD/../../CoreLibrary
+LIBS += -lCoreLibrary
+
+SOURCES += \
+    gpiotest.cpp \
+    ../export/blinkled.cpp \
+    ../export/gpiobackend.cpp \
+    ../export/gpiointerface.c
+
+HEADERS += \
+    ../export/blinkled.h \
+    ../export/gpiobackend.h \
+    ../export/gpiointerface.h
+
+QMAKE_CXXFLAGS += -std=c++11
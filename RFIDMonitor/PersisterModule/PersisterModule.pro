@@ -14,11 +14,13 @@ INCLUDEPATH += ../CoreLibrary
 
 SOURCES += \
     data/dao/rfiddatadao.cpp \
+    data/dao/rfiddatapartitions.cpp \
     persistencemodule.cpp \
     persistenceservice.cpp
 
 HEADERS += \
     data/dao/rfiddatadao.h \
+    data/dao/rfiddatapartitions.h \
     persistencemodule.h \
     persistenceservice.h
 
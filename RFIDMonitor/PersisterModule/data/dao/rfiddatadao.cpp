@@ -7,24 +7,35 @@
 #include <QSqlDatabase>
 #include <QSqlRecord>
 #include <QSharedPointer>
+
+#include <algorithm>
+
 #include <logger.h>
 
 #include <rfidmonitor.h>
 
 #include <core/sql/sqlquery.h>
+#include <core/clock.h>
 #include <core/functions.h>
 #include <core/connectionpool.h>
 
 #include "rfiddatadao.h"
+#include "rfiddatapartitions.h"
 #include "object/rfiddata.h"
 
 RfiddataDAO::RfiddataDAO(QObject *parent) :
-    GenericDAO<Rfiddata>(parent)
+    GenericDAO<Rfiddata>(parent),
+    m_partitions(0)
 {
     setObjectName("RfiddataDAO");
     m_module = "PersistenceModule";
 }
 
+RfiddataDAO::~RfiddataDAO()
+{
+    delete m_partitions;
+}
+
 QString RfiddataDAO::serviceNameInsertObject() const
 {
     return "persistence.insert_object";
@@ -44,6 +55,22 @@ RfiddataDAO * RfiddataDAO::instance()
     return singleton.data();
 }
 
+/*!
+ * \brief RfiddataDAO::database gets the connection with the database and prepares the day partitions on the first use.
+ * On a new day it also drops the partitions that are not needed anymore.
+ */
+QSqlDatabase * RfiddataDAO::database()
+{
+    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    if(!m_partitions){
+        m_partitions = new RfiddataPartitions(m_module);
+        m_partitions->init(db);
+    }else if(m_partitions->isMaintenancePending()){
+        m_partitions->maintenance(db);
+    }
+    return db;
+}
+
 /*!
  * \brief RfiddataDAO::insertObject Offers the way to persist 1 Rfiddata object.
  * \param rfiddata is the object to be inserted.
@@ -51,48 +78,19 @@ RfiddataDAO * RfiddataDAO::instance()
  */
 bool RfiddataDAO::insertObject(Rfiddata *rfiddata)
 {
-    // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
-
-    // Start new transaction.
-    db->transaction();
-
-    try{
-        // Get the new available sequence from database to the new object.
-        qlonglong id = Functions::getSequence("seq_rfiddata", db);
-        rfiddata->setId(id);
-
-        //Create the query.
-        SqlQuery query(db);
-        query.prepare("insert into rfiddata (id, idantena, idpontocoleta, applicationcode, identificationcode, datetime, sync) "
-                      " values(:id, :idantena, :idpontocoleta, :applicationcode, :identificationcode, :datetime, :sync) ");
-        query.bindValue(":id", rfiddata->id());
-        query.bindValue(":idantena", rfiddata->idantena());
-        query.bindValue(":idpontocoleta", rfiddata->idpontocoleta());
-        query.bindValue(":applicationcode", rfiddata->applicationcode());
-        query.bindValue(":identificationcode", rfiddata->identificationcode());
-        query.bindValue(":datetime", rfiddata->datetime());
-        query.bindValue(":sync", rfiddata->sync());
-
-        // Execute the query.
-        query.exec();
-
-        // Commit and terminate the transaction.
-        db->commit();
-        return true;
-
-    }catch(SqlException &ex){
-        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
-        //If is there any exception caught, do rollback and close the transaction, aborting the insertion.
-        db->rollback();
-        return false;
-    }
+    return insertObjectList(QList<Rfiddata *>() << rfiddata);
 }
 
+/*!
+ * \brief RfiddataDAO::insertObjectList Offers the way to persist a list of Rfiddata objects in one transaction.
+ * Each object goes to the partition of the day it was read.
+ * \param list is the list of Rfiddata objects to be inserted.
+ * \return true if successfully inserted the whole list, false otherwise.
+ */
 bool RfiddataDAO::insertObjectList(const QList<Rfiddata *> &list)
 {
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     // Start new transaction.
     db->transaction();
@@ -103,21 +101,25 @@ bool RfiddataDAO::insertObjectList(const QList<Rfiddata *> &list)
             qlonglong id = Functions::getSequence("seq_rfiddata", db);
             rfiddata->setId(id);
 
+            QString partition = m_partitions->partitionFor(Clock::toDateTime(rfiddata->timestamp()), db);
+
             //Create the query.
             SqlQuery query(db);
-            query.prepare("insert into rfiddata (id, idantena, idpontocoleta, applicationcode, identificationcode, datetime, sync) "
-                          " values(:id, :idantena, :idpontocoleta, :applicationcode, :identificationcode, :datetime, :sync) ");
+            query.prepare(QString("insert into %1 (id, idantena, idpontocoleta, applicationcode, identificationcode, timestamp, sync) "
+                                  " values(:id, :idantena, :idpontocoleta, :applicationcode, :identificationcode, :timestamp, :sync) ").arg(partition));
             query.bindValue(":id", rfiddata->id());
             query.bindValue(":idantena", rfiddata->idantena());
             query.bindValue(":idpontocoleta", rfiddata->idpontocoleta());
             query.bindValue(":applicationcode", rfiddata->applicationcode());
             query.bindValue(":identificationcode", rfiddata->identificationcode());
-            query.bindValue(":datetime", rfiddata->datetime());
+            query.bindValue(":timestamp", rfiddata->timestamp());
             query.bindValue(":sync", rfiddata->sync());
 
             // Execute the query.
             query.exec();
+            m_partitions->addId(partition, id);
         }
+        m_partitions->saveRanges(db);
 
         // Commit and terminate the transaction.
         db->commit();
@@ -127,6 +129,8 @@ bool RfiddataDAO::insertObjectList(const QList<Rfiddata *> &list)
         Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
         //If is there any exception caught, do rollback and close the transaction, aborting the insertion.
         db->rollback();
+        // The partitions created in the transaction don't exist anymore
+        m_partitions->reload(db);
         return false;
     }
 }
@@ -138,41 +142,13 @@ bool RfiddataDAO::insertObjectList(const QList<Rfiddata *> &list)
  */
 bool RfiddataDAO::updateObject(Rfiddata *rfiddata)
 {
-    // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
-
-    // Check if the Rfiddata object have the id. If haven't there is no way to update it. LUIS Se est´a bem aqui, tem que colocar no updateList tmb.
+    // Check if the Rfiddata object have the id. If haven't there is no way to update it.
     if(rfiddata->id().isNull()){
         Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Object Without ID"));
         return false;
     }
 
-    // Start new transaction.
-    db->transaction();
-
-    try{
-        SqlQuery query(db);
-        query.prepare("update rfiddata set idantena = :idantena, idpontocoleta = :idpontocoleta, applicationcode = :applicationcode, identificationcode = :identificationcode, "
-                      "datetime = :datetime, sync = :sync where id = :id ");
-        query.bindValue(":id", rfiddata->id());
-        query.bindValue(":idantena", rfiddata->idantena());
-        query.bindValue(":idpontocoleta", rfiddata->idpontocoleta());
-        query.bindValue(":applicationcode", rfiddata->applicationcode());
-        query.bindValue(":identificationcode", rfiddata->identificationcode());
-        query.bindValue(":datetime", rfiddata->datetime());
-        query.bindValue(":sync", rfiddata->sync());
-        query.exec();
-
-        // Commit and terminate the transaction.
-        db->commit();
-        return true;
-
-    }catch(SqlException &ex){
-        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
-        //If is there any exception caught, do rollback and close the transaction, aborting the insertion.
-        db->rollback();
-        return false;
-    }
+    return updateObjectList(QList<Rfiddata *>() << rfiddata);
 }
 
 /*!
@@ -183,7 +159,7 @@ bool RfiddataDAO::updateObject(Rfiddata *rfiddata)
 bool RfiddataDAO::updateObjectList(const QList<Rfiddata *> &list)
 {
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     // Start new transaction.
     db->transaction();
@@ -191,17 +167,22 @@ bool RfiddataDAO::updateObjectList(const QList<Rfiddata *> &list)
         // Loop for all objects in the list.
         foreach (Rfiddata *rfiddata, list) {
 
-            SqlQuery query(db);
-            query.prepare("update rfiddata set idantena = :idantena, idpontocoleta = :idpontocoleta, applicationcode = :applicationcode, identificationcode = :identificationcode, "
-                          "datetime = :datetime, sync = :sync where id = :id ");
-            query.bindValue(":id", rfiddata->id());
-            query.bindValue(":idantena", rfiddata->idantena());
-            query.bindValue(":idpontocoleta", rfiddata->idpontocoleta());
-            query.bindValue(":applicationcode", rfiddata->applicationcode());
-            query.bindValue(":identificationcode", rfiddata->identificationcode());
-            query.bindValue(":datetime", rfiddata->datetime());
-            query.bindValue(":sync", rfiddata->sync());
-            query.exec();
+            // The id is looked for only in the partitions whose range contains it
+            foreach (const QString &partition, m_partitions->partitionsOf(rfiddata->id().toLongLong())) {
+                SqlQuery query(db);
+                query.prepare(QString("update %1 set idantena = :idantena, idpontocoleta = :idpontocoleta, applicationcode = :applicationcode, identificationcode = :identificationcode, "
+                                      "timestamp = :timestamp, sync = :sync where id = :id ").arg(partition));
+                query.bindValue(":id", rfiddata->id());
+                query.bindValue(":idantena", rfiddata->idantena());
+                query.bindValue(":idpontocoleta", rfiddata->idpontocoleta());
+                query.bindValue(":applicationcode", rfiddata->applicationcode());
+                query.bindValue(":identificationcode", rfiddata->identificationcode());
+                query.bindValue(":timestamp", rfiddata->timestamp());
+                query.bindValue(":sync", rfiddata->sync());
+                query.exec();
+                if(query.numRowsAffected() > 0)
+                    break;
+            }
         }
 
         // Commit and terminate the transaction with the update of all objects inside.
@@ -223,49 +204,33 @@ bool RfiddataDAO::updateObjectList(const QList<Rfiddata *> &list)
  */
 bool RfiddataDAO::deleteObject(Rfiddata *rfiddata)
 {
-    // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
-
-    // Start new transaction.
-    db->transaction();
-
-    try{
-        SqlQuery query(db);
-        query.prepare("delete from rfiddata where id = :id");
-        query.bindValue(":id", rfiddata->id());
-        query.exec();
-
-        // Commit and terminate the transaction.
-        db->commit();
-        return true;
-
-    }catch(SqlException &ex){
-        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
-        //If is there any exception caught, do rollback and close the transaction, aborting the insertion.
-        db->rollback();
-        return false;
-    }
+    return deleteObjectList(QList<Rfiddata *>() << rfiddata);
 }
 
 /*!
  * \brief RfiddataDAO::deleteObjectList Offers the way to delete the whole list of Rfiddata objects.
+ * The partitions that become empty are dropped by the next maintenance of the partitions.
  * \param list is the list of Rfiddata objects to be deleted.
  * \return true if successfully deleted the whole list, false otherwise.
  */
 bool RfiddataDAO::deleteObjectList(const QList<Rfiddata *> &list)
 {
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     // Start new transaction.
     db->transaction();
 
     try{
         foreach (Rfiddata * rfiddata, list) {
-            SqlQuery query(db);
-            query.prepare("delete from rfiddata where id = :id");
-            query.bindValue(":id", rfiddata->id());
-            query.exec();            
+            foreach (const QString &partition, m_partitions->partitionsOf(rfiddata->id().toLongLong())) {
+                SqlQuery query(db);
+                query.prepare(QString("delete from %1 where id = :id").arg(partition));
+                query.bindValue(":id", rfiddata->id());
+                query.exec();
+                if(query.numRowsAffected() > 0)
+                    break;
+            }
         }
 
         // Commit and terminate the transaction.
@@ -289,22 +254,23 @@ bool RfiddataDAO::deleteObjectList(const QList<Rfiddata *> &list)
 Rfiddata * RfiddataDAO::getById(qlonglong id, QObject *parent)
 {
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     try{
-        SqlQuery query(db);
-        query.prepare("select id, idantena, idpontocoleta, applicationcode, identificationcode, datetime sync from rfiddata  where id = :id ");
-        query.bindValue(":id", id);
-        query.exec();
-        Rfiddata *rfiddata = 0;
-        if(query.next()){
-            /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
-             *a segmentation fault when try to use the returned pointer.
-             * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
-             */
-            rfiddata = new Rfiddata(query.record(), PARENT(parent));
+        foreach (const QString &partition, m_partitions->partitionsOf(id)) {
+            SqlQuery query(db);
+            query.prepare(QString("select id, idantena, idpontocoleta, applicationcode, identificationcode, timestamp, sync from %1 where id = :id ").arg(partition));
+            query.bindValue(":id", id);
+            query.exec();
+            if(query.next()){
+                /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
+                 *a segmentation fault when try to use the returned pointer.
+                 * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
+                 */
+                return new Rfiddata(query.record(), PARENT(parent));
+            }
         }
-        return rfiddata;
+        return 0;
     }catch(SqlException &ex){
         Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
         return 0;
@@ -321,18 +287,20 @@ QList<Rfiddata *> RfiddataDAO::getAll(QObject *parent)
     QList<Rfiddata *> list;
 
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     try{
-        SqlQuery query(db);
-        query.prepare("select id, idantena, idpontocoleta, applicationcode, identificationcode, datetime sync from rfiddata ");
-        query.exec();
-        while(query.next()){
-            /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
-             *a segmentation fault when try to use the returned pointer.
-             * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
-             */
-            list.append(new Rfiddata(query.record(), parent));
+        foreach (const QString &partition, m_partitions->names()) {
+            SqlQuery query(db);
+            query.prepare(QString("select id, idantena, idpontocoleta, applicationcode, identificationcode, timestamp, sync from %1 ").arg(partition));
+            query.exec();
+            while(query.next()){
+                /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
+                 *a segmentation fault when try to use the returned pointer.
+                 * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
+                 */
+                list.append(new Rfiddata(query.record(), parent));
+            }
         }
         return list;
 
@@ -347,30 +315,77 @@ QList<Rfiddata *> RfiddataDAO::getAll(QObject *parent)
  * \param ColumnObject refers to the name of some atribute from Rfiddata object.
  * \param value refers to the value of the \a ColumnObject will be restricted.
  * \param parent is the parent of whole returned list.
- * \return QList<Rfiddata *> list of objects found by the restrictive query.
+ * \return QList<Rfiddata *> list of objects found by the restrictive query, from the oldest to the newest partition.
  */
 QList<Rfiddata *> RfiddataDAO::getByMatch(const QString &ColumnObject, QVariant value, QObject *parent)
 {
     QList<Rfiddata *> list;
 
     // Get the connection with the database.
-    QSqlDatabase *db = ConnectionPool::instance()->systemConnection();
+    QSqlDatabase *db = database();
 
     try{
-        SqlQuery query(db);
-        /* Creates the "where" restriction with the column name from "ColumnObject" parameter.
-         * and the value of it with "value".
-         */
-        QString sqlQuery = QString("select id, idantena, idpontocoleta, applicationcode, identificationcode, datetime sync from rfiddata  where %1 = :value ").arg(ColumnObject);
-        query.prepare(sqlQuery);
-        query.bindValue(":value", value);
-        query.exec();
-        while(query.next()){
-            /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
-             *a segmentation fault when try to use the returned pointer.
-             * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
+        foreach (const QString &partition, m_partitions->names()) {
+            SqlQuery query(db);
+            /* Creates the "where" restriction with the column name from "ColumnObject" parameter.
+             * and the value of it with "value".
              */
-            list.append(new Rfiddata(query.record(), parent));
+            QString sqlQuery = QString("select id, idantena, idpontocoleta, applicationcode, identificationcode, timestamp, sync from %1 where %2 = :value ").arg(partition).arg(ColumnObject);
+            query.prepare(sqlQuery);
+            query.bindValue(":value", value);
+            query.exec();
+            while(query.next()){
+                /* If the parent is not set to the rfiddata object, it will be destroyed when this "getById" is done, causing
+                 *a segmentation fault when try to use the returned pointer.
+                 * Is necessary to give the rfiddata object to another class, so it must survive long as his parent.
+                 */
+                list.append(new Rfiddata(query.record(), parent));
+            }
+        }
+        return list;
+
+    }catch(SqlException &ex){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
+        return list;
+    }
+}
+
+/*!
+ * \brief RfiddataDAO::select Offers the way to select a list of Rfiddata objects with a SelectQuery, through cached statements.
+ * A BETWEEN on the timestamp reads only the partitions of the days in the range. The order and the limit are applied in each partition,
+ * which are read from the oldest to the newest (the newest first for a descending order), so an order by id or by timestamp holds for the whole list.
+ * \param selectQuery is the projection, the restrictions, the order and the limit.
+ * \param parent is the parent of whole returned list.
+ * \return QList<Rfiddata *> list of objects found, with only the selected columns filled.
+ */
+QList<Rfiddata *> RfiddataDAO::select(const SelectQuery<Rfiddata> &selectQuery, QObject *parent)
+{
+    QList<Rfiddata *> list;
+
+    // Get the connection with the database.
+    QSqlDatabase *db = database();
+
+    QStringList partitions;
+    QVariant from, to;
+    if(selectQuery.range(Rfiddata::columnName(Rfiddata::Column::KTimestamp), from, to))
+        partitions = m_partitions->namesBetween(Clock::toDateTime(from.toLongLong()).date(), Clock::toDateTime(to.toLongLong()).date());
+    else
+        partitions = m_partitions->names();
+    if(selectQuery.order() == QueryBuilder::Order::KDescending)
+        std::reverse(partitions.begin(), partitions.end());
+
+    int limit = selectQuery.limit();
+    try{
+        foreach (const QString &partition, partitions) {
+            SqlQuery query(db);
+            selectQuery.exec(query, db, partition);
+            while((limit < 0 || list.size() < limit) && query.next()){
+                list.append(new Rfiddata(query.record(), parent));
+            }
+            // Releases the cached statement
+            query.finish();
+            if(limit >= 0 && list.size() >= limit)
+                break;
         }
         return list;
 
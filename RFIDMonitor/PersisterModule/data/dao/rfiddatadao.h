@@ -10,8 +10,11 @@
 #include <QString>
 
 #include <core/genericdao.h>
+#include <core/sql/selectquery.h>
 
+class QSqlDatabase;
 class Rfiddata;
+class RfiddataPartitions;
 
 /*!
  * \brief The RfiddataDAO class is responsible to manipulate the persistence
@@ -23,6 +26,7 @@ class  RfiddataDAO : public GenericDAO<Rfiddata>
 
 public:
     RfiddataDAO(QObject *parent = 0);
+    ~RfiddataDAO();
 
     QString serviceNameInsertObject() const;
 
@@ -40,9 +44,13 @@ public:
     QList<Rfiddata *> getAll(QObject *parent=0);
 
     QList<Rfiddata *> getByMatch(const QString &columnName, QVariant value, QObject *parent=0);
+    QList<Rfiddata *> select(const SelectQuery<Rfiddata> &selectQuery, QObject *parent=0);
 
 private:
+    QSqlDatabase * database();
+
     QString m_module;
+    RfiddataPartitions *m_partitions;
 
 };
 
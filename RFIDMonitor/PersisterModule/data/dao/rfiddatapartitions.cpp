@@ -0,0 +1,390 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlRecord>
+#include <QVariant>
+
+#include <logger.h>
+#include <rfidmonitor.h>
+#include <object/rfiddata.h>
+#include <core/sql/sqlquery.h>
+#include <core/sql/statementcache.h>
+
+#include "rfiddatapartitions.h"
+
+namespace {
+
+const char *KColumns = "id, idantena, idpontocoleta, applicationcode, identificationcode, timestamp, sync";
+
+/*
+ * The same columns read from a table of an older version, where the time is the local ISO 8601 text written by Qt ("2014-03-20T10:15:42.123").
+ * SQLite converts it to UTC; a text that can't be parsed becomes zero instead of failing the whole migration.
+ */
+const char *KLegacyColumns = "id, idantena, idpontocoleta, applicationcode, identificationcode, "
+                             "coalesce(cast(strftime('%s', datetime, 'utc') as integer) * 1000000 + cast(substr(strftime('%f', datetime), 4) as integer) * 1000, 0), "
+                             "sync";
+
+}
+
+RfiddataPartitions::RfiddataPartitions(const QString &module) :
+    m_module(module)
+{
+}
+
+void RfiddataPartitions::init(QSqlDatabase *db)
+{
+    SqlQuery query(db);
+
+    // Incremental auto_vacuum can be enabled on an existing database only by rebuilding it once
+    query.exec("PRAGMA auto_vacuum");
+    if(query.next() && query.value(0).toInt() != 2){
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, "Enabling incremental auto_vacuum");
+        query.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        query.exec("VACUUM");
+    }
+
+    query.exec(QString("CREATE TABLE IF NOT EXISTS `rfiddata_partition` (\n") +
+               QString("  `day` INT(8) NOT NULL ,\n") +
+               QString("  `minid` BIGINT(12) NOT NULL ,\n") +
+               QString("  `maxid` BIGINT(12) NOT NULL ,\n") +
+               QString("  PRIMARY KEY (`day`) );\n"));
+
+    reload(db);
+
+    db->transaction();
+    try{
+        migrateTimestamps(db);
+        migrateLegacyTable(db);
+        saveRanges(db);
+        db->commit();
+    }catch(SqlException &ex){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Migration Error: %1").arg(ex.errorText()));
+        db->rollback();
+        reload(db);
+    }
+
+    maintenance(db);
+}
+
+void RfiddataPartitions::reload(QSqlDatabase *db)
+{
+    m_partitions.clear();
+
+    SqlQuery query(db);
+    query.exec("select day, minid, maxid from rfiddata_partition order by day");
+    while(query.next()){
+        int day = query.value(0).toInt();
+        Partition partition;
+        partition.name = QString("rfiddata_%1").arg(day);
+        partition.minId = query.value(1).toLongLong();
+        partition.maxId = query.value(2).toLongLong();
+        partition.changed = false;
+        m_partitions.insert(day, partition);
+    }
+}
+
+QString RfiddataPartitions::partitionFor(const QDateTime &dateTime, QSqlDatabase *db)
+{
+    int day = dayKey(dateTime.date());
+    if(!m_partitions.contains(day))
+        createPartition(day, db);
+    return m_partitions.value(day).name;
+}
+
+void RfiddataPartitions::addId(const QString &partition, qlonglong id)
+{
+    int day = partition.mid(9).toInt();
+    if(!m_partitions.contains(day))
+        return;
+
+    Partition &p = m_partitions[day];
+    if(p.minId < 0 || id < p.minId)
+        p.minId = id;
+    if(id > p.maxId)
+        p.maxId = id;
+    p.changed = true;
+}
+
+void RfiddataPartitions::saveRanges(QSqlDatabase *db)
+{
+    QMap<int, Partition>::iterator it;
+    for(it = m_partitions.begin(); it != m_partitions.end(); ++it){
+        if(!it.value().changed)
+            continue;
+        SqlQuery query(db);
+        query.prepare("update rfiddata_partition set minid = :minid, maxid = :maxid where day = :day");
+        query.bindValue(":minid", it.value().minId);
+        query.bindValue(":maxid", it.value().maxId);
+        query.bindValue(":day", it.key());
+        query.exec();
+        it.value().changed = false;
+    }
+}
+
+QStringList RfiddataPartitions::partitionsOf(qlonglong id) const
+{
+    QStringList list;
+    foreach (const Partition &partition, m_partitions) {
+        if(partition.minId >= 0 && id >= partition.minId && id <= partition.maxId)
+            list.append(partition.name);
+    }
+    return list;
+}
+
+QStringList RfiddataPartitions::names() const
+{
+    QStringList list;
+    foreach (const Partition &partition, m_partitions) {
+        list.append(partition.name);
+    }
+    return list;
+}
+
+QStringList RfiddataPartitions::namesBetween(const QDate &from, const QDate &to) const
+{
+    QStringList list;
+    QMap<int, Partition>::const_iterator it = m_partitions.lowerBound(dayKey(from));
+    for(; it != m_partitions.constEnd() && it.key() <= dayKey(to); ++it){
+        list.append(it.value().name);
+    }
+    return list;
+}
+
+bool RfiddataPartitions::exportPartition(const QDate &date, const QString &fileName, QSqlDatabase *db)
+{
+    int day = dayKey(date);
+    if(!m_partitions.contains(day) || QFile::exists(fileName))
+        return false;
+
+    SqlQuery query(db);
+    query.prepare("ATTACH DATABASE :file AS partition_export");
+    query.bindValue(":file", fileName);
+    query.exec();
+    try{
+        query.exec(QString("CREATE TABLE partition_export.rfiddata AS SELECT * FROM `%1`").arg(m_partitions.value(day).name));
+    }catch(SqlException &ex){
+        query.exec("DETACH DATABASE partition_export");
+        QFile::remove(fileName);
+        throw;
+    }
+    query.exec("DETACH DATABASE partition_export");
+    return true;
+}
+
+void RfiddataPartitions::maintenance(QSqlDatabase *db)
+{
+    QDate today = QDate::currentDate();
+    int todayKey = dayKey(today);
+    int retentionDays = RFIDMonitor::instance()->retentionDays();
+    int retentionKey = retentionDays > 0 ? dayKey(today.addDays(-retentionDays)) : 0;
+    QString archive(RFIDMonitor::instance()->retentionArchive());
+
+    bool dropped = false;
+    try{
+        foreach (int day, m_partitions.keys()) {
+            if(day == todayKey)
+                continue;
+
+            SqlQuery query(db);
+            query.exec(QString("select count(*), sum(sync = %1) from %2").arg(Rfiddata::KNotSynced).arg(m_partitions.value(day).name));
+            query.next();
+            int count = query.value(0).toInt();
+            int notSynced = query.value(1).toInt();
+            query.finish();
+
+            if(count == 0){
+                dropPartition(day, db);
+                dropped = true;
+            }else if(day < retentionKey){
+                // The retention never discards readings the server has not received
+                if(notSynced == 0){
+                    if(!archive.isEmpty()){
+                        QString fileName(QString("%1/%2.db").arg(archive).arg(m_partitions.value(day).name));
+                        if(!QDir().mkpath(archive) || !exportPartition(QDate::fromString(QString::number(day), "yyyyMMdd"), fileName, db)){
+                            Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Partition %1 not exported to %2, kept").arg(day).arg(fileName));
+                            continue;
+                        }
+                    }
+                    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("Partition %1 is older than %2 days, dropping %3 readings").arg(day).arg(retentionDays).arg(count));
+                    dropPartition(day, db);
+                    dropped = true;
+                }else{
+                    Logger::instance()->writeRecord(Logger::severity_level::warning, m_module, Q_FUNC_INFO, QString("Partition %1 is older than %2 days but has %3 readings not synchronized").arg(day).arg(retentionDays).arg(notSynced));
+                }
+            }
+        }
+
+        if(dropped){
+            SqlQuery vacuum(db);
+            vacuum.exec("PRAGMA incremental_vacuum");
+            while(vacuum.next());
+        }
+    }catch(SqlException &ex){
+        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Maintenance Error: %1").arg(ex.errorText()));
+    }
+    m_lastMaintenance = today;
+}
+
+bool RfiddataPartitions::isMaintenancePending() const
+{
+    return m_lastMaintenance != QDate::currentDate();
+}
+
+int RfiddataPartitions::dayKey(const QDate &date)
+{
+    return date.year() * 10000 + date.month() * 100 + date.day();
+}
+
+void RfiddataPartitions::createTable(const QString &name, QSqlDatabase *db)
+{
+    SqlQuery query(db);
+    query.exec(QString(QString("CREATE TABLE IF NOT EXISTS `%1` (\n") +
+                       QString("  `id` INT(16) NOT NULL,\n") +
+                       QString("  `idantena` int(16) NOT NULL,\n") +
+                       QString("  `idpontocoleta` int(16) NOT NULL,\n") +
+                       QString("  `applicationcode` int(16) NOT NULL,\n") +
+                       QString("  `identificationcode` int(16) NOT NULL,\n") +
+                       QString("  `timestamp` INTEGER NOT NULL,\n") +
+                       QString("  `sync` int(2) NOT NULL,\n") +
+                       QString("  PRIMARY KEY (`id`) );\n")).arg(name));
+    // The packager looks for the readings not synchronized
+    query.exec(QString("CREATE INDEX IF NOT EXISTS `%1_sync` ON `%1` (`sync`)").arg(name));
+    // Range queries by time
+    query.exec(QString("CREATE INDEX IF NOT EXISTS `%1_timestamp` ON `%1` (`timestamp`)").arg(name));
+}
+
+void RfiddataPartitions::createPartition(int day, QSqlDatabase *db)
+{
+    QString name = QString("rfiddata_%1").arg(day);
+    createTable(name, db);
+
+    SqlQuery query(db);
+    query.prepare("insert into rfiddata_partition (day, minid, maxid) values(:day, -1, -1)");
+    query.bindValue(":day", day);
+    query.exec();
+
+    Partition partition;
+    partition.name = name;
+    partition.minId = -1;
+    partition.maxId = -1;
+    partition.changed = false;
+    m_partitions.insert(day, partition);
+}
+
+void RfiddataPartitions::dropPartition(int day, QSqlDatabase *db)
+{
+    // The cached statements of the partition would fail from now on
+    StatementCache::instance()->clear(db);
+
+    SqlQuery query(db);
+    query.exec(QString("DROP TABLE IF EXISTS `%1`").arg(m_partitions.value(day).name));
+    query.prepare("delete from rfiddata_partition where day = :day");
+    query.bindValue(":day", day);
+    query.exec();
+    m_partitions.remove(day);
+}
+
+void RfiddataPartitions::migrateLegacyTable(QSqlDatabase *db)
+{
+    SqlQuery query(db);
+    query.exec("select distinct substr(datetime, 1, 10) from rfiddata");
+    QStringList days;
+    while(query.next()){
+        days.append(query.value(0).toString());
+    }
+    query.finish();
+    if(days.isEmpty())
+        return;
+
+    int moved = 0;
+    foreach (const QString &day, days) {
+        QDate date = QDate::fromString(day, "yyyy-MM-dd");
+        if(!date.isValid())
+            continue;
+        QString partition = partitionFor(QDateTime(date), db);
+
+        SqlQuery copy(db);
+        copy.prepare(QString("insert into %1 (%2) select %3 from rfiddata where substr(datetime, 1, 10) = :day").arg(partition).arg(KColumns).arg(KLegacyColumns));
+        copy.bindValue(":day", day);
+        copy.exec();
+        moved += copy.numRowsAffected();
+
+        SqlQuery remove(db);
+        remove.prepare("delete from rfiddata where substr(datetime, 1, 10) = :day");
+        remove.bindValue(":day", day);
+        remove.exec();
+    }
+
+    // Rows with a date that can't be parsed are kept in the partition of today
+    QString partition = partitionFor(QDateTime::currentDateTime(), db);
+    SqlQuery copy(db);
+    copy.exec(QString("insert into %1 (%2) select %3 from rfiddata").arg(partition).arg(KColumns).arg(KLegacyColumns));
+    moved += copy.numRowsAffected();
+    query.exec("delete from rfiddata");
+
+    foreach (const QString &name, names()) {
+        SqlQuery range(db);
+        range.exec(QString("select min(id), max(id) from %1").arg(name));
+        if(range.next() && !range.isNull(0)){
+            addId(name, range.value(0).toLongLong());
+            addId(name, range.value(1).toLongLong());
+        }
+    }
+
+    Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("%1 readings moved to the day partitions").arg(moved));
+}
+
+void RfiddataPartitions::migrateTimestamps(QSqlDatabase *db)
+{
+    int converted = 0;
+    foreach (const QString &name, names()) {
+        bool legacy = false;
+        SqlQuery columns(db);
+        columns.exec(QString("PRAGMA table_info(`%1`)").arg(name));
+        while(columns.next()){
+            if(columns.value(1).toString() == "datetime")
+                legacy = true;
+        }
+        if(!legacy)
+            continue;
+
+        // SQLite can't change the type of a column, the partition is rebuilt
+        SqlQuery query(db);
+        query.exec(QString("ALTER TABLE `%1` RENAME TO `%1_legacy`").arg(name));
+        query.exec(QString("DROP INDEX IF EXISTS `%1_sync`").arg(name));
+        createTable(name, db);
+        query.exec(QString("insert into %1 (%2) select %3 from %1_legacy").arg(name).arg(KColumns).arg(KLegacyColumns));
+        query.exec(QString("DROP TABLE `%1_legacy`").arg(name));
+        converted++;
+    }
+    if(converted > 0)
+        Logger::instance()->writeRecord(Logger::severity_level::info, m_module, Q_FUNC_INFO, QString("%1 partitions converted to integer timestamps").arg(converted));
+}
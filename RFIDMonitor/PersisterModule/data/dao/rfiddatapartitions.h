@@ -0,0 +1,132 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef RFIDDATAPARTITIONS_H
+#define RFIDDATAPARTITIONS_H
+
+#include <QDate>
+#include <QMap>
+#include <QStringList>
+
+class QSqlDatabase;
+
+/*!
+ * \brief The RfiddataPartitions class splits the readings in one table per day (rfiddata_yyyyMMdd).
+ *
+ * The partitions are listed in the catalog table rfiddata_partition with the range of ids of each one, so an object can be found by its id.
+ * Inserts always go to the small table of the day, and the readings are removed a whole partition at a time: a partition that becomes empty,
+ * or that is older than the retention period, is dropped. The database uses incremental auto_vacuum, so the file shrinks after each drop.
+ * The time of a reading is an INTEGER column (`timestamp`, microseconds since the epoch, see Clock) with an index for range queries.
+ *
+ * Functions that touch the database throw SqlException.
+ */
+class RfiddataPartitions
+{
+public:
+    explicit RfiddataPartitions(const QString &module);
+
+    /*!
+     * \brief init loads the catalog, converts the partitions with a text datetime column, moves the rows of the old single rfiddata table
+     * to the partitions and runs the maintenance.
+     * Must be called outside of a transaction.
+     */
+    void init(QSqlDatabase *db);
+
+    /*!
+     * \brief reload reads the catalog again, used after a rollback.
+     */
+    void reload(QSqlDatabase *db);
+
+    /*!
+     * \brief partitionFor returns the name of the partition of \a dateTime, creating it when needed.
+     */
+    QString partitionFor(const QDateTime &dateTime, QSqlDatabase *db);
+
+    /*!
+     * \brief addId extends the range of ids of the partition. The range is saved by saveRanges().
+     */
+    void addId(const QString &partition, qlonglong id);
+    void saveRanges(QSqlDatabase *db);
+
+    /*!
+     * \brief partitionsOf returns the partitions whose range of ids contains \a id (more than one only if the clock of the system went back).
+     */
+    QStringList partitionsOf(qlonglong id) const;
+
+    /*!
+     * \brief names returns all partitions, from the oldest to the newest.
+     */
+    QStringList names() const;
+
+    /*!
+     * \brief namesBetween returns the partitions of the days from \a from to \a to, from the oldest to the newest.
+     */
+    QStringList namesBetween(const QDate &from, const QDate &to) const;
+
+    /*!
+     * \brief exportPartition copies the whole partition of \a date to a new SQLite database \a fileName, as its rfiddata table.
+     * The rows are copied by one statement in the database, without going through Rfiddata objects.
+     * Must be called outside of a transaction.
+     * \return false if there is no such partition or the file exists already.
+     */
+    bool exportPartition(const QDate &date, const QString &fileName, QSqlDatabase *db);
+
+    /*!
+     * \brief maintenance drops the empty partitions (except the one of today) and the partitions older than the retention period.
+     * When the retention archive is set, an old partition is exported there first, and kept if the export fails.
+     * Must be called outside of a transaction.
+     */
+    void maintenance(QSqlDatabase *db);
+
+    /*!
+     * \brief isMaintenancePending is true when a new day started since the last maintenance.
+     */
+    bool isMaintenancePending() const;
+
+private:
+    struct Partition
+    {
+        QString name;
+        qlonglong minId;
+        qlonglong maxId;
+        bool changed;
+    };
+
+    static int dayKey(const QDate &date);
+    void createTable(const QString &name, QSqlDatabase *db);
+    void createPartition(int day, QSqlDatabase *db);
+    void dropPartition(int day, QSqlDatabase *db);
+    void migrateLegacyTable(QSqlDatabase *db);
+    void migrateTimestamps(QSqlDatabase *db);
+
+    QString m_module;
+    QMap<int, Partition> m_partitions;
+    QDate m_lastMaintenance;
+};
+
+#endif // RFIDDATAPARTITIONS_H
@@ -40,12 +40,19 @@ QList<Rfiddata *> PersistenceService::getObjectList(const QString &ColumnObject,
     return RfiddataDAO::instance()->getByMatch(ColumnObject, value, parent);
 }
 
-void PersistenceService::insertObjectList(const QList<Rfiddata *> &data)
+QList<Rfiddata *> PersistenceService::select(const SelectQuery<Rfiddata> &query, QObject *parent)
+{
+    QMutexLocker locker(&m_mutex);
+
+    return RfiddataDAO::instance()->select(query, parent);
+}
+
+bool PersistenceService::insertObjectList(const QList<Rfiddata *> &data)
 {
     QMutexLocker locker(&m_mutex);
 //    qDebug() << "\nINSERT OBJECT LIST - 1";
 
-    RfiddataDAO::instance()->insertObjectList(data);
+    return RfiddataDAO::instance()->insertObjectList(data);
 }
 
 void PersistenceService::updateObjectList(const QList<Rfiddata *> &data)
@@ -16,7 +16,8 @@ public:
     void init();
     ServiceType type();
     QList<Rfiddata *> getObjectList(const QString &ColumnObject, QVariant value, QObject *parent);
-    void insertObjectList(const QList<Rfiddata *> &data);
+    QList<Rfiddata *> select(const SelectQuery<Rfiddata> &query, QObject *parent);
+    bool insertObjectList(const QList<Rfiddata *> &data);
     void updateObjectList(const QList<Rfiddata *> &data);
     void deleteObjectList(const QList<Rfiddata *> &data);
 
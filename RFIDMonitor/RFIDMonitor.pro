@@ -2,10 +2,14 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     CoreLibrary \
+    CoreLibrary/soaktest \
     ReaderRFM008BModule \
     ReaderMRI2000Module \
     PersisterModule \
+    SegmentPersisterModule \
+    SegmentPersisterModule/benchmark \
     ExporterModule \
+    ExporterModule/gpiotest \
     Main \
     CommunicatorModule \
     SynchronizerModule
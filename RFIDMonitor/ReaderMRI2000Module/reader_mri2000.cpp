@@ -37,7 +37,6 @@
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
-#include <QtConcurrent/QtConcurrent>
 
 #include <iostream>
 #include <ctime>
@@ -46,20 +45,27 @@
 
 #include <logger.h>
 #include <rfidmonitor.h>
+#include <core/ingestjournal.h>
+#include <core/clock.h>
+#include <core/executor.h>
+#include <core/serialconnection.h>
 #include <object/rfiddata.h>
+#include <object/rfiddatapool.h>
 
 #include <json/nodejsmessage.h>
 #include <json/synchronizationpacket.h>
 
 Reader_MRI2000::Reader_MRI2000(QObject *parent) :
     ReadingInterface(parent),
+    m_connection(0),
     m_serial(0)
 {
     m_module = "ReadingModule_MRI2000";
-    m_serial = new QSerialPort(this);
+    // The connection opens the port, and reopens it after a USB reset or unplug
+    m_connection = new SerialConnection(m_module, this);
+    m_serial = m_connection->port();
 
-    connect(m_serial, SIGNAL(readyRead()), SLOT(readData()));
-    connect(m_serial, SIGNAL(error(QSerialPort::SerialPortError)), SLOT(handleError(QSerialPort::SerialPortError)));
+    connect(m_connection, SIGNAL(readyRead()), SLOT(readData()));
 
     allLines = false;
     idCollector = 0;
@@ -69,9 +75,7 @@ Reader_MRI2000::Reader_MRI2000(QObject *parent) :
 
 Reader_MRI2000::~Reader_MRI2000()
 {
-    if (m_serial->isOpen()) {
-        m_serial->close();
-    }
+    m_connection->close();
 }
 
 QString Reader_MRI2000::serviceName() const
@@ -89,6 +93,11 @@ ServiceType Reader_MRI2000::type()
     return ServiceType::KReader;
 }
 
+ReadingInterface *Reader_MRI2000::createInstance(QObject *parent)
+{
+    return new Reader_MRI2000(parent);
+}
+
 void Reader_MRI2000::fullRead(bool fr)
 {
     allLines = fr;
@@ -119,6 +128,9 @@ void Reader_MRI2000::readData()
        TAG2W 001 0000000002A474C9
      */
     if(m_serial->canReadLine()){
+        // The time of the reading is taken as soon as the frame arrives, before the parsing
+        qint64 arrival = Clock::now();
+        m_connection->frameReceived();
         if(!allLines){
 
             QString hardData(m_serial->readLine());
@@ -131,13 +143,14 @@ void Reader_MRI2000::readData()
             if(match.hasMatch()) {
 
                 //Here the matched string must be like "TAG5W 001 0000000295901506"
-                Rfiddata *data = new Rfiddata(this);
+                // The object is given back to the pool by the journal, after the commit
+                Rfiddata *data = RfiddataPool::instance()->acquire();
 
                 // Id collector from configuration file
                 data->setIdpontocoleta(idCollector);
 
                 //The character 3 from string is the number of antenna: TAG[5]W...
-                data->setIdantena(match.captured(0).at(3).digitValue());
+                data->setIdantena(match.captured(0).at(3).digitValue() + antennaOffset());
 
 
 
@@ -149,6 +162,7 @@ void Reader_MRI2000::readData()
                 if(!hexaConvertion){
                     //Problem converting from hexadecimal.
                     Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Could not convert RFID code from hexadecimal. Hexa code: %1").arg(hexaCode));
+                    RfiddataPool::instance()->release(data);
                     return;
                 }
 
@@ -179,35 +193,14 @@ void Reader_MRI2000::readData()
                 data->setApplicationcode(applicationcode);
                 //From the full code, removing the application code, there is the identification code
                 data->setIdentificationcode(identificationcode);
-                //Take the current date and set on the object
-                data->setDatetime(QDateTime::currentDateTime());
+                //Time of arrival of the frame
+                data->setTimestamp(arrival);
                 //Set the object as NotSynced
                 data->setSync(Rfiddata::KNotSynced);
 
-                QList<Rfiddata*> list;
-                list.append(data);
-
-                try {
-                    PersistenceInterface *persister = qobject_cast<PersistenceInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KPersister));
-                    Q_ASSERT(persister);
-
-                    SynchronizationInterface *synchronizer = qobject_cast<SynchronizationInterface*>(RFIDMonitor::instance()->defaultService(ServiceType::KSynchronizer));
-                    Q_ASSERT(synchronizer);
-
-#ifdef CPP_11_ASYNC
-                    /*C++11 std::async Version*/
-                    std::function<void(const QList<Rfiddata *>&)> persistence = std::bind(&PersistenceInterface::insertObjectList, persister, std::placeholders::_1);
-                    std::async(std::launch::async, persistence, list);
-                    std::function<void()> synchronize = std::bind(&SynchronizationInterface::readyRead, synchronizer);
-                    std::async(std::launch::async, synchronize);
-#else
-                    /*Qt Concurrent Version*/
-                    QtConcurrent::run(persister, &PersistenceInterface::insertObjectList, list);
-                    QtConcurrent::run(synchronizer, &SynchronizationInterface::readyRead);
-#endif
-                } catch (std::exception &e) {
-                    Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("QtConcurrent ERROR"));
-                }
+                // The reading is journaled first, then committed to the persistence service in batches
+                IngestJournal::instance()->append(data);
+                countReading();
 
 //                                } // END OF if(!m_map.contains(identificationcode)){
 
@@ -232,65 +225,44 @@ void Reader_MRI2000::readData()
             QJsonObject dataObj;
             dataObj.insert("sender", QString("app"));
             dataObj.insert("response", data);
-            dataObj.insert("reader", QString(""));
+            // With several readers the server tells which device answered by its name
+            dataObj.insert("reader", readerName());
 
             answer.setDateTime(QDateTime::currentDateTime());
             answer.setJsonData(dataObj);
             QJsonObject jsonAnswer;
             answer.write(jsonAnswer);
 
-            try {
-                static CommunicationInterface *communitacion = 0;
-
-                communitacion = qobject_cast<CommunicationInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KCommunicator));
-#ifdef CPP_11_ASYNC
-                /*C++11 std::async Version*/
-                std::function<void (QByteArray)> sendMessage = std::bind(&CommunicationInterface::sendMessage, communitacion, std::placeholders::_1);
-                std::async(std::launch::async, sendMessage, QJsonDocument(jsonAnswer).toJson());
-#else
-                /*Qt Concurrent Version*/
-                QtConcurrent::run(communitacion, &CommunicationInterface::sendMessage, QJsonDocument(jsonAnswer).toJson());
-#endif
-            } catch (std::exception &e) {
-                Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("QtConcurrent ERROR"));
-            }
+            CommunicationInterface *communitacion = RFIDMonitor::instance()->defaultService<CommunicationInterface>();
+            QByteArray message = QJsonDocument(jsonAnswer).toJson();
+            // A full "comm" queue drops the oldest live message, the reader never waits for the daemon
+            Executor::instance()->submit("comm", [communitacion, message](){ communitacion->sendMessage(message); });
         }
     }
 }
 
-void Reader_MRI2000::handleError(QSerialPort::SerialPortError error)
+bool Reader_MRI2000::isValidFrame(const QByteArray &line)
 {
-    if (error != QSerialPort::NoError)
-    {
-        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error: %1").arg(m_serial->errorString()));
-    }
+    static const QRegularExpression frame("TAG[0-9a-fA-F]W\\s[0-9a-fA-F]{3}\\s[0-9a-fA-F]{16}");
+    return frame.match(QString::fromLatin1(line)).hasMatch();
 }
 
 void Reader_MRI2000::start()
 {
 
-    QString device = RFIDMonitor::instance()->device();
+    // Set by RFIDMonitor from the "readers" list of the configuration, or from "device" when there is a single reader
+    QString device = this->device();
     Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("MRI2000 Using device: %1").arg(device));
 
     idCollector = RFIDMonitor::instance()->idCollector();
 
-    QSerialPortInfo info(device);
-    m_serial->setPort(info);
-    if(!m_serial->open(QIODevice::ReadWrite)) {
-
-        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Could not open device %1 - Error %2").arg(device).arg(m_serial->errorString()));
-        // create class invalid_device exception on core Module
-        QTimer::singleShot(1000, this, SLOT(start()));
-    }else{
-        m_serial->setBaudRate(QSerialPort::Baud9600);
-        m_serial->setDataBits(QSerialPort::Data8);
-        m_serial->setStopBits(QSerialPort::OneStop);
-        m_serial->setParity(QSerialPort::NoParity);
-    }
+    // Line settings of the reader: baud rate (or detection), parity, low latency mode
+    m_connection->setLineSettings(settings());
+    m_connection->setFrameValidator(&Reader_MRI2000::isValidFrame);
+    m_connection->open(device);
 }
 
 void Reader_MRI2000::stop()
 {
-    disconnect(m_serial, SIGNAL(readyRead()),this, SLOT(readData()));
-    disconnect(m_serial, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(handleError(QSerialPort::SerialPortError)));
+    m_connection->close();
 }
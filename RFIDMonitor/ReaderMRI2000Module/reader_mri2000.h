@@ -39,6 +39,7 @@
 
 class Rfiddata;
 class DeviceThread;
+class SerialConnection;
 
 class Reader_MRI2000 : public ReadingInterface
 {
@@ -51,6 +52,7 @@ public:
     QString serviceName() const;
     void init();
     ServiceType type();
+    ReadingInterface * createInstance(QObject *parent = 0);
 
     void fullRead(bool fr);
     void write(QString command);
@@ -59,12 +61,17 @@ private:
     int idCollector;
     bool allLines;
     QString m_module;
+    SerialConnection *m_connection;
     QSerialPort *m_serial;
+
+    /*!
+     * \brief isValidFrame recognizes a tag frame, used to detect the baud rate.
+     */
+    static bool isValidFrame(const QByteArray &line);
     QMap<qlonglong, QTimer*> m_map;
 
 public slots:
     void readData();
-    void handleError(QSerialPort::SerialPortError error);
 
     void start();
     void stop();
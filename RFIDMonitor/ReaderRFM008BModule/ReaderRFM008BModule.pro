@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core sql serialport concurrent
+QT       += core sql serialport
 
 TARGET = ReaderRFM008B
 TEMPLATE = lib
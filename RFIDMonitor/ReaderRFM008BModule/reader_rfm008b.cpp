@@ -37,18 +37,20 @@
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
-#include <QtConcurrent/QtConcurrent>
 
 #include <iostream>
 #include <ctime>
-#include <future>
-#include <functional>
 
 #include "reader_rfm008b.h"
 
 #include <logger.h>
 #include <object/rfiddata.h>
+#include <object/rfiddatapool.h>
 #include <rfidmonitor.h>
+#include <core/ingestjournal.h>
+#include <core/clock.h>
+#include <core/executor.h>
+#include <core/serialconnection.h>
 
 
 #include <json/nodejsmessage.h>
@@ -60,10 +62,15 @@ QFile fileCaptured(QCoreApplication::applicationDirPath() + "/rfidmonitor_captur
 
 Reader_RFM008B::Reader_RFM008B(QObject *parent) :
     ReadingInterface(parent),
+    m_connection(0),
     m_serial(0)
 {
     m_module = "ReadingModule";
-    m_serial = new QSerialPort(this);
+    // The connection opens the port, and reopens it after a USB reset or unplug
+    m_connection = new SerialConnection(m_module, this);
+    m_serial = m_connection->port();
+
+    connect(m_connection, SIGNAL(readyRead()), SLOT(readData()));
 
     allLines = false;
     idCollector = 0;
@@ -78,9 +85,7 @@ Reader_RFM008B::Reader_RFM008B(QObject *parent) :
 
 Reader_RFM008B::~Reader_RFM008B()
 {
-    if (m_serial->isOpen()) {
-        m_serial->close();
-    }
+    m_connection->close();
 }
 
 QString Reader_RFM008B::serviceName() const
@@ -98,6 +103,11 @@ ServiceType Reader_RFM008B::type()
     return ServiceType::KReader;
 }
 
+ReadingInterface *Reader_RFM008B::createInstance(QObject *parent)
+{
+    return new Reader_RFM008B(parent);
+}
+
 void Reader_RFM008B::fullRead(bool fr)
 {
     allLines = fr;
@@ -114,6 +124,9 @@ void Reader_RFM008B::write(QString command)
 void Reader_RFM008B::readData()
 {
     if(m_serial->canReadLine()){
+        // The time of the reading is taken as soon as the frame arrives, before the parsing
+        qint64 arrival = Clock::now();
+        m_connection->frameReceived();
         if(!allLines){
 
 //            Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Reading Data..."));
@@ -149,14 +162,15 @@ void Reader_RFM008B::readData()
                 }
 
                 if(match.hasMatch()) {
-                    Rfiddata *data = new Rfiddata(this);
+                    // The object is given back to the pool by the journal, after the commit
+                    Rfiddata *data = RfiddataPool::instance()->acquire();
 
                     // Id collector from configuration file
                     data->setIdpontocoleta(idCollector);
 
                     // This module can read from only one antena, so the idAntena is static.
                     int idAntena = 1;
-                    data->setIdantena(idAntena);
+                    data->setIdantena(idAntena + antennaOffset());
 
                     qlonglong applicationcode = match.captured(1).toLongLong();
                     qlonglong identificationcode = match.captured(3).toLongLong();
@@ -181,31 +195,15 @@ void Reader_RFM008B::readData()
 
                         data->setApplicationcode(applicationcode);
                         data->setIdentificationcode(identificationcode);
-                        data->setDatetime(QDateTime::currentDateTime());
+                        data->setTimestamp(arrival);
                         data->setSync(Rfiddata::KNotSynced);
 
-                        QList<Rfiddata*> list;
-                        list.append(data);
-                        try {
-                            PersistenceInterface *persister = qobject_cast<PersistenceInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KPersister));
-                            Q_ASSERT(persister);
-                            SynchronizationInterface *synchronizer = qobject_cast<SynchronizationInterface*>(RFIDMonitor::instance()->defaultService(ServiceType::KSynchronizer));
-                            Q_ASSERT(synchronizer);
-
-#ifdef CPP_11_ASYNC
-                            /*C++11 std::async Version*/
-                            std::function<void(const QList<Rfiddata *>&)> persistence = std::bind(&PersistenceInterface::insertObjectList, persister, std::placeholders::_1);
-                            std::async(std::launch::async, persistence, list);
-                            std::function<void()> synchronize = std::bind(&SynchronizationInterface::readyRead, synchronizer);
-                            std::async(std::launch::async, synchronize);
-#else
-                            /*Qt Concurrent Version*/
-                            QtConcurrent::run(persister, &PersistenceInterface::insertObjectList, list);
-                            QtConcurrent::run(synchronizer, &SynchronizationInterface::readyRead);
-#endif
-                        } catch (std::exception &e) {
-                            Logger::instance()->writeRecord(Logger::severity_level::fatal, m_module, Q_FUNC_INFO, e.what());
-                        }
+                        // The reading is journaled first, then committed to the persistence service in batches
+                        IngestJournal::instance()->append(data);
+                        countReading();
+                    }else{
+                        // Filtered reading, it never reaches the journal
+                        RfiddataPool::instance()->release(data);
                     }
                 }
             }
@@ -227,7 +225,8 @@ void Reader_RFM008B::readData()
             QJsonObject dataObj;
             dataObj.insert("sender", QString("app"));
             dataObj.insert("response", data);
-            dataObj.insert("reader", QString("1"));
+            // With several readers the server tells which device answered by its name
+            dataObj.insert("reader", readerName());
 
             answer.setDateTime(QDateTime::currentDateTime());
             answer.setJsonData(dataObj);
@@ -235,51 +234,32 @@ void Reader_RFM008B::readData()
             answer.write(jsonAnswer);
 
 
-            static CommunicationInterface *communitacion = 0;
-            communitacion = qobject_cast<CommunicationInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KCommunicator));
-
-#ifdef CPP_11_ASYNC
-            /*C++11 std::async Version*/
-            std::function<void (QByteArray)> sendMessage = std::bind(&CommunicationInterface::sendMessage, communitacion, std::placeholders::_1);
-            std::async(std::launch::async, sendMessage, QJsonDocument(jsonAnswer).toJson());
-#else
-            /*Qt Concurrent Version*/
-            QtConcurrent::run(communitacion, &CommunicationInterface::sendMessage, QJsonDocument(jsonAnswer).toJson());
-#endif
+            CommunicationInterface *communitacion = RFIDMonitor::instance()->defaultService<CommunicationInterface>();
+            QByteArray message = QJsonDocument(jsonAnswer).toJson();
+            // A full "comm" queue drops the oldest live message, the reader never waits for the daemon
+            Executor::instance()->submit("comm", [communitacion, message](){ communitacion->sendMessage(message); });
         }
     }
 }
 
-void Reader_RFM008B::handleError(QSerialPort::SerialPortError error)
+bool Reader_RFM008B::isValidFrame(const QByteArray &line)
 {
-    if (error != QSerialPort::NoError) {
-        Logger::instance()->writeRecord(Logger::severity_level::error, m_module, Q_FUNC_INFO, QString("Error: %1").arg(m_serial->errorString()));
-    }
+    static const QRegularExpression frame("L(\\d{2})?W\\s[0-9a-fA-F]{4}\\s[0-9a-fA-F]{16}");
+    return frame.match(QString::fromLatin1(line)).hasMatch();
 }
 
 void Reader_RFM008B::start()
 {
-    QString device = RFIDMonitor::instance()->device();
+    // Set by RFIDMonitor from the "readers" list of the configuration, or from "device" when there is a single reader
+    QString device = this->device();
     idCollector = RFIDMonitor::instance()->idCollector();
-    QSerialPortInfo info(device);
-    m_serial->setPort(info);
-    if(!m_serial->open(QIODevice::ReadWrite)) {
-
-        Logger::instance()->writeRecord(Logger::severity_level::debug, m_module, Q_FUNC_INFO, QString("Could not open device %1 - Error %2").arg(device).arg(m_serial->errorString()));
-        // create class invalid_device exception on core Module
-        QTimer::singleShot(1000, this, SLOT(start()));
-    }else{
-        m_serial->setBaudRate(QSerialPort::Baud9600);
-        m_serial->setDataBits(QSerialPort::Data8);
-        m_serial->setStopBits(QSerialPort::OneStop);
-        m_serial->setParity(QSerialPort::NoParity);
-        connect(m_serial, SIGNAL(readyRead()), SLOT(readData()));
-        connect(m_serial, SIGNAL(error(QSerialPort::SerialPortError)), SLOT(handleError(QSerialPort::SerialPortError)));
-    }
+    // Line settings of the reader: baud rate (or detection), parity, low latency mode
+    m_connection->setLineSettings(settings());
+    m_connection->setFrameValidator(&Reader_RFM008B::isValidFrame);
+    m_connection->open(device);
 }
 
 void Reader_RFM008B::stop()
 {
-    disconnect(m_serial, SIGNAL(readyRead()),this, SLOT(readData()));
-    disconnect(m_serial, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(handleError(QSerialPort::SerialPortError)));
+    m_connection->close();
 }
@@ -39,6 +39,7 @@
 
 class Rfiddata;
 class DeviceThread;
+class SerialConnection;
 class QTextStream;
 
 class Reader_RFM008B : public ReadingInterface
@@ -52,6 +53,7 @@ public:
     QString serviceName() const;
     void init();
     ServiceType type();
+    ReadingInterface * createInstance(QObject *parent = 0);
 
     void fullRead(bool fr);
     void write(QString command);
@@ -60,7 +62,13 @@ private:
     int idCollector;
     bool allLines;
     QString m_module;
+    SerialConnection *m_connection;
     QSerialPort *m_serial;
+
+    /*!
+     * \brief isValidFrame recognizes a tag frame, used to detect the baud rate.
+     */
+    static bool isValidFrame(const QByteArray &line);
     QMap<qlonglong, QTimer*> m_map;
 
 //    QTextStream m_outReceived;
@@ -68,7 +76,6 @@ private:
 
 public slots:
     void readData();
-    void handleError(QSerialPort::SerialPortError error);
 
     void start();
     void stop();
@@ -0,0 +1,40 @@
+#-------------------------------------------------
+#
+# Append-only segment log persistence module
+#
+#-------------------------------------------------
+
+QT  += core
+
+TARGET = SegmentPersister
+TEMPLATE = lib
+CONFIG += plugin
+
+INCLUDEPATH += ../CoreLibrary
+
+SOURCES += \
+    data/segmentlog.cpp \
+    segmentpersistencemodule.cpp \
+    segmentpersistenceservice.cpp
+
+HEADERS += \
+    data/segmentlog.h \
+    segmentpersistencemodule.h \
+    segmentpersistenceservice.h
+
+OTHER_FILES += SegmentPersistenceModule.json
+
+buildPath = $$OUT_PWD
+
+coreLibPath = $$replace(buildPath, $${TARGET}Module, "")/Main
+
+DESTDIR += $$coreLibPath/modules
+
+unix: {
+    #homePath = $$system(echo $HOME)
+    homePath = /home/pi
+    target.path = $$homePath/FishMonitoring/modules
+    INSTALLS += target
+}
+
+QMAKE_CXXFLAGS += -std=c++11
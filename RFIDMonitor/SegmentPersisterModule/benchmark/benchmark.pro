@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Compares the persistence modules (SQLite partitions and segment log) on the insert path of the readings
+#
+#-------------------------------------------------
+
+QT       += core
+
+QT       -= gui
+
+TARGET = PersistenceBenchmark
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../CoreLibrary
+
+LIBS += -L$$OUT_PWD/../../CoreLibrary
+LIBS += -lCoreLibrary
+
+SOURCES += main.cpp
+
+QMAKE_CXXFLAGS += -std=c++11
@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPluginLoader>
+#include <QStringList>
+#include <QTextStream>
+
+#include <coremodule.h>
+#include <core/clock.h>
+#include <core/interfaces.h>
+#include <core/service.h>
+#include <object/rfiddata.h>
+
+/*
+ * Usage: PersistenceBenchmark [modules directory] [readings] [batch size]
+ *
+ * Loads the persistence modules found in the modules directory (by default the one of the Main project) and commits the same readings,
+ * in batches of the size the IngestJournal uses, through PersistenceInterface::insertObjectList() of each one. The modules run as in the
+ * collector: the SQLite module with the pragmas of ConnectionPool and the day partitions, the segment log with its fdatasync per batch.
+ *
+ * The modules keep their data in the directory of the executable (sysdb.db and segments/), so the benchmark refuses to run where a database
+ * already exists and removes its files at the end.
+ * Run it on the target device, the results on a desktop disk say little about an SD card.
+ */
+
+namespace {
+
+const char *KDataFiles[] = {"sysdb.db", "sysdb.db-wal", "sysdb.db-shm"};
+
+QList<Rfiddata *> makeReadings(int count)
+{
+    QList<Rfiddata *> list;
+    qint64 timestamp = Clock::now();
+    for(int i = 0; i < count; i++){
+        Rfiddata *data = new Rfiddata;
+        data->setIdantena(i % 4);
+        data->setIdpontocoleta(1);
+        data->setApplicationcode(900);
+        data->setIdentificationcode(100000 + i % 500);
+        data->setTimestamp(timestamp + i * 1000);
+        data->setSync(Rfiddata::KNotSynced);
+        list.append(data);
+    }
+    return list;
+}
+
+/*!
+ * \brief benchmark returns the milliseconds taken to insert \a count readings, or -1 if an insert failed.
+ */
+qint64 benchmark(PersistenceInterface *persistence, int count, int batchSize)
+{
+    QList<Rfiddata *> readings = makeReadings(count);
+    QElapsedTimer timer;
+    timer.start();
+    qint64 elapsed = 0;
+    for(int i = 0; i < readings.size(); i += batchSize){
+        if(!persistence->insertObjectList(readings.mid(i, batchSize))){
+            elapsed = -1;
+            break;
+        }
+    }
+    if(elapsed == 0)
+        elapsed = timer.elapsed();
+    qDeleteAll(readings);
+    return elapsed;
+}
+
+void removeData(const QString &path)
+{
+    for(unsigned i = 0; i < sizeof(KDataFiles) / sizeof(*KDataFiles); i++)
+        QFile::remove(path + "/" + KDataFiles[i]);
+    QDir(path + "/segments").removeRecursively();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList args = a.arguments();
+    QTextStream out(stdout);
+    QString appDir(QCoreApplication::applicationDirPath());
+
+    QString modulesPath = args.size() > 1 ? args.at(1) : appDir + "/../../Main/modules";
+    int count = args.size() > 2 ? args.at(2).toInt() : 100000;
+    int batchSize = args.size() > 3 ? args.at(3).toInt() : 256;
+    if(count <= 0 || batchSize <= 0){
+        out << "Usage: PersistenceBenchmark [modules directory] [readings] [batch size]" << endl;
+        return 1;
+    }
+
+    if(QFile::exists(appDir + "/sysdb.db") || QFile::exists(appDir + "/segments")){
+        out << QString("%1 already has a database, run the benchmark from another directory").arg(appDir) << endl;
+        return 1;
+    }
+
+    out << QString("%1 readings in batches of %2").arg(count).arg(batchSize) << endl;
+
+    int benchmarked = 0;
+    QDir modulesDir(modulesPath);
+    foreach (QString fileName, modulesDir.entryList(QDir::Files)) {
+        QPluginLoader loader(modulesDir.absoluteFilePath(fileName));
+        CoreModule *module = qobject_cast<CoreModule *>(loader.instance());
+        if(!module)
+            continue;
+        module->init();
+
+        foreach (Service *service, module->services()) {
+            PersistenceInterface *persistence = qobject_cast<PersistenceInterface *>(service);
+            if(!persistence)
+                continue;
+
+            qint64 elapsed = benchmark(persistence, count, batchSize);
+            if(elapsed < 0)
+                out << QString("%1: insert failed").arg(service->serviceName(), -30) << endl;
+            else
+                out << QString("%1: %2 ms, %3 readings/s").arg(service->serviceName(), -30).arg(elapsed).arg(elapsed ? count * 1000 / elapsed : 0) << endl;
+            benchmarked++;
+        }
+    }
+    removeData(appDir);
+
+    if(benchmarked == 0){
+        out << QString("No persistence module found in %1").arg(QFileInfo(modulesPath).absoluteFilePath()) << endl;
+        return 1;
+    }
+    return 0;
+}
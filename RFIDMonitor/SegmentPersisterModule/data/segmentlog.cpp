@@ -0,0 +1,525 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <logger.h>
+#include <core/clock.h>
+#include <core/functions.h>
+#include <core/sql/selectquery.h>
+#include <object/rfiddata.h>
+
+#include "segmentlog.h"
+
+namespace {
+
+/*
+ * Layout of one record (little endian):
+ * [id      ][idantena][idpontocoleta][applicationcode][identificationcode][timestamp][sync][flags][reserved][crc32  ]
+ * [ 8 bytes][ 4 bytes][ 4 bytes     ][ 8 bytes       ][ 8 bytes          ][ 8 bytes ][ 1  ][ 1   ][ 2      ][4 bytes]
+ * The timestamp is in microseconds (UTC), segments of older versions have it in milliseconds (see Clock::fromStored()).
+ * The CRC covers only the first KPayloadSize bytes, so sync and flags can be changed in place.
+ */
+const int KPayloadSize = 40;
+const int KStateOffset = 40;
+const int KCrcOffset = 44;
+const uchar KTombstone = 0x01;
+
+const char KIndexMagic[4] = {'R', 'S', 'E', 'G'};
+const quint32 KIndexVersion = 1;
+const int KIndexSize = 36;
+
+const char *KModule = "SegmentPersistenceModule";
+
+void encode(const Rfiddata *rfiddata, uchar *record)
+{
+    qToLittleEndian<qint64>(rfiddata->id().toLongLong(), record);
+    qToLittleEndian<qint32>(rfiddata->idantena().toInt(), record + 8);
+    qToLittleEndian<qint32>(rfiddata->idpontocoleta().toInt(), record + 12);
+    qToLittleEndian<qint64>(rfiddata->applicationcode().toLongLong(), record + 16);
+    qToLittleEndian<qint64>(rfiddata->identificationcode().toLongLong(), record + 24);
+    qToLittleEndian<qint64>(rfiddata->timestamp(), record + 32);
+    record[KStateOffset] = uchar(rfiddata->sync().toInt());
+    record[KStateOffset + 1] = 0;
+    record[KStateOffset + 2] = 0;
+    record[KStateOffset + 3] = 0;
+    qToLittleEndian<quint32>(Functions::crc32(record, KPayloadSize), record + KCrcOffset);
+}
+
+Rfiddata * decode(const uchar *record, QObject *parent)
+{
+    Rfiddata *rfiddata = new Rfiddata(parent);
+    rfiddata->setId(qFromLittleEndian<qint64>(record));
+    rfiddata->setIdantena(qFromLittleEndian<qint32>(record + 8));
+    rfiddata->setIdpontocoleta(qFromLittleEndian<qint32>(record + 12));
+    rfiddata->setApplicationcode(qFromLittleEndian<qint64>(record + 16));
+    rfiddata->setIdentificationcode(qFromLittleEndian<qint64>(record + 24));
+    rfiddata->setTimestamp(Clock::fromStored(qFromLittleEndian<qint64>(record + 32)));
+    rfiddata->setSync(int(record[KStateOffset]));
+    return rfiddata;
+}
+
+bool isValid(const uchar *record, qlonglong expectedId)
+{
+    return qFromLittleEndian<qint64>(record) == expectedId
+            && qFromLittleEndian<quint32>(record + KCrcOffset) == Functions::crc32(record, KPayloadSize);
+}
+
+/*!
+ * \brief The SegmentView class gives read access to the records of a segment, through mmap when possible.
+ */
+class SegmentView
+{
+public:
+    SegmentView(QFile *file, qint64 size) :
+        m_file(file),
+        m_map(0)
+    {
+        if(size > 0){
+            m_map = file->map(0, size);
+            if(!m_map){
+                file->seek(0);
+                m_buffer = file->read(size);
+            }
+        }
+    }
+
+    ~SegmentView()
+    {
+        if(m_map)
+            m_file->unmap(m_map);
+    }
+
+    const uchar * data() const
+    {
+        return m_map ? m_map : reinterpret_cast<const uchar *>(m_buffer.constData());
+    }
+
+private:
+    QFile *m_file;
+    uchar *m_map;
+    QByteArray m_buffer;
+};
+
+}
+
+SegmentLog::SegmentLog(const QString &path, int recordsPerSegment) :
+    m_path(path),
+    m_recordsPerSegment(recordsPerSegment),
+    m_nextId(1),
+    m_indexActiveFirstId(-1),
+    m_indexCommitOffset(0)
+{
+}
+
+SegmentLog::~SegmentLog()
+{
+    close();
+}
+
+bool SegmentLog::open()
+{
+    if(!QDir().mkpath(m_path)){
+        m_errorString = QString("Can't create the directory %1").arg(m_path);
+        return false;
+    }
+
+    if(!readIndex()){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, KModule, Q_FUNC_INFO, "Segment index not found or invalid, all records of the active segment will be verified");
+    }
+
+    QDir dir(m_path);
+    foreach (QString fileName, dir.entryList(QStringList() << "*.seg", QDir::Files, QDir::Name)) {
+        QFile *file = new QFile(dir.absoluteFilePath(fileName));
+        if(!file->open(QIODevice::ReadWrite)){
+            m_errorString = QString("Can't open segment %1: %2").arg(fileName).arg(file->errorString());
+            delete file;
+            close();
+            return false;
+        }
+        Segment *segment = new Segment;
+        segment->firstId = QFileInfo(fileName).baseName().toLongLong();
+        segment->count = int(file->size() / KRecordSize);
+        segment->live = 0;
+        segment->file = file;
+        // Discard a partially written record
+        if(file->size() % KRecordSize)
+            file->resize(qint64(segment->count) * KRecordSize);
+        m_segments.insert(segment->firstId, segment);
+    }
+
+    if(!m_segments.isEmpty()){
+        // Only the active segment can have records written after the last commit
+        Segment *active = m_segments.last();
+        int committed = 0;
+        if(active->firstId == m_indexActiveFirstId)
+            committed = qMin(active->count, int(m_indexCommitOffset / KRecordSize));
+        recover(active, committed);
+        m_nextId = qMax(m_nextId, active->firstId + active->count);
+    }
+
+    foreach (Segment *segment, m_segments) {
+        SegmentView view(segment->file, qint64(segment->count) * KRecordSize);
+        for(int i = 0; i < segment->count; i++){
+            if(!(view.data()[i * KRecordSize + KStateOffset + 1] & KTombstone))
+                segment->live++;
+        }
+    }
+
+    foreach (Segment *segment, m_segments.values()) {
+        if(segment->live == 0 && segment->count >= m_recordsPerSegment)
+            reclaim(segment);
+    }
+
+    return writeIndex();
+}
+
+void SegmentLog::close()
+{
+    foreach (Segment *segment, m_segments) {
+        segment->file->close();
+        delete segment->file;
+        delete segment;
+    }
+    m_segments.clear();
+}
+
+bool SegmentLog::append(const QList<Rfiddata *> &data)
+{
+    int index = 0;
+    while(index < data.size()){
+        Segment *segment = m_segments.isEmpty() ? 0 : m_segments.last();
+        if(!segment || segment->count >= m_recordsPerSegment){
+            segment = createSegment(m_nextId);
+            if(!segment)
+                return false;
+        }
+
+        int count = qMin(m_recordsPerSegment - segment->count, data.size() - index);
+        QByteArray buffer(count * KRecordSize, 0);
+        uchar *record = reinterpret_cast<uchar *>(buffer.data());
+        for(int i = 0; i < count; i++){
+            data.at(index + i)->setId(m_nextId + i);
+            encode(data.at(index + i), record + i * KRecordSize);
+        }
+
+        qint64 offset = qint64(segment->count) * KRecordSize;
+        if(!segment->file->seek(offset) || segment->file->write(buffer) != buffer.size() || !syncFile(segment->file)){
+            m_errorString = QString("Can't append to segment %1: %2").arg(segment->file->fileName()).arg(segment->file->errorString());
+            segment->file->resize(offset);
+            return false;
+        }
+
+        segment->count += count;
+        segment->live += count;
+        m_nextId += count;
+        index += count;
+    }
+    return writeIndex();
+}
+
+bool SegmentLog::update(const QList<Rfiddata *> &data)
+{
+    return writeState(data, false);
+}
+
+bool SegmentLog::remove(const QList<Rfiddata *> &data)
+{
+    return writeState(data, true);
+}
+
+QList<Rfiddata *> SegmentLog::records(const QString &column, const QVariant &value, QObject *parent)
+{
+    QList<Rfiddata *> list;
+    // The packager asks for the not synchronized records, this column is checked without creating the objects
+    bool bySync = (column == "sync");
+    uchar syncValue = uchar(value.toInt());
+    QByteArray propertyName = column.toLatin1();
+
+    foreach (Segment *segment, m_segments) {
+        if(!segment->live)
+            continue;
+        SegmentView view(segment->file, qint64(segment->count) * KRecordSize);
+        for(int i = 0; i < segment->count; i++){
+            const uchar *record = view.data() + i * KRecordSize;
+            if(record[KStateOffset + 1] & KTombstone)
+                continue;
+            if(bySync){
+                if(record[KStateOffset] == syncValue)
+                    list.append(decode(record, parent));
+                continue;
+            }
+            Rfiddata *rfiddata = decode(record, parent);
+            if(rfiddata->property(propertyName.constData()) == value)
+                list.append(rfiddata);
+            else
+                delete rfiddata;
+        }
+    }
+    return list;
+}
+
+QList<Rfiddata *> SegmentLog::records(const QueryBuilder &query, QObject *parent)
+{
+    QList<Rfiddata *> list;
+    bool descending = (query.order() == QueryBuilder::Order::KDescending);
+    int limit = query.limit();
+
+    QList<Segment *> segments = m_segments.values();
+    if(descending)
+        std::reverse(segments.begin(), segments.end());
+
+    foreach (Segment *segment, segments) {
+        if(!segment->live)
+            continue;
+        SegmentView view(segment->file, qint64(segment->count) * KRecordSize);
+        for(int n = 0; n < segment->count; n++){
+            if(limit >= 0 && list.size() >= limit)
+                return list;
+            int i = descending ? segment->count - 1 - n : n;
+            const uchar *record = view.data() + i * KRecordSize;
+            if(record[KStateOffset + 1] & KTombstone)
+                continue;
+            Rfiddata *rfiddata = decode(record, parent);
+            if(query.matches(rfiddata))
+                list.append(rfiddata);
+            else
+                delete rfiddata;
+        }
+    }
+    return list;
+}
+
+QString SegmentLog::errorString() const
+{
+    return m_errorString;
+}
+
+SegmentLog::Segment *SegmentLog::segmentOf(qlonglong id)
+{
+    QMap<qlonglong, Segment *>::iterator it = m_segments.upperBound(id);
+    if(it == m_segments.begin())
+        return 0;
+    --it;
+    Segment *segment = it.value();
+    return id < segment->firstId + segment->count ? segment : 0;
+}
+
+SegmentLog::Segment *SegmentLog::createSegment(qlonglong firstId)
+{
+    QFile *file = new QFile(QString("%1/%2.seg").arg(m_path).arg(firstId, 16, 10, QChar('0')));
+    if(!file->open(QIODevice::ReadWrite | QIODevice::Truncate)){
+        m_errorString = QString("Can't create segment %1: %2").arg(file->fileName()).arg(file->errorString());
+        delete file;
+        return 0;
+    }
+
+    // Make the new directory entry durable before any record is committed to it
+    int dirFd = ::open(QFile::encodeName(m_path).constData(), O_RDONLY);
+    if(dirFd >= 0){
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+
+    Segment *segment = new Segment;
+    segment->firstId = firstId;
+    segment->count = 0;
+    segment->live = 0;
+    segment->file = file;
+    m_segments.insert(firstId, segment);
+    return segment;
+}
+
+bool SegmentLog::writeState(const QList<Rfiddata *> &data, bool tombstone)
+{
+    QMap<Segment *, QList<Rfiddata *> > bySegment;
+    foreach (Rfiddata *rfiddata, data) {
+        Segment *segment = segmentOf(rfiddata->id().toLongLong());
+        if(segment)
+            bySegment[segment].append(rfiddata);
+    }
+
+    bool ok = true;
+    QMap<Segment *, QList<Rfiddata *> >::iterator it;
+    for(it = bySegment.begin(); it != bySegment.end(); ++it){
+        Segment *segment = it.key();
+        uchar *map = segment->file->map(0, qint64(segment->count) * KRecordSize);
+        foreach (Rfiddata *rfiddata, it.value()) {
+            qint64 offset = (rfiddata->id().toLongLong() - segment->firstId) * KRecordSize + KStateOffset;
+            uchar state[2];
+            if(map){
+                memcpy(state, map + offset, sizeof(state));
+            }else{
+                segment->file->seek(offset);
+                segment->file->read(reinterpret_cast<char *>(state), sizeof(state));
+            }
+
+            if(tombstone){
+                if(state[1] & KTombstone)
+                    continue;
+                state[1] |= KTombstone;
+                segment->live--;
+            }else{
+                state[0] = uchar(rfiddata->sync().toInt());
+            }
+
+            if(map){
+                memcpy(map + offset, state, sizeof(state));
+            }else{
+                segment->file->seek(offset);
+                segment->file->write(reinterpret_cast<const char *>(state), sizeof(state));
+            }
+        }
+        if(map)
+            segment->file->unmap(map);
+        ok = syncFile(segment->file) && ok;
+    }
+
+    if(tombstone){
+        bool reclaimed = false;
+        foreach (Segment *segment, bySegment.keys()) {
+            if(segment->live == 0 && segment->count >= m_recordsPerSegment){
+                reclaim(segment);
+                reclaimed = true;
+            }
+        }
+        // The active segment may have been removed
+        if(reclaimed)
+            ok = writeIndex() && ok;
+    }
+    return ok;
+}
+
+void SegmentLog::reclaim(SegmentLog::Segment *segment)
+{
+    QString fileName = segment->file->fileName();
+    m_segments.remove(segment->firstId);
+    segment->file->close();
+    delete segment->file;
+    delete segment;
+
+    QFile::remove(fileName);
+    Logger::instance()->writeRecord(Logger::severity_level::debug, KModule, Q_FUNC_INFO, QString("Segment %1 reclaimed").arg(fileName));
+}
+
+bool SegmentLog::syncFile(QFile *file)
+{
+    file->flush();
+    if(::fdatasync(file->handle()) != 0){
+        m_errorString = QString("Can't sync %1").arg(file->fileName());
+        return false;
+    }
+    return true;
+}
+
+bool SegmentLog::readIndex()
+{
+    QFile file(m_path + "/segments.idx");
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray content = file.readAll();
+    const uchar *data = reinterpret_cast<const uchar *>(content.constData());
+    if(content.size() != KIndexSize
+            || memcmp(data, KIndexMagic, sizeof(KIndexMagic)) != 0
+            || qFromLittleEndian<quint32>(data + 4) != KIndexVersion
+            || qFromLittleEndian<quint32>(data + 32) != Functions::crc32(data, 32))
+        return false;
+
+    m_nextId = qFromLittleEndian<qint64>(data + 8);
+    m_indexActiveFirstId = qFromLittleEndian<qint64>(data + 16);
+    m_indexCommitOffset = qFromLittleEndian<qint64>(data + 24);
+    return true;
+}
+
+bool SegmentLog::writeIndex()
+{
+    Segment *active = m_segments.isEmpty() ? 0 : m_segments.last();
+    m_indexActiveFirstId = active ? active->firstId : -1;
+    m_indexCommitOffset = active ? qint64(active->count) * KRecordSize : 0;
+
+    uchar data[KIndexSize];
+    memcpy(data, KIndexMagic, sizeof(KIndexMagic));
+    qToLittleEndian<quint32>(KIndexVersion, data + 4);
+    qToLittleEndian<qint64>(m_nextId, data + 8);
+    qToLittleEndian<qint64>(m_indexActiveFirstId, data + 16);
+    qToLittleEndian<qint64>(m_indexCommitOffset, data + 24);
+    qToLittleEndian<quint32>(Functions::crc32(data, 32), data + 32);
+
+    // Write a new index and replace the old one, so a power cut never leaves a half written index
+    QString indexPath(m_path + "/segments.idx");
+    QFile file(indexPath + ".tmp");
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(reinterpret_cast<const char *>(data), KIndexSize) != KIndexSize
+            || !syncFile(&file)){
+        m_errorString = QString("Can't write the segment index: %1").arg(file.errorString());
+        return false;
+    }
+    file.close();
+    if(::rename(QFile::encodeName(file.fileName()).constData(), QFile::encodeName(indexPath).constData()) != 0){
+        m_errorString = "Can't replace the segment index";
+        return false;
+    }
+
+    // The rename is durable only when the directory is synced
+    int dirFd = ::open(QFile::encodeName(m_path).constData(), O_RDONLY);
+    if(dirFd < 0 || ::fsync(dirFd) != 0){
+        m_errorString = "Can't sync the directory of the segment index";
+        if(dirFd >= 0)
+            ::close(dirFd);
+        return false;
+    }
+    ::close(dirFd);
+    return true;
+}
+
+int SegmentLog::recover(SegmentLog::Segment *segment, int validCount)
+{
+    int count = validCount;
+    {
+        SegmentView view(segment->file, qint64(segment->count) * KRecordSize);
+        while(count < segment->count && isValid(view.data() + count * KRecordSize, segment->firstId + count))
+            count++;
+    }
+
+    if(count < segment->count){
+        Logger::instance()->writeRecord(Logger::severity_level::warning, KModule, Q_FUNC_INFO, QString("Discarding %1 uncommitted records of segment %2").arg(segment->count - count).arg(segment->file->fileName()));
+        segment->file->resize(qint64(count) * KRecordSize);
+        segment->count = count;
+    }
+    return count;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef SEGMENTLOG_H
+#define SEGMENTLOG_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+class QFile;
+class QObject;
+class QueryBuilder;
+class Rfiddata;
+
+/*!
+ * \brief The SegmentLog class stores the readings in append-only segment files.
+ *
+ * Every reading is a fixed-width binary record of KRecordSize bytes, protected by a CRC32. The ids are assigned
+ * sequentially by the log, so the position of a record inside its segment is (id - first id of the segment) * KRecordSize.
+ * The synchronization state and the tombstone (deleted) mark live outside the CRC and are updated in place.
+ *
+ * A small index file keeps the next id and the committed (fdatasync'ed) size of the active segment. At startup only the records
+ * written after the last commit are verified, a torn record at the end is discarded.
+ * A segment is removed from disk as soon as it is full and all of its records are deleted.
+ */
+class SegmentLog
+{
+public:
+    /*!
+     * \brief KRecordSize is the size in bytes of one record in the segment files.
+     */
+    static const int KRecordSize = 48;
+
+    explicit SegmentLog(const QString &path, int recordsPerSegment = 4096);
+    ~SegmentLog();
+
+    bool open();
+    void close();
+
+    /*!
+     * \brief append assigns a new id to each object and appends them to the log. The data is durable when this function returns true.
+     */
+    bool append(const QList<Rfiddata *> &data);
+
+    /*!
+     * \brief update writes the synchronization state of the objects to their records.
+     */
+    bool update(const QList<Rfiddata *> &data);
+
+    /*!
+     * \brief remove marks the records of the objects as deleted and reclaims the segments that are not used anymore.
+     */
+    bool remove(const QList<Rfiddata *> &data);
+
+    /*!
+     * \brief records returns the live records where the property \a column of Rfiddata is equal to \a value.
+     */
+    QList<Rfiddata *> records(const QString &column, const QVariant &value, QObject *parent);
+
+    /*!
+     * \brief records returns the live records that match the conditions of \a query, up to its limit.
+     * The records are in the order of the ids (the newest first for a descending order), all fields are filled.
+     */
+    QList<Rfiddata *> records(const QueryBuilder &query, QObject *parent);
+
+    QString errorString() const;
+
+private:
+    struct Segment
+    {
+        qlonglong firstId;
+        int count;
+        int live;
+        QFile *file;
+    };
+
+    Segment * segmentOf(qlonglong id);
+    Segment * createSegment(qlonglong firstId);
+    bool writeState(const QList<Rfiddata *> &data, bool tombstone);
+    void reclaim(Segment *segment);
+    bool syncFile(QFile *file);
+    bool readIndex();
+    bool writeIndex();
+    int recover(Segment *segment, int validCount);
+
+    QString m_path;
+    int m_recordsPerSegment;
+    qlonglong m_nextId;
+    qint64 m_indexActiveFirstId;
+    qint64 m_indexCommitOffset;
+    QMap<qlonglong, Segment *> m_segments;
+    QString m_errorString;
+};
+
+#endif // SEGMENTLOG_H
@@ -0,0 +1,56 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef SEGMENTPERSISTENCEMODULE_H
+#define SEGMENTPERSISTENCEMODULE_H
+
+/*!
+ * \class SegmentPersistenceModule
+ * \brief The SegmentPersistenceModule class provides a persistence service that stores the RFIDData objects in append-only segment files.
+ */
+
+#include <coremodule.h>
+
+class SegmentPersistenceModule : public CoreModule
+{
+    Q_OBJECT
+#if QT_VERSION >= 0x050000
+    Q_PLUGIN_METADATA(IID "org.celtab.CoreModule" FILE "SegmentPersistenceModule.json")
+#endif // QT_VERSION >= 0x050000
+
+public:
+    explicit SegmentPersistenceModule(QObject *parent=0);
+
+    void init();
+
+    QString name();
+
+    quint32 version();
+};
+
+#endif // SEGMENTPERSISTENCEMODULE_H
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+
+#include <logger.h>
+#include <object/rfiddata.h>
+
+#include "segmentpersistenceservice.h"
+#include "data/segmentlog.h"
+
+SegmentPersistenceService::SegmentPersistenceService(QObject *parent) :
+    PersistenceInterface(parent),
+    m_log(new SegmentLog(QCoreApplication::applicationDirPath() + "/segments")),
+    m_opened(false),
+    m_module("SegmentPersistenceModule")
+{
+}
+
+SegmentPersistenceService::~SegmentPersistenceService()
+{
+    delete m_log;
+}
+
+QString SegmentPersistenceService::serviceName() const
+{
+    return "segmentpersistence.service";
+}
+
+void SegmentPersistenceService::init()
+{
+
+}
+
+ServiceType SegmentPersistenceService::type()
+{
+    return ServiceType::KPersister;
+}
+
+QList<Rfiddata *> SegmentPersistenceService::getObjectList(const QString &ColumnObject, QVariant value, QObject *parent)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!ensureOpen())
+        return QList<Rfiddata *>();
+    return m_log->records(ColumnObject, value, parent);
+}
+
+QList<Rfiddata *> SegmentPersistenceService::select(const SelectQuery<Rfiddata> &query, QObject *parent)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!ensureOpen())
+        return QList<Rfiddata *>();
+    return m_log->records(query, parent);
+}
+
+bool SegmentPersistenceService::insertObjectList(const QList<Rfiddata *> &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!ensureOpen())
+        return false;
+    if(!m_log->append(data)){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Insert Error: %1").arg(m_log->errorString()));
+        return false;
+    }
+    return true;
+}
+
+void SegmentPersistenceService::updateObjectList(const QList<Rfiddata *> &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(ensureOpen() && !m_log->update(data))
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Update Error: %1").arg(m_log->errorString()));
+}
+
+void SegmentPersistenceService::deleteObjectList(const QList<Rfiddata *> &data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(ensureOpen() && !m_log->remove(data))
+        Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Delete Error: %1").arg(m_log->errorString()));
+}
+
+bool SegmentPersistenceService::ensureOpen()
+{
+    // The log is opened on first use, so the module costs nothing when another persister is the default one
+    if(!m_opened){
+        m_opened = m_log->open();
+        if(!m_opened)
+            Logger::instance()->writeRecord(Logger::severity_level::critical, m_module, Q_FUNC_INFO, QString("Can't open the segment log: %1").arg(m_log->errorString()));
+    }
+    return m_opened;
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+**
+** WWW.FISHMONITORING.COM.BR
+**
+** Copyright (C) 2013
+**                     Gustavo Valiati <gustavovaliati@gmail.com>
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**                     Thiago R. M. Bitencourt <thiago.mbitencourt@gmail.com>
+**
+** This file is part of the FishMonitoring project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+
+#ifndef SEGMENTPERSISTENCESERVICE_H
+#define SEGMENTPERSISTENCESERVICE_H
+
+#include <QObject>
+#include <QMutex>
+
+#include <core/interfaces.h>
+
+class SegmentLog;
+
+/*!
+ * \brief The SegmentPersistenceService class is a PersistenceInterface that keeps the readings in an append-only segment log
+ * instead of the SQLite database. It fits the write-heavy workload of the collector: insert, package once and delete on ack.
+ *
+ * To use it, set "segmentpersistence.service" as the persister in the "defaultservices" section of rfidmonitor.json.
+ */
+class SegmentPersistenceService : public PersistenceInterface
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentPersistenceService(QObject *parent = 0);
+    ~SegmentPersistenceService();
+
+    QString serviceName() const;
+    void init();
+    ServiceType type();
+    QList<Rfiddata *> getObjectList(const QString &ColumnObject, QVariant value, QObject *parent);
+    QList<Rfiddata *> select(const SelectQuery<Rfiddata> &query, QObject *parent);
+    bool insertObjectList(const QList<Rfiddata *> &data);
+    void updateObjectList(const QList<Rfiddata *> &data);
+    void deleteObjectList(const QList<Rfiddata *> &data);
+
+private:
+    bool ensureOpen();
+
+    QMutex m_mutex;
+    SegmentLog *m_log;
+    bool m_opened;
+    QString m_module;
+};
+
+#endif // SEGMENTPERSISTENCESERVICE_H
@@ -2,6 +2,8 @@
 #include <QSqlDatabase>
 #include <QSqlRecord>
 #include <QSharedPointer>
+#include <QIODevice>
+#include <QThread>
 
 #include <logger.h>
 
@@ -52,9 +54,9 @@ bool PacketDAO::insertObject(Packet *packet)
     try{
         //Create the query.
         SqlQuery query(&m_db);
-        query.prepare("insert into packet (md5hash, datetime, idbegin, item_count, jsondata, status) "
-                      " values(:md5hash, :datetime, :idbegin, :item_count, :jsondata, :status) ");
-        query.bindValue(":md5hash", packet->md5hash());
+        query.prepare("insert into packet (hash, datetime, idbegin, item_count, jsondata, status) "
+                      " values(:hash, :datetime, :idbegin, :item_count, :jsondata, :status) ");
+        query.bindValue(":hash", packet->hash());
         query.bindValue(":datetime", packet->dateTime());
         query.bindValue(":idbegin", packet->idBegin());
         query.bindValue(":item_count", packet->itemCount());
@@ -85,9 +87,9 @@ bool PacketDAO::insertObjectList(const QList<Packet *> &list)
         foreach (Packet *packet, list) {
             //Create the query.
             SqlQuery query(&m_db);
-            query.prepare("insert into packet (md5hash, datetime, idbegin, item_count, jsondata, status) "
-                          " values(:md5hash, :datetime, :idbegin, :item_count, :jsondata, :status) ");
-            query.bindValue(":md5hash", packet->md5hash());
+            query.prepare("insert into packet (hash, datetime, idbegin, item_count, jsondata, status) "
+                          " values(:hash, :datetime, :idbegin, :item_count, :jsondata, :status) ");
+            query.bindValue(":hash", packet->hash());
             query.bindValue(":datetime", packet->dateTime());
             query.bindValue(":idbegin", packet->idBegin());
             query.bindValue(":item_count", packet->itemCount());
@@ -123,8 +125,8 @@ bool PacketDAO::updateObject(Packet *packet)
     try{
         SqlQuery query(&m_db);
         query.prepare("update packet set idbegin = :idbegin, item_count = :item_count, jsondata = :jsondata, status = :status, "
-                      "datetime = :datetime where md5hash = :md5hash ");
-        query.bindValue(":md5hash", packet->md5hash());
+                      "datetime = :datetime where hash = :hash ");
+        query.bindValue(":hash", packet->hash());
         query.bindValue(":datetime", packet->dateTime());
         query.bindValue(":idbegin", packet->idBegin());
         query.bindValue(":item_count", packet->itemCount());
@@ -159,8 +161,8 @@ bool PacketDAO::updateObjectList(const QList<Packet *> &list)
 
             SqlQuery query(&m_db);
             query.prepare("update packet set idbegin = :idbegin, item_count = :item_count, jsondata = :jsondata, status = :status, "
-                          "datetime = :datetime where md5hash = :md5hash ");
-            query.bindValue(":md5hash", packet->md5hash());
+                          "datetime = :datetime where hash = :hash ");
+            query.bindValue(":hash", packet->hash());
             query.bindValue(":datetime", packet->dateTime());
             query.bindValue(":idbegin", packet->idBegin());
             query.bindValue(":item_count", packet->itemCount());
@@ -193,8 +195,8 @@ bool PacketDAO::deleteObject(Packet *packet)
 
     try{
         SqlQuery query(&m_db);
-        query.prepare("delete from packet where md5hash = :md5hash");
-        query.bindValue(":md5hash", packet->md5hash());
+        query.prepare("delete from packet where hash = :hash");
+        query.bindValue(":hash", packet->hash());
         query.exec();
 
         // Commit and terminate the transaction.
@@ -222,38 +224,8 @@ bool PacketDAO::deleteObjectList(const QList<Packet *> &list)
     try{
         foreach (Packet * packet, list) {
             SqlQuery query(&m_db);
-            query.prepare("delete from packet where md5hash = :md5hash");
-            query.bindValue(":md5hash", packet->md5hash());
-            query.exec();
-        }
-
-        // Commit and terminate the transaction.
-        m_db.commit();
-        return true;
-
-    }catch(SqlException &ex){
-        Logger::instance()->writeRecord(Logger::severity_level::critical, "SynchronizationModule", Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
-        //If is there any exception caught, do rollback and close the transaction, aborting the insertion.
-        m_db.rollback();
-        return false;
-    }
-}
-
-bool PacketDAO::deleteRFIDDataList(const QString &packetHash, const QList<int> &idList)
-{
-    // Start new transaction.
-    m_db.transaction();
-
-    try{
-        SqlQuery query(&m_db);
-        query.prepare("delete from packet where md5hash = :md5hash");
-        query.bindValue(":md5hash", packetHash);
-        query.exec();
-
-        foreach (int id, idList) {
-            SqlQuery query(&m_db);
-            query.prepare("delete from rfiddata where id = :id");
-            query.bindValue(":id", id);
+            query.prepare("delete from packet where hash = :hash");
+            query.bindValue(":hash", packet->hash());
             query.exec();
         }
 
@@ -279,8 +251,8 @@ Packet * PacketDAO::getById(qlonglong id, QObject *parent)
 {
     try{
         SqlQuery query(&m_db);
-        query.prepare("select md5hash, datetime, idbegin, item_count, jsondata, status from packet  where md5hash = :md5hash ");
-        query.bindValue(":md5hash", id);
+        query.prepare("select hash, datetime, idbegin, item_count, jsondata, status from packet  where hash = :hash ");
+        query.bindValue(":hash", id);
         query.exec();
         Packet *packet = 0;
         if(query.next()){
@@ -308,7 +280,7 @@ QList<Packet *> PacketDAO::getAll(QObject *parent)
 
     try{
         SqlQuery query(&m_db);
-        query.prepare("select md5hash, datetime, idbegin, item_count, jsondata, status from packet ");
+        query.prepare("select hash, datetime, idbegin, item_count, jsondata, status from packet ");
         query.exec();
         while(query.next()){
             /* If the parent is not set to the Packet object, it will be destroyed when this "getById" is done, causing
@@ -341,7 +313,7 @@ QList<Packet *> PacketDAO::getByMatch(const QString &ColumnObject, QVariant valu
         /* Creates the "where" restriction with the column name from "ColumnObject" parameter.
          * and the value of it with "value".
          */
-        QString sqlQuery = QString("select md5hash, datetime, idbegin, item_count, jsondata, status from packet  where %1 = :value ").arg(ColumnObject);
+        QString sqlQuery = QString("select hash, datetime, idbegin, item_count, jsondata, status from packet  where %1 = :value ").arg(ColumnObject);
         query.prepare(sqlQuery);
         query.bindValue(":value", value);
         query.exec();
@@ -359,3 +331,118 @@ QList<Packet *> PacketDAO::getByMatch(const QString &ColumnObject, QVariant valu
         return list;
     }
 }
+
+/*!
+ * \brief PacketDAO::select Offers the way to select a list of Packet objects with a SelectQuery, through a cached statement.
+ * \param selectQuery is the projection, the restrictions, the order and the limit.
+ * \param parent is the parent of whole returned list.
+ * \return QList<Packet *> list of objects found, with only the selected columns filled.
+ */
+QList<Packet *> PacketDAO::select(const SelectQuery<Packet> &selectQuery, QObject *parent)
+{
+    QList<Packet *> list;
+
+    try{
+        SqlQuery query(&m_db);
+        selectQuery.exec(query, &m_db, "packet");
+        while(query.next()){
+            list.append(new Packet(query.record(), parent));
+        }
+        // Releases the cached statement
+        query.finish();
+        return list;
+
+    }catch(SqlException &ex){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, "SynchronizationModule", Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
+        return list;
+    }
+}
+
+/*!
+ * \brief PacketDAO::exportPackets writes the JSON document of each packet with the \a status in \a device, one packet per line.
+ *
+ * The packets are read in a read transaction of a connection of its own, so they come from one consistent snapshot of the database
+ * (the database is in WAL mode, the packager can still write while the export runs). Only one packet is kept in memory at a time.
+ * The status of the packets is not changed, see updateStatus().
+ * \param hashes receives the hex digests of the exported packets.
+ * \return the number of packets exported, or -1 if any error occurred.
+ */
+int PacketDAO::exportPackets(int status, QIODevice *device, QStringList &hashes)
+{
+    // The connection is used only by the thread calling this function
+    QString connectionName(QString("PacketExport%1").arg(quintptr(QThread::currentThreadId())));
+    int count = 0;
+    {
+        QString appDirPath(QCoreApplication::applicationDirPath());
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(appDirPath + "/sysdb.db");
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        db.open();
+
+        db.transaction();
+        try{
+            // The connection is removed at the end, so the statement is not cached
+            SelectQuery<Packet> select;
+            select.columns({Packet::Column::KHash, Packet::Column::KJsonData})
+                    .where(Packet::Column::KStatus, status)
+                    .orderBy(Packet::Column::KIdBegin);
+
+            SqlQuery query(&db);
+            query.setForwardOnly(true);
+            query.prepare(select.sql("packet"));
+            select.bind(query);
+            query.exec();
+            while(query.next()){
+                // The packets are stored without new lines (see serializeData() in packagerservice.cpp), so each one is already a single line
+                QByteArray line(query.value(1).toByteArray());
+                line.append('\n');
+                if(device->write(line) != line.size()){
+                    Logger::instance()->writeRecord(Logger::severity_level::error, "SynchronizationModule", Q_FUNC_INFO, QString("Write Error: %1").arg(device->errorString()));
+                    count = -1;
+                    break;
+                }
+                hashes.append(QString(query.value(0).toByteArray().toHex()));
+                count++;
+            }
+            query.finish();
+            db.commit();
+
+        }catch(SqlException &ex){
+            Logger::instance()->writeRecord(Logger::severity_level::critical, "SynchronizationModule", Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
+            db.rollback();
+            count = -1;
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return count;
+}
+
+/*!
+ * \brief PacketDAO::updateStatus changes the status of the packets identified by the hex digests in one transaction.
+ * \return true if successfully updated, false otherwise.
+ */
+bool PacketDAO::updateStatus(const QStringList &hashes, int status)
+{
+    // Start new transaction.
+    m_db.transaction();
+    try{
+        SqlQuery query(&m_db);
+        query.prepare("update packet set status = :status where hash = :hash ");
+        foreach (const QString &hash, hashes) {
+            query.bindValue(":status", status);
+            query.bindValue(":hash", QByteArray::fromHex(hash.toLatin1()));
+            query.exec();
+        }
+
+        // Commit and terminate the transaction.
+        m_db.commit();
+        return true;
+
+    }catch(SqlException &ex){
+        Logger::instance()->writeRecord(Logger::severity_level::critical, "SynchronizationModule", Q_FUNC_INFO, QString("Transaction Error: %1").arg(ex.errorText()));
+        //If is there any exception caught, do rollback and close the transaction, aborting the update.
+        m_db.rollback();
+        return false;
+    }
+}
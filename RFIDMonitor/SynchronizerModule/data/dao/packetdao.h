@@ -3,10 +3,13 @@
 
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QSqlDatabase>
 
 #include <core/genericdao.h>
+#include <core/sql/selectquery.h>
 
+class QIODevice;
 class Packet;
 
 class PacketDAO : public GenericDAO<Packet>
@@ -26,12 +29,14 @@ public:
     QList<Packet *> getAll(QObject *parent=0);
 
     QList<Packet *> getByMatch(const QString &columnName, QVariant value, QObject *parent=0);
+    QList<Packet *> select(const SelectQuery<Packet> &selectQuery, QObject *parent=0);
 
     bool insertObjectList(const QList<Packet *> &list);
     bool updateObjectList(const QList<Packet *> &list);
     bool deleteObjectList(const QList<Packet *> &list);
 
-    bool deleteRFIDDataList(const QString &packetHash, const QList<int> &idList);
+    int exportPackets(int status, QIODevice *device, QStringList &hashes);
+    bool updateStatus(const QStringList &hashes, int status);
 
 private:
     QSqlDatabase m_db;
@@ -8,25 +8,41 @@ Packet::Packet(QObject *parent) :
 }
 
 Packet::Packet(const QSqlRecord &record, QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    m_idbegin(0),
+    m_itemCount(0),
+    m_status(Status::KNew)
+{
+    // The fields are read by name, the record may have only the columns projected by a SelectQuery
+    int index;
+    if((index = record.indexOf("hash")) >= 0)
+        setHash(record.value(index));
+    if((index = record.indexOf("datetime")) >= 0)
+        setDateTime(record.value(index));
+    if((index = record.indexOf("idbegin")) >= 0)
+        setIdBegin(record.value(index));
+    if((index = record.indexOf("item_count")) >= 0)
+        setItemCount(record.value(index));
+    if((index = record.indexOf("jsondata")) >= 0)
+        setJsonData(record.value(index));
+    if((index = record.indexOf("status")) >= 0)
+        setStatus(record.value(index));
+}
+
+const char *Packet::columnName(Packet::Column column)
 {
-    // md5hash, datetime, idbegin, item_count, jsondata, status
-    setMd5hash(record.value(0));
-    setDateTime(record.value(1));
-    setIdBegin(record.value(2));
-    setItemCount(record.value(3));
-    setJsonData(record.value(4));
-    setStatus(record.value(5));
+    static const char *names[] = {"hash", "datetime", "idbegin", "item_count", "jsondata", "status"};
+    return names[int(column)];
 }
 
-QVariant Packet::md5hash() const
+QVariant Packet::hash() const
 {
-    return m_md5hash;
+    return m_hash;
 }
 
-void Packet::setMd5hash(QVariant value)
+void Packet::setHash(QVariant value)
 {
-    m_md5hash = value.toString();
+    m_hash = value.toByteArray();
 }
 
 QVariant Packet::dateTime() const
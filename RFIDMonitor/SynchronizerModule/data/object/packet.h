@@ -11,12 +11,12 @@ class Packet : public QObject
 {
     Q_OBJECT
 
-    Q_PROPERTY(QVariant md5hash
-        READ md5hash
-        WRITE setMd5hash)
-    Q_PROPERTY(QVariant md5hash
-               READ md5hash
-               WRITE setMd5hash)
+    Q_PROPERTY(QVariant hash
+        READ hash
+        WRITE setHash)
+    Q_PROPERTY(QVariant hash
+               READ hash
+               WRITE setHash)
     Q_PROPERTY(QVariant idBegin
                READ idBegin
                WRITE setIdBegin)
@@ -32,11 +32,19 @@ class Packet : public QObject
 
 public:
     enum class Status {KSynchronized = 0, KNew, KConfimationPending};
+
+    /*!
+     * \brief The Column enum lists the columns of the table "packet", used by SelectQuery<Packet>.
+     */
+    enum class Column {KHash = 0, KDateTime, KIdBegin, KItemCount, KJsonData, KStatus};
+    static const int KColumnCount = 6;
+    static const char * columnName(Column column);
+
     explicit Packet(QObject *parent = 0);
     explicit Packet(const QSqlRecord &record, QObject *parent = 0);
 
-    QVariant md5hash() const;
-    void setMd5hash(QVariant value);
+    QVariant hash() const;
+    void setHash(QVariant value);
 
     QVariant dateTime() const;
     void setDateTime(QVariant value);
@@ -54,7 +62,7 @@ public:
     void setStatus(QVariant value);
 
 private:
-    QString m_md5hash;
+    QByteArray m_hash;
     QDateTime m_dateTime;
     qlonglong m_idbegin;
     qlonglong m_itemCount;
@@ -23,17 +23,20 @@
 **
 ****************************************************************************/
 
-#include <QCryptographicHash>
 #include <QNetworkInterface>
 
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 
+#include <QtConcurrent/QtConcurrent>
+
 #include <functional>
 #include <future>
 
 #include <rfidmonitor.h>
+#include <core/digest.h>
+#include <core/passagedetector.h>
 #include <object/rfiddata.h>
 
 #include <json/synchronizationpacket.h>
@@ -55,6 +58,134 @@ QString getMacAddress()
     return QString();
 }
 
+namespace {
+
+/*!
+ * \brief KPacketSize is the maximum number of readings sent in one packet.
+ */
+const int KPacketSize = 100;
+
+/*!
+ * \brief KBatchSize is the maximum number of readings loaded at once to build packets.
+ */
+const int KBatchSize = KPacketSize * 50;
+
+/*!
+ * \brief packetDocument builds the JSON document of one packet from the already serialized collector header and data array.
+ *
+ * It is the same document QJsonDocument would produce for json::SynchronizationPacket (the keys are kept in alphabetical order),
+ * but built by appending the already serialized parts, so the data array is not serialized twice.
+ */
+QByteArray packetDocument(const QByteArray &header, const QByteArray &data, qlonglong idBegin, qlonglong idEnd, const QByteArray &digest)
+{
+    QByteArray document;
+    document.reserve(header.size() + data.size() + digest.size() + 96);
+    document.append("{\"datasummary\":{\"data\":");
+    document.append(data);
+    document.append(",\"idbegin\":");
+    document.append(QByteArray::number(idBegin));
+    document.append(",\"idend\":");
+    document.append(QByteArray::number(idEnd));
+    document.append(",\"md5diggest\":\"");
+    document.append(digest);
+    document.append("\"},");
+    // header is a complete object: {"id":...,"macaddress":...,"name":...}, skip its opening brace
+    document.append(header.constData() + 1, header.size() - 1);
+    return document;
+}
+
+/*!
+ * \brief serializeData serializes the data array of a packet once and computes its digest over those bytes.
+ *
+ * The legacy servers check the MD5 of the indented serialization, so with MD5 the indented bytes are hashed and sent. Their new lines
+ * are only whitespace between the tokens (a new line inside a string is escaped), they are removed so the stored document stays in one line.
+ * The other digests use the compact serialization.
+ */
+QByteArray serializeData(const QJsonArray &array, Digest::Algorithm algorithm, QByteArray &hash)
+{
+    if(algorithm == Digest::Algorithm::KMd5){
+        QByteArray bytes(QJsonDocument(array).toJson(QJsonDocument::Indented));
+        hash = Digest::hash(bytes, algorithm);
+        return bytes.replace('\n', QByteArray());
+    }
+    QByteArray bytes(QJsonDocument(array).toJson(QJsonDocument::Compact));
+    hash = Digest::hash(bytes, algorithm);
+    return bytes;
+}
+
+struct BuiltPacket
+{
+    QByteArray hash;
+    QByteArray document;
+    qlonglong idBegin;
+    qlonglong itemCount;
+};
+
+/*!
+ * \brief The PacketBuilder struct serializes and hashes one chunk of readings. It only reads the Rfiddata objects,
+ * so many chunks can be built at the same time by the worker threads.
+ */
+struct PacketBuilder
+{
+    typedef BuiltPacket result_type;
+
+    QByteArray header;
+    Digest::Algorithm algorithm;
+
+    BuiltPacket operator()(const QList<Rfiddata *> &rows) const
+    {
+        QJsonArray dataArray;
+        foreach (Rfiddata *rf, rows) {
+            json::Data d;
+            d.setId(rf->id().toInt());
+            d.setIdcollectorPoint(rf->idpontocoleta().toInt());
+            d.setIdantena(rf->idantena().toInt());
+            d.setIdentificationCode(rf->identificationcode().toLongLong());
+            d.setApplicationCode(rf->applicationcode().toLongLong());
+            d.setTimestamp(rf->timestamp());
+            QJsonObject obj;
+            d.write(obj);
+            dataArray.append(obj);
+        }
+
+        BuiltPacket built;
+        built.idBegin = rows.first()->id().toLongLong();
+        built.itemCount = rows.size();
+
+        // The data array is serialized only once, the digest is computed over the same bytes that are sent to the server
+        QByteArray dataBytes = serializeData(dataArray, algorithm, built.hash);
+        built.document = packetDocument(header, dataBytes, built.idBegin, rows.last()->id().toLongLong(), built.hash.toHex());
+        return built;
+    }
+};
+
+/*!
+ * \brief lastPackagedId returns the last reading id already in a packet, or -1 when there is no packet.
+ *
+ * The packets and the synchronized flag of their readings are committed in two transactions, the readings may not even be in the same database.
+ * After a crash between both, the readings up to this id are still not synchronized, but must not be packaged again.
+ * The readings are packaged in the order of their ids, so the packet with the highest idbegin holds the last one.
+ */
+qlonglong lastPackagedId()
+{
+    SelectQuery<Packet> last;
+    last.columns({Packet::Column::KJsonData})
+            .orderBy(Packet::Column::KIdBegin, QueryBuilder::Order::KDescending)
+            .limit(1);
+    QList<Packet *> packets = PacketDAO::instance()->select(last);
+    if(packets.isEmpty())
+        return -1;
+
+    QJsonObject obj = QJsonDocument::fromJson(packets.first()->jsonData().toByteArray()).object();
+    qDeleteAll(packets);
+    // Only packets of passages (idbegin -1)
+    if(!obj.contains("datasummary"))
+        return -1;
+    return obj.value("datasummary").toObject().value("idend").toVariant().toLongLong();
+}
+
+}
+
 PackagerService::PackagerService(QObject *parent) :
     PackagerInterface(parent)
 {
@@ -84,12 +215,16 @@ QMap<QString, QByteArray> PackagerService::getAll()
     collectorId = RFIDMonitor::instance()->idCollector();
     collectorName = RFIDMonitor::instance()->collectorName();
 
-    QList<Packet *> packetListNew = PacketDAO::instance()->getByMatch("status", (int)Packet::Status::KNew);
+    SelectQuery<Packet> select;
+    select.columns({Packet::Column::KHash, Packet::Column::KJsonData})
+            .where(Packet::Column::KStatus, (int)Packet::Status::KNew)
+            .orderBy(Packet::Column::KIdBegin);
+    QList<Packet *> packetListNew = PacketDAO::instance()->select(select);
 
     QMap<QString, QByteArray> packets;
     // insert in the packets all data with KNew status
     foreach (Packet *p, packetListNew) {
-        packets.insert(p->md5hash().toString(), p->jsonData().toByteArray());
+        packets.insert(QString(p->hash().toByteArray().toHex()), p->jsonData().toByteArray());
     }
 
 //----  TEMP - DON'T REMOVE
@@ -98,32 +233,62 @@ QMap<QString, QByteArray> PackagerService::getAll()
 //        QList<Packet *> packetListPending = PacketDAO::instance()->getByMatch("status", (int)Packet::Status::KConfimationPending);
 //        // Alson insert the packets with KConfirmationPending status to retry send it to the server.
 //        foreach (Packet *pa, packetListPending) {
-//            packets.insert(pa->md5hash().toString(), pa->jsonData().toByteArray());
+//            packets.insert(QString(pa->hash().toByteArray().toHex()), pa->jsonData().toByteArray());
 //        }
 //    }
 
+    PacketDAO::instance()->updateStatus(packets.keys(), (int)Packet::Status::KConfimationPending);
     foreach (Packet *pack, packetListNew) {
-        pack->setStatus((int)Packet::Status::KConfimationPending);
-        PacketDAO::instance()->updateObject(pack);
         pack->deleteLater();
     }
 
     return packets;
 }
 
+int PackagerService::exportPackets(QIODevice *device, QStringList &hashes)
+{
+    return PacketDAO::instance()->exportPackets((int)Packet::Status::KNew, device, hashes);
+}
+
+void PackagerService::markExported(const QStringList &hashes)
+{
+    PacketDAO::instance()->updateStatus(hashes, (int)Packet::Status::KConfimationPending);
+}
+
 void PackagerService::update(const QList<QString> &list)
 {
+    static PersistenceInterface *persistence = 0;
+    if(!persistence){
+        persistence = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
+    }
+
     foreach (QString hash, list) {
-        QList<Packet *> packetList = PacketDAO::instance()->getByMatch("md5hash", hash);
-        QList<int> idList;
+        // The server acknowledges the packets by the hex representation of the digest
+        SelectQuery<Packet> select;
+        select.columns({Packet::Column::KHash, Packet::Column::KJsonData})
+                .where(Packet::Column::KHash, QByteArray::fromHex(hash.toLatin1()));
+        QList<Packet *> packetList = PacketDAO::instance()->select(select);
         foreach (Packet *packet, packetList) {
             QJsonObject obj = QJsonDocument::fromJson(packet->jsonData().toByteArray()).object();
             json::SynchronizationPacket syncPacket;
             syncPacket.read(obj);
+
+            /* The acknowledged readings are removed through the default persistence service, so any backend
+             * (SQLite, segment log) can release them. The packet is removed after its data.
+             */
+            QList<Rfiddata *> acked;
             foreach (const json::Data &data, syncPacket.dataContent().data()) {
-                idList.append(data.id());
+                Rfiddata *rfiddata = new Rfiddata;
+                rfiddata->setId(data.id());
+                acked.append(rfiddata);
             }
-            PacketDAO::instance()->deleteRFIDDataList(packet->md5hash().toString(),idList);
+            // A packet of passages has no readings, they were deleted when it was stored
+            if(!acked.isEmpty())
+                persistence->deleteObjectList(acked);
+            qDeleteAll(acked);
+
+            PacketDAO::instance()->deleteObject(packet);
+            packet->deleteLater();
         }
     }
 }
@@ -135,67 +300,161 @@ void PackagerService::generatePackets()
     //    Logger::instance()->writeRecord(Logger::severity_level::debug, "PackagerService", Q_FUNC_INFO, "Generating packets...");
     static PersistenceInterface *persistence = 0;
     if(!persistence){
-        persistence = qobject_cast<PersistenceInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KPersister));
+        persistence = RFIDMonitor::instance()->defaultService<PersistenceInterface>();
     }
-    QList<Rfiddata *> data = persistence->getObjectList("sync", QVariant(Rfiddata::KNotSynced), 0);
-    int stagesCount = data.size()%100;
+    storePassages(persistence);
+    // The passages replace the readings on the uplink: the readings wait for their passage, see PassageDetector
+    if(!PassageDetector::instance()->rawReads())
+        return;
 
+    // The backlog is read in batches of consecutive ids, a long offline period is not loaded in memory at once
+    SelectQuery<Rfiddata> backlog;
+    backlog.where(Rfiddata::Column::KSync, Rfiddata::KNotSynced)
+            .orderBy(Rfiddata::Column::KId)
+            .limit(KBatchSize);
 
-    int currentIndex = 0;
-    QMap<QString, QByteArray> package;
-    for(int stage = 0; stage < stagesCount; stage++){
+    QList<Rfiddata *> data = persistence->select(backlog, 0);
+    if(data.isEmpty())
+        return;
 
-        json::SynchronizationPacket synPacket;
+    collectorId = RFIDMonitor::instance()->idCollector();
+    collectorName = RFIDMonitor::instance()->collectorName();
 
-        synPacket.setMacAddress(getMacAddress());
-        synPacket.setName(collectorName);
-        synPacket.setId(collectorId);
+    // The identification of the collector is the same for all packets, serialize it only once
+    QJsonObject header;
+    header["id"] = collectorId;
+    header["macaddress"] = getMacAddress();
+    header["name"] = collectorName;
+
+    PacketBuilder builder;
+    builder.header = QJsonDocument(header).toJson(QJsonDocument::Compact);
+    builder.algorithm = Digest::algorithmFromName(RFIDMonitor::instance()->packetDigest());
+
+    qlonglong packagedId = lastPackagedId();
+
+    while(!data.isEmpty()){
+        // A full batch means there may be more readings waiting
+        bool full = (data.size() == KBatchSize);
+
+        // Readings left not synchronized by a crash after the commit of their packets are only marked
+        QList<Rfiddata *> packaged;
+        while(!data.isEmpty() && data.first()->id().toLongLong() <= packagedId)
+            packaged.append(data.takeFirst());
+        if(!packaged.isEmpty()){
+            foreach (Rfiddata *rf, packaged) {
+                rf->setSync(Rfiddata::KSynced);
+            }
+            persistence->updateObjectList(packaged);
+            qDeleteAll(packaged);
+            if(data.isEmpty()){
+                if(full)
+                    data = persistence->select(backlog, 0);
+                continue;
+            }
+        }
 
-        json::DataSummary summary;
-        QList<json::Data> rfidList;
-        for(; currentIndex < data.size()/(stagesCount/(stage+1)); currentIndex++){
-            data.at(currentIndex)->setSync(Rfiddata::KSynced);
-            json::Data d;
-            d.setId(data[currentIndex]->id().toInt());
-            d.setIdcollectorPoint(data[currentIndex]->idpontocoleta().toInt());
-            d.setIdantena(data[currentIndex]->idantena().toInt());
-            d.setIdentificationCode(data[currentIndex]->identificationcode().toLongLong());
-            d.setApplicationCode(data[currentIndex]->applicationcode().toLongLong());
-            d.setDateTime(data[currentIndex]->datetime().toDateTime());
-            rfidList.append(d);
+        // Split the batch in chunks of consecutive ids, each chunk becomes one packet
+        QList< QList<Rfiddata *> > chunks;
+        for(int i = 0; i < data.size(); i += KPacketSize){
+            chunks.append(data.mid(i, KPacketSize));
         }
-        summary.setData(rfidList);
-        // In this section we create the md5 hash of the data array
-        QJsonObject jsonSummary;
-        summary.write(jsonSummary);
-        QByteArray byteData(QJsonDocument(jsonSummary["data"].toArray()).toJson());
-        QByteArray hash = QCryptographicHash::hash(byteData, QCryptographicHash::Md5).toHex();
-        summary.setMd5diggest(hash);
-        // Set te summary for the synchronizationPacket
-        synPacket.setDataContent(summary);
-
-        QJsonObject packet;
-        synPacket.write(packet);
-        // The packet must be sent as a bytearray and the packet itself is identified by an md5 hash
-        QByteArray document = QJsonDocument(packet).toJson();
-
-        package.insert(QString(hash), document);
+
+        /* The chunks are independent, so after a long offline period they are serialized and hashed on the global thread pool.
+         * blockingMapped keeps the results in the same order of the chunks.
+         */
+        QList<BuiltPacket> builtPackets;
+        if(chunks.size() == 1){
+            builtPackets.append(builder(chunks.first()));
+        }else{
+            builtPackets = QtConcurrent::blockingMapped< QList<BuiltPacket> >(chunks, builder);
+        }
+
+        // This thread is the only writer: the packets are committed in order, then the data is marked as synchronized
+        QList<Packet *> packets;
+        foreach (const BuiltPacket &built, builtPackets) {
+            Packet *pack = new Packet;
+            pack->setHash(built.hash);
+            pack->setDateTime(QDateTime::currentDateTime());
+            pack->setIdBegin(built.idBegin);
+            pack->setItemCount(built.itemCount);
+            pack->setJsonData(built.document);
+            pack->setStatus((int)Packet::Status::KNew);
+            packets.append(pack);
+        }
+
+        bool committed = PacketDAO::instance()->insertObjectList(packets);
+        if(committed){
+            foreach (Rfiddata *rf, data) {
+                rf->setSync(Rfiddata::KSynced);
+            }
+            persistence->updateObjectList(data);
+        }
+        qDeleteAll(packets);
+
+        qDeleteAll(data);
+        data.clear();
+        if(committed && full)
+            data = persistence->select(backlog, 0);
+    }
+}
+
+void PackagerService::storePassages(PersistenceInterface *persistence)
+{
+    QJsonArray passages;
+    QList<qlonglong> ids;
+    if(!PassageDetector::instance()->takeClosed(passages, ids))
+        return;
+
+    // The passages follow the same digest rule of the readings, and are serialized once too
+    QByteArray hash;
+    QByteArray passageBytes = serializeData(passages, Digest::algorithmFromName(RFIDMonitor::instance()->packetDigest()), hash);
+    QJsonObject header;
+    header["id"] = RFIDMonitor::instance()->idCollector();
+    header["macaddress"] = getMacAddress();
+    header["name"] = RFIDMonitor::instance()->collectorName();
+    header["md5diggest"] = QString(hash.toHex());
+    // The header is a complete object, the passages are appended before its closing brace
+    QByteArray document(QJsonDocument(header).toJson(QJsonDocument::Compact));
+    document.chop(1);
+    document.append(",\"passages\":");
+    document.append(passageBytes);
+    document.append('}');
+
+    Packet *pack = new Packet;
+    pack->setHash(hash);
+    pack->setDateTime(QDateTime::currentDateTime());
+    // Out of the range of the reading ids, see lastPackagedId()
+    pack->setIdBegin(-1);
+    pack->setItemCount(passages.size());
+    pack->setJsonData(document);
+    pack->setStatus((int)Packet::Status::KNew);
+
+    bool committed = PacketDAO::instance()->insertObjectList(QList<Packet *>() << pack);
+    if(!committed){
+        // The same passages, rebuilt by PassageDetector::recover() after a crash before their readings were deleted
+        SelectQuery<Packet> existing;
+        existing.columns({Packet::Column::KHash})
+                .where(Packet::Column::KHash, hash);
+        QList<Packet *> found = PacketDAO::instance()->select(existing);
+        committed = !found.isEmpty();
+        qDeleteAll(found);
     }
+    delete pack;
 
-    persistence->updateObjectList(data);
-    QMap<QString, QByteArray>::iterator it;
-    for(it = package.begin(); it != package.end(); it++){
-        Packet pack;
-        pack.setMd5hash(it.key());
-        pack.setDateTime(QDateTime::currentDateTime());
-        pack.setIdBegin(0);
-        pack.setItemCount(10);
-        pack.setJsonData(it.value());
-        pack.setStatus((int)Packet::Status::KNew);
-        PacketDAO::instance()->insertObject(&pack);
+    if(!committed){
+        PassageDetector::instance()->putBack(passages, ids);
+        return;
     }
 
-    foreach (Rfiddata *rf, data) {
-        rf->deleteLater();
+    // The readings are in the passages now
+    if(!ids.isEmpty()){
+        QList<Rfiddata *> fused;
+        foreach (qlonglong id, ids) {
+            Rfiddata *rfiddata = new Rfiddata;
+            rfiddata->setId(id);
+            fused.append(rfiddata);
+        }
+        persistence->deleteObjectList(fused);
+        qDeleteAll(fused);
     }
 }
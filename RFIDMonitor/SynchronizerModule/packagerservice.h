@@ -45,8 +45,16 @@ public:
     QMap<QString, QByteArray> getAll();
     void update(const QList<QString> &list);
     void generatePackets();
+    int exportPackets(QIODevice *device, QStringList &hashes);
+    void markExported(const QStringList &hashes);
 
 private:
+    /*!
+     * \brief storePassages stores the passages closed by the PassageDetector in a packet, which is sent and acknowledged like the others.
+     * Without the raw readings, the readings of the passages are deleted once the packet is stored.
+     */
+    void storePassages(PersistenceInterface *persistence);
+
     QMutex m_mutex;
     int collectorId;
     QString collectorName;
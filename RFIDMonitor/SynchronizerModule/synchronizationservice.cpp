@@ -23,15 +23,12 @@
 **
 ****************************************************************************/
 
-#include <QtConcurrent>
 #include <QJsonDocument>
 #include <QJsonObject>
 
-#include <future>
-#include <functional>
-
 #include <rfidmonitor.h>
 #include <logger.h>
+#include <core/executor.h>
 
 #include <json/nodejsmessage.h>
 #include <json/synchronizationpacket.h>
@@ -48,8 +45,8 @@ void SynchronizationService::readyRead()
     static PackagerInterface *packager = 0;
     static CommunicationInterface *communitacion = 0;
     if(!packager || !communitacion) {
-        packager = qobject_cast<PackagerInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KPackager));
-        communitacion = qobject_cast<CommunicationInterface *>(RFIDMonitor::instance()->defaultService(ServiceType::KCommunicator));
+        packager = RFIDMonitor::instance()->defaultService<PackagerInterface>();
+        communitacion = RFIDMonitor::instance()->defaultService<CommunicationInterface>();
     }
     if(packager /*&& !m_timer.remainingTime()*/) {
 
@@ -63,21 +60,18 @@ void SynchronizationService::readyRead()
                 Logger::instance()->writeRecord(Logger::severity_level::debug, "synchronizer", Q_FUNC_INFO, QString("Sending %1 Packets to server").arg(allData.size()));
                 for(i = allData.begin(); i != allData.end(); ++i){
 
+                    QJsonObject packet = QJsonDocument::fromJson(QString(i.value()).toLatin1()).object();
                     json::NodeJSMessage answer;
-                    answer.setType("DATA");
+                    // A packet of passages (see PassageDetector) is acknowledged with ACK-DATA too
+                    answer.setType(packet.contains("passages") ? "PASSAGE" : "DATA");
                     answer.setDateTime(QDateTime::currentDateTime());
-                    answer.setJsonData(QJsonDocument::fromJson(QString(i.value()).toLatin1()).object());
+                    answer.setJsonData(packet);
                     QJsonObject jsonAnswer;
                     answer.write(jsonAnswer);
 
-#ifdef CPP_11_ASYNC
-                    /*C++11 std::async Version*/
-                    std::function<void (QByteArray)> sendMessage = std::bind(&CommunicationInterface::sendMessage, communitacion, std::placeholders::_1);
-                    std::async(std::launch::async, sendMessage, QJsonDocument(jsonAnswer).toJson());
-#else
-                    /*Qt Concurrent Version*/
-                    QtConcurrent::run(communitacion, &CommunicationInterface::sendMessage, QJsonDocument(jsonAnswer).toJson());
-#endif
+                    QByteArray message = QJsonDocument(jsonAnswer).toJson();
+                    // The packet is already waiting for confirmation and is not sent again, so it never goes to the drop oldest "comm" queue
+                    Executor::instance()->submit("uplink", [message](){ communitacion->sendMessage(message); });
                 }
             }else{
                 Logger::instance()->writeRecord(Logger::severity_level::debug, "synchronizer", Q_FUNC_INFO, QString("Packager is not working!"));
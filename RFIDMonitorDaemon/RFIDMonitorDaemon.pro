@@ -23,10 +23,12 @@ DEFINES += DEBUG_LOGGER
 
 SOURCES += main.cpp \
     rfidmonitordaemon.cpp \
-    configmanager.cpp
+    configmanager.cpp \
+    livesubscription.cpp
 HEADERS += \
     rfidmonitordaemon.h \
-    configmanager.h
+    configmanager.h \
+    livesubscription.h
 
 
 unix: {
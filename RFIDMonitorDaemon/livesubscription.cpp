@@ -0,0 +1,116 @@
+/****************************************************************************
+**
+** www.celtab.org.br
+**
+** Copyright (C) 2013, 2014
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**
+** This file is part of the RFIDMonitor project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+#include "livesubscription.h"
+
+namespace {
+// Defaults and limits of the options of SUBSCRIBE-LIVE
+const int KDefaultInterval = 200;
+const int KMinInterval = 50;
+const int KDefaultCapacity = 256;
+const int KMaxCapacity = 4096;
+}
+
+LiveSubscription::LiveSubscription(const QJsonObject &options, QObject *parent) :
+    QObject(parent),
+    m_sequence(0),
+    m_dropped(0)
+{
+#if QT_VERSION < 0x050200
+    m_interval = options.contains("interval") ? options.value("interval").toVariant().toInt() : KDefaultInterval;
+    m_capacity = options.contains("capacity") ? options.value("capacity").toVariant().toInt() : KDefaultCapacity;
+#else
+    m_interval = options.value("interval").toInt(KDefaultInterval);
+    m_capacity = options.value("capacity").toInt(KDefaultCapacity);
+#endif // QT_VERSION < 0x050200
+    m_coalesce = options.value("coalesce").toBool(true);
+    m_interval = qMax(m_interval, KMinInterval);
+    m_capacity = qBound(1, m_capacity, KMaxCapacity);
+
+    m_timer.setInterval(m_interval);
+    connect(&m_timer, SIGNAL(timeout()), SLOT(flush()));
+    m_timer.start();
+}
+
+QJsonObject LiveSubscription::options() const
+{
+    QJsonObject obj;
+    obj.insert("interval", m_interval);
+    obj.insert("coalesce", m_coalesce);
+    obj.insert("capacity", m_capacity);
+    return obj;
+}
+
+void LiveSubscription::append(const QJsonArray &reads, int dropped)
+{
+    m_dropped += dropped;
+
+    for(int i = 0; i < reads.size(); i++){
+        QJsonObject read(reads.at(i).toObject());
+
+        QString key;
+        if(m_coalesce){
+            key = QString("%1/%2").arg(read.value("identificationcode").toVariant().toLongLong()).arg(read.value("idantena").toVariant().toInt());
+            QHash<QString, QJsonObject>::iterator it = m_reads.find(key);
+            if(it != m_reads.end()){
+                // The latest reading keeps the place of the first one and counts both
+                read.insert("count", it.value().value("count").toVariant().toInt() + 1);
+                it.value() = read;
+                continue;
+            }
+            read.insert("count", 1);
+        }else{
+            key = QString::number(m_sequence++);
+        }
+
+        if(m_order.size() == m_capacity){
+            m_reads.remove(m_order.takeFirst());
+            m_dropped++;
+        }
+        m_order.append(key);
+        m_reads.insert(key, read);
+    }
+}
+
+void LiveSubscription::flush()
+{
+    if(m_order.isEmpty() && m_dropped == 0)
+        return;
+
+    QJsonArray reads;
+    foreach (QString key, m_order) {
+        reads.append(m_reads.value(key));
+    }
+
+    QJsonObject data;
+    data.insert("reads", reads);
+    data.insert("dropped", m_dropped);
+
+    m_order.clear();
+    m_reads.clear();
+    m_dropped = 0;
+
+    emit ready(data);
+}
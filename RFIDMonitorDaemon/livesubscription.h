@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** www.celtab.org.br
+**
+** Copyright (C) 2013, 2014
+**                     Luis Valdes <luisvaldes88@gmail.com>
+**
+** This file is part of the RFIDMonitor project
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; version 2
+** of the License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**
+****************************************************************************/
+
+#ifndef LIVESUBSCRIPTION_H
+#define LIVESUBSCRIPTION_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * @brief The LiveSubscription class holds the LIVE-READ messages for one subscriber (the server or the deskApp) and sends them at the rate it asked for.
+ *
+ * The readings of the RFIDMonitor are queued in a ring of "capacity" entries, a full ring drops the oldest reading, so a slow subscriber never
+ * slows down the RFIDMonitor or the other subscriber. With "coalesce" a tag read again by the same antenna before the next message
+ * replaces its previous reading, which only counts it. Every "interval" milliseconds the queued readings are given by ready().
+ */
+class LiveSubscription : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief LiveSubscription applies the options of a SUBSCRIBE-LIVE message: "interval", "coalesce" and "capacity". The missing ones keep the defaults.
+     */
+    explicit LiveSubscription(const QJsonObject &options, QObject *parent = 0);
+
+    /**
+     * @brief options returns the options in use, sent back in the ACK-SUBSCRIBE-LIVE.
+     */
+    QJsonObject options() const;
+
+    /**
+     * @brief append queues the readings of a LIVE-READ message from the RFIDMonitor. \a dropped is the number of readings the RFIDMonitor already dropped.
+     */
+    void append(const QJsonArray &reads, int dropped);
+
+signals:
+    /**
+     * @brief ready gives the data of the LIVE-READ message to be sent to the subscriber.
+     */
+    void ready(const QJsonObject &data);
+
+private slots:
+    void flush();
+
+private:
+    int m_interval;
+    bool m_coalesce;
+    int m_capacity;
+
+    // The readings in the order they arrived, by key (code and antenna with coalesce, a sequence number without)
+    QStringList m_order;
+    QHash<QString, QJsonObject> m_reads;
+    quint64 m_sequence;
+    int m_dropped;
+    QTimer m_timer;
+};
+
+#endif // LIVESUBSCRIPTION_H
@@ -39,11 +39,13 @@
 #include "CoreLibrary/json/rfidmonitorsettings.h"
 
 #include "rfidmonitordaemon.h"
+#include "livesubscription.h"
 
 
 RFIDMonitorDaemon::RFIDMonitorDaemon(QObject *parent) :
     QObject(parent),
     m_localServer(0),
+    ipcConnection(0),
     m_tcpSocket(0),
     m_tcpAppSocket(0),
     isConnected(false)
@@ -79,6 +81,7 @@ RFIDMonitorDaemon::RFIDMonitorDaemon(QObject *parent) :
     connect(m_tcpAppSocket, &QTcpSocket::disconnected,
             ([=] () {
         qDebug() <<  "DeskApp Connection Closed";
+        unsubscribeLive(m_tcpAppSocket);
         if(!m_udpSocket->bind(QHostAddress::Any, 9999)){
             qDebug() <<  QString("Couldn't listening broadcast");
         };
@@ -133,6 +136,7 @@ void RFIDMonitorDaemon::ipcNewConnection()
     connect(ipcConnection, &QLocalSocket::disconnected,
             [this]() {
         ipcConnection = 0;
+        m_ipcBuffer.clear();
         qDebug() <<  "RFIDMonitor Disconnected";
     });
     connect(ipcConnection, SIGNAL(disconnected()), ipcConnection, SLOT(deleteLater()));
@@ -155,6 +159,7 @@ void RFIDMonitorDaemon::tcpConnected()
 
 void RFIDMonitorDaemon::tcpDisconnected()
 {
+    unsubscribeLive(m_tcpSocket);
     if(isConnected){
         QJsonObject obj;
         obj.insert("full", QJsonValue(false));
@@ -339,6 +344,26 @@ void RFIDMonitorDaemon::routeTcpMessage()
 
             ipcSendMessage(buildMessage(command, "READER-COMMAND").toJson());
 
+        }else if (messageType == "TAG-QUERY" || messageType == "TAG-FILTER") {
+
+            // Like READER-COMMAND, the 'sender' field tells where the TAG-RESULT or ACK-TAG-FILTER must go (see routeIpcMessage)
+            QJsonObject query(nodeMessage.jsonData());
+            if(connection->objectName() == "server")
+                query.insert("sender", QString("server"));
+            else
+                query.insert("sender", QString("app"));
+
+            ipcSendMessage(buildMessage(query, messageType).toJson());
+
+        }else if (messageType == "SUBSCRIBE-LIVE") {
+
+            // Each connection has its own rate and ring, see LiveSubscription
+            subscribeLive(connection, nodeMessage.jsonData());
+
+        }else if (messageType == "UNSUBSCRIBE-LIVE") {
+
+            unsubscribeLive(connection);
+
         }else if (messageType == "NEW-CONFIG") {
 
             QJsonObject newConfig(nodeMessage.jsonData());
@@ -416,11 +441,21 @@ void RFIDMonitorDaemon::routeTcpMessage()
 
 /*
  * This function works pretty much like routTcpMessage only that this one interpretes message from RFIDMonitor and don't verify packages size.
- * it only tries to interpret data just arrived.
+ * The messages are JSON documents one after the other: a document not complete yet waits for more data,
+ * and the documents that arrive together (e.g. a LIVE-READ and a DATA) are split and interpreted one by one.
  */
 void RFIDMonitorDaemon::routeIpcMessage()
 {
-    QByteArray message = ipcConnection->readAll();
+    m_ipcBuffer.append(ipcConnection->readAll());
+
+    // A message cut anywhere stays in the buffer until the rest arrives
+    QByteArray message;
+    while(!(message = json::NodeJSMessage::takeDocument(m_ipcBuffer)).isEmpty())
+        handleIpcMessage(message);
+}
+
+void RFIDMonitorDaemon::handleIpcMessage(const QByteArray &message)
+{
     json::NodeJSMessage nodeMessage;
 
     nodeMessage.read(QJsonDocument::fromJson(message).object());
@@ -450,6 +485,10 @@ void RFIDMonitorDaemon::routeIpcMessage()
 
         m_configManager->restartNetwork();
 
+        // A restarted RFIDMonitor starts without the live stream, the subscribers are still here
+        if(!m_liveSubscriptions.isEmpty())
+            ipcSendMessage(buildMessage(QJsonObject(), "SUBSCRIBE-LIVE").toJson());
+
     }else if (messageType == "READER-RESPONSE") {
         QJsonObject command(nodeMessage.jsonData());
         /*
@@ -464,6 +503,13 @@ void RFIDMonitorDaemon::routeIpcMessage()
         else
             tcpSendMessage(m_tcpAppSocket, message);
 
+    }else if (messageType == "TAG-RESULT" || messageType == "ACK-TAG-FILTER") {
+        // The answer of a TAG-QUERY or TAG-FILTER goes back to who asked, see routeTcpMessage (messageType == "TAG-QUERY")
+        if(nodeMessage.jsonData().value("sender").toString() == "server")
+            tcpSendMessage(m_tcpSocket, message);
+        else
+            tcpSendMessage(m_tcpAppSocket, message);
+
     }else if (messageType == "DATA"){
         /*
          * A Data message means that the RFIDMonitor is trying to sync some data into the server. So, it just send this message to the server.
@@ -473,6 +519,17 @@ void RFIDMonitorDaemon::routeIpcMessage()
         // Only a node.js server receives DATA messages.
         tcpSendMessage(m_tcpSocket, message);
 
+    }else if (messageType == "LIVE-READ"){
+        // Queued for each subscriber, which sends them at its own rate
+        QJsonObject live(nodeMessage.jsonData());
+        foreach (LiveSubscription *subscription, m_liveSubscriptions) {
+            subscription->append(live.value("reads").toArray(), live.value("dropped").toVariant().toInt());
+        }
+
+    }else if (messageType == "PASSAGE"){
+        // The passages detected by the collector, like DATA they go only to the server
+        tcpSendMessage(m_tcpSocket, message);
+
     }else if (messageType == "STOPPED"){
         qDebug() << "STOPPED";
         m_process.kill();
@@ -498,6 +555,35 @@ void RFIDMonitorDaemon::routeIpcMessage()
     }
 }
 
+void RFIDMonitorDaemon::subscribeLive(QTcpSocket *connection, const QJsonObject &options)
+{
+    bool first = m_liveSubscriptions.isEmpty();
+    // A new SUBSCRIBE-LIVE from the same connection changes its options
+    delete m_liveSubscriptions.take(connection);
+
+    LiveSubscription *subscription = new LiveSubscription(options, this);
+    connect(subscription, &LiveSubscription::ready, [=](const QJsonObject &data){
+        tcpSendMessage(connection, buildMessage(data, "LIVE-READ").toJson());
+    });
+    m_liveSubscriptions.insert(connection, subscription);
+
+    if(first && ipcConnection)
+        ipcSendMessage(buildMessage(QJsonObject(), "SUBSCRIBE-LIVE").toJson());
+
+    tcpSendMessage(connection, buildMessage(subscription->options(), "ACK-SUBSCRIBE-LIVE").toJson());
+}
+
+void RFIDMonitorDaemon::unsubscribeLive(QTcpSocket *connection)
+{
+    LiveSubscription *subscription = m_liveSubscriptions.take(connection);
+    if(!subscription)
+        return;
+    delete subscription;
+
+    if(m_liveSubscriptions.isEmpty() && ipcConnection)
+        ipcSendMessage(buildMessage(QJsonObject(), "UNSUBSCRIBE-LIVE").toJson());
+}
+
 void RFIDMonitorDaemon::readDatagrams()
 {
     QByteArray datagram;
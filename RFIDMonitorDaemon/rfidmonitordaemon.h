@@ -35,12 +35,14 @@
 #include <QFile>
 #include <QUdpSocket>
 #include <QTimer>
+#include <QHash>
 
 #include "configmanager.h"
 
 class QLocalServer;
 class QTcpSocket;
 class QLocalSocket;
+class LiveSubscription;
 
 class DaemonLogger
 {
@@ -198,6 +200,25 @@ private:
 
     ConfigManager *m_configManager;
 
+    // Subscribers of the live stream, by connection, and the part of an IPC message not received yet
+    QHash<QTcpSocket *, LiveSubscription *> m_liveSubscriptions;
+    QByteArray m_ipcBuffer;
+
+    /**
+     * @brief handleIpcMessage interprets one complete message from the RFIDMonitor, see routeIpcMessage().
+     */
+    void handleIpcMessage(const QByteArray &message);
+
+    /**
+     * @brief subscribeLive starts (or replaces) the live stream of the connection. The RFIDMonitor is told to start the stream with the first subscriber.
+     */
+    void subscribeLive(QTcpSocket *connection, const QJsonObject &options);
+
+    /**
+     * @brief unsubscribeLive stops the live stream of the connection. The RFIDMonitor is told to stop the stream when the last subscriber leaves.
+     */
+    void unsubscribeLive(QTcpSocket *connection);
+
     /**
      * @brief buildMessage is used to build a JSON document based on protocol definition. The protocol looks like this:
      * \code
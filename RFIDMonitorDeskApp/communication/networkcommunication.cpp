@@ -330,6 +330,20 @@ void NetworkCommunication::sendFullRead(bool full)
     sendData(m_tcpSocket, "FULL-READ", dataObj);
 }
 
+void NetworkCommunication::subscribeLive(int interval, bool coalesce)
+{
+    QJsonObject dataObj;
+    dataObj.insert("interval", interval);
+    dataObj.insert("coalesce", coalesce);
+
+    sendData(m_tcpSocket, "SUBSCRIBE-LIVE", dataObj);
+}
+
+void NetworkCommunication::unsubscribeLive()
+{
+    sendData(m_tcpSocket, "UNSUBSCRIBE-LIVE", QJsonObject());
+}
+
 void NetworkCommunication::tcpDataAvailable()
 {
 //    SystemMessagesWidget::instance()->writeMessage(
@@ -377,6 +391,14 @@ void NetworkCommunication::tcpDataAvailable()
                 ackUnknownReceived(dataObj);
             }else if(type == "ACK-NEW-CONFIG"){
                 ackNewConfig(dataObj);
+            }else if(type == "LIVE-READ"){
+                emit newLiveReads(dataObj.value("reads").toArray(), dataObj.value("dropped").toVariant().toInt());
+            }else if(type == "ACK-SUBSCRIBE-LIVE"){
+                SystemMessagesWidget::instance()->writeMessage(
+                            tr("Live stream subscribed: interval %1 ms.").arg(dataObj.value("interval").toVariant().toInt()),
+                            SystemMessagesWidget::KDebug,
+                            SystemMessagesWidget::KOnlyLogfile
+                            );
             }else{
                 SystemMessagesWidget::instance()->writeMessage(
                             tr("Data type invalid."),
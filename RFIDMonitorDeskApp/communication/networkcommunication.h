@@ -37,6 +37,7 @@
 #include <QTimer>
 #include <QMap>
 #include <QJsonObject>
+#include <QJsonArray>
 
 #include "settings.h"
 
@@ -196,6 +197,18 @@ public:
 
     void sendFullRead(bool full);
 
+    /**
+     * @brief subscribeLive asks the rasp for the live stream of the readings, at most one LIVE-READ message every interval milliseconds.
+     * @param interval is the minimum time between two messages.
+     * @param coalesce true to receive only the latest reading of a tag by antenna in each message.
+     */
+    void subscribeLive(int interval, bool coalesce);
+
+    /**
+     * @brief unsubscribeLive stops the live stream of the readings.
+     */
+    void unsubscribeLive();
+
 private slots:
     /**
      * @brief tcpDataAvailable receives notification from QTcpSocket that exists new
@@ -286,6 +299,13 @@ signals:
      */
     void currentConfigStatusFromRasp(QJsonObject obj);
 
+    /**
+     * @brief newLiveReads emmited when a LIVE-READ message is received.
+     * @param reads are the readings, each one with identificationcode, idantena, datetime and, if coalesced, count.
+     * @param dropped is the number of readings dropped since the last message because the stream was too fast.
+     */
+    void newLiveReads(QJsonArray reads, int dropped);
+
 };
 
 #endif // NETWORKCOMMUNICATION_H